@@ -0,0 +1,212 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * widget_microbench.cpp
+ *
+ * Google Benchmark cases for the small hot paths of the widget:
+ * configuration snapshots, end station configuration records, stream format
+ * decoding, list row formatting and notification handling.
+ */
+
+#include <vector>
+#include <benchmark/benchmark.h>
+#include "config_snapshot.h"
+#include "stream_format.h"
+#include "string_pool.h"
+#include "end_station_list.h"
+#include "notification_coalescer.h"
+#include "pending_command_table.h"
+
+static const uint64_t base_entity_id = 0x001b92fffe000000ULL;
+static const uint64_t base_mac = 0x001b92000000ULL;
+
+// a mix of stream format values so the decode does not see one value only
+static const uint64_t stream_formats[] = {0x0205022002006000ULL, 0x00a0040240000200ULL, 0x0205022000806000ULL};
+
+static config_snapshot build_snapshot(unsigned int count)
+{
+    config_builder builder(end_station_configuration(wxT("AVB Interface"), base_entity_id, wxT("Stage Box"),
+                                                     base_mac, wxT("1.2.3"), 48000));
+    for(unsigned int i = 0; i < count; i++)
+    {
+        stream_configuration_details details;
+        details.stream_name = string_pool::intern(wxString::Format("Stream %u", i));
+        details.channel_count = 8;
+        builder.add_stream(true, details);
+        builder.add_stream(false, details);
+    }
+    return builder.build();
+}
+
+static void BM_stream_configuration_fill(benchmark::State &state)
+{
+    unsigned int count = (unsigned int)state.range(0);
+    for(auto _ : state)
+    {
+        config_snapshot snapshot = build_snapshot(count);
+        benchmark::DoNotOptimize(snapshot.streams(true).data());
+    }
+    state.SetItemsProcessed(state.iterations() * count * 2);
+}
+BENCHMARK(BM_stream_configuration_fill)->Arg(8)->Arg(64)->Arg(512);
+
+static void BM_stream_configuration_lookup(benchmark::State &state)
+{
+    unsigned int count = (unsigned int)state.range(0);
+    config_snapshot snapshot = build_snapshot(count);
+
+    for(auto _ : state)
+    {
+        size_t total = 0;
+        for(unsigned int i = 0; i < count; i++)
+        {
+            const stream_configuration_details &details = snapshot.streams(true)[i];
+            total += details.get_stream_name().length() + details.channel_count;
+        }
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_stream_configuration_lookup)->Arg(8)->Arg(64)->Arg(512);
+
+static void BM_config_snapshot_edit(benchmark::State &state)
+{
+    // one changed input stream: the outputs, mappings and entity stay shared
+    unsigned int count = (unsigned int)state.range(0);
+    config_snapshot snapshot = build_snapshot(count);
+    unsigned int n = 0;
+
+    for(auto _ : state)
+    {
+        config_builder builder(snapshot);
+        builder.set_stream_channel_count(true, n % count, (n & 1) ? 2 : 8);
+        snapshot = builder.build();
+        n++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_config_snapshot_edit)->Arg(8)->Arg(512);
+
+static void BM_end_station_configuration_construct(benchmark::State &state)
+{
+    wxString name(wxT("AVB Interface"));
+    wxString default_name(wxT("Stage Box"));
+    wxString fw_ver(wxT("1.2.3"));
+    uint64_t n = 0;
+
+    for(auto _ : state)
+    {
+        end_station_configuration config(name, base_entity_id + n, default_name, base_mac + n, fw_ver, 48000);
+        benchmark::DoNotOptimize(config.get_entity_id_value());
+        n++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_end_station_configuration_construct);
+
+static void BM_stream_format_decode(benchmark::State &state)
+{
+    const size_t format_count = sizeof(stream_formats) / sizeof(stream_formats[0]);
+    size_t n = 0;
+
+    for(auto _ : state)
+    {
+        uint64_t format = stream_formats[n++ % format_count];
+        unsigned int channel_count = stream_format_channel_count(format);
+        benchmark::DoNotOptimize(stream_format_index(channel_count, 48000));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_stream_format_decode);
+
+static void BM_list_row_format(benchmark::State &state)
+{
+    entity_record record = entity_record();
+    record.name = string_pool::intern(wxT("Stage Box"));
+    record.fw_ver = string_pool::intern(wxT("1.2.3"));
+    record.interface_name = string_pool::intern(wxT("eth0"));
+    record.connection_status = 'C';
+    uint64_t n = 0;
+
+    for(auto _ : state)
+    {
+        // every column of a row, through the formatter OnGetItemText uses
+        record.entity_id = base_entity_id + n;
+        record.mac = base_mac + n;
+        size_t length = 0;
+        for(long column = 0; column < 6; column++)
+        {
+            length += end_station_list::format_cell(record, column).length();
+        }
+        benchmark::DoNotOptimize(length);
+        n++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_list_row_format);
+
+static void BM_notification_coalesce(benchmark::State &state)
+{
+    // a burst where each entity repeats the same notification several times
+    unsigned int entity_count = (unsigned int)state.range(0);
+    const unsigned int repeats = 8;
+    notification_coalescer coalescer(0);
+    std::vector<notification_record> records;
+
+    for(auto _ : state)
+    {
+        for(unsigned int r = 0; r < repeats; r++)
+        {
+            for(unsigned int i = 0; i < entity_count; i++)
+            {
+                coalescer.post(1, base_entity_id + i, 0x24, 5, 0, 0, NULL);
+            }
+        }
+        records.clear();
+        coalescer.flush_all(records);
+        benchmark::DoNotOptimize(records.data());
+    }
+    state.SetItemsProcessed(state.iterations() * entity_count * repeats);
+}
+BENCHMARK(BM_notification_coalesce)->Arg(16)->Arg(512);
+
+static void BM_pending_command_complete(benchmark::State &state)
+{
+    pending_command_table pending;
+    notification_record record = notification_record();
+    intptr_t id = 1;
+    size_t completed = 0;
+
+    for(auto _ : state)
+    {
+        record.notification_id = (void *)id++;
+        pending.add(record.notification_id, [&completed](const notification_record &) { completed++; });
+        pending.complete(record);
+    }
+    benchmark::DoNotOptimize(completed);
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_pending_command_complete);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,139 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * acmp_command_queue.cpp
+ *
+ */
+
+#include "acmp_command_queue.h"
+
+const char * acmp_command_name(acmp_command_type type)
+{
+    switch(type)
+    {
+        case ACMP_CONNECT_RX:
+            return "CONNECT_RX";
+        case ACMP_DISCONNECT_RX:
+            return "DISCONNECT_RX";
+        case ACMP_GET_RX_STATE:
+            return "GET_RX_STATE";
+        case AEM_GET_STREAM_INFO:
+            return "GET_STREAM_INFO";
+    }
+    return "UNKNOWN";
+}
+
+acmp_command_queue::acmp_command_queue(pending_command_table &pending, size_t max_in_flight)
+: m_pending(pending), m_max_in_flight(max_in_flight), m_in_flight(0)
+{
+}
+
+acmp_command_queue::~acmp_command_queue() {}
+
+void acmp_command_queue::set_sender(const id_allocator &next_id, const sender &send)
+{
+    m_next_id = next_id;
+    m_send = send;
+}
+
+void acmp_command_queue::set_reader(const reader &read)
+{
+    m_read = read;
+}
+
+void acmp_command_queue::enqueue(const acmp_command &command)
+{
+    // a state read already waiting to be sent covers this one too
+    if(command.type == ACMP_GET_RX_STATE && !m_queued_rx_state.insert(command.listener).second)
+        return;
+    if(command.type == AEM_GET_STREAM_INFO && !m_queued_stream_info.insert(command.listener).second)
+        return;
+
+    m_queue.push_back(command);
+    pump();
+}
+
+void acmp_command_queue::pump()
+{
+    while(!m_queue.empty() && m_in_flight.load(std::memory_order_acquire) < m_max_in_flight)
+    {
+        acmp_command command = m_queue.front();
+        m_queue.pop_front();
+        if(command.type == ACMP_GET_RX_STATE)
+            m_queued_rx_state.erase(command.listener);
+        else if(command.type == AEM_GET_STREAM_INFO)
+            m_queued_stream_info.erase(command.listener);
+
+        void *notification_id = m_next_id();
+        m_in_flight.fetch_add(1, std::memory_order_acq_rel);
+        m_pending.add(notification_id, [this, command](const notification_record &record)
+        {
+            on_complete(command, record);
+        });
+
+        // a response racing the failed send may already have completed it
+        if(m_send(command, notification_id) != 0 && m_pending.cancel(notification_id))
+        {
+            notification_record record = notification_record();
+            record.notification_type = send_failed_notification;
+            record.notification_id = notification_id;
+            record.cmd_status = send_failed_status;
+            on_complete(command, record);
+        }
+    }
+}
+
+void acmp_command_queue::on_complete(const acmp_command &command, const notification_record &record)
+{
+    acmp_result result = acmp_result();
+    result.command = command;
+    result.notification_type = record.notification_type;
+    result.status = record.cmd_status;
+
+    if(!m_read || m_read(result))
+    {
+        std::lock_guard<std::mutex> guard(m_result_lock);
+        m_results.push_back(result);
+    }
+    m_in_flight.fetch_sub(1, std::memory_order_acq_rel);
+}
+
+size_t acmp_command_queue::take_results(std::vector<acmp_result> &results)
+{
+    std::lock_guard<std::mutex> guard(m_result_lock);
+    size_t count = m_results.size();
+    results.insert(results.end(), m_results.begin(), m_results.end());
+    m_results.clear();
+    return count;
+}
+
+size_t acmp_command_queue::get_queued_count() const
+{
+    return m_queue.size();
+}
+
+size_t acmp_command_queue::get_in_flight_count() const
+{
+    return m_in_flight.load(std::memory_order_acquire);
+}
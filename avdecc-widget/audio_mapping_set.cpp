@@ -0,0 +1,133 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * audio_mapping_set.cpp
+ *
+ */
+
+#include <algorithm>
+#include "audio_mapping_set.h"
+
+audio_mapping_set::audio_mapping_set() {}
+
+audio_mapping_set::~audio_mapping_set() {}
+
+uint64_t audio_mapping_set::pack(const audio_mapping &map)
+{
+    return ((uint64_t)map.stream_index << 48) | ((uint64_t)map.stream_channel << 32) |
+           ((uint64_t)map.cluster_offset << 16) | (uint64_t)map.cluster_channel;
+}
+
+audio_mapping audio_mapping_set::unpack(uint64_t key)
+{
+    audio_mapping map;
+    map.stream_index = (uint16_t)(key >> 48);
+    map.stream_channel = (uint16_t)(key >> 32);
+    map.cluster_offset = (uint16_t)(key >> 16);
+    map.cluster_channel = (uint16_t)key;
+    return map;
+}
+
+bool audio_mapping_set::add(const audio_mapping &map)
+{
+    uint64_t key = pack(map);
+    std::vector<uint64_t>::iterator it = std::lower_bound(m_maps.begin(), m_maps.end(), key);
+    if(it != m_maps.end() && *it == key)
+        return false;
+
+    m_maps.insert(it, key);
+    return true;
+}
+
+bool audio_mapping_set::remove(const audio_mapping &map)
+{
+    uint64_t key = pack(map);
+    std::vector<uint64_t>::iterator it = std::lower_bound(m_maps.begin(), m_maps.end(), key);
+    if(it == m_maps.end() || *it != key)
+        return false;
+
+    m_maps.erase(it);
+    return true;
+}
+
+size_t audio_mapping_set::remove_stream_channel(uint16_t stream_index, uint16_t stream_channel)
+{
+    uint64_t first = ((uint64_t)stream_index << 48) | ((uint64_t)stream_channel << 32);
+    std::vector<uint64_t>::iterator begin = std::lower_bound(m_maps.begin(), m_maps.end(), first);
+    std::vector<uint64_t>::iterator end = std::lower_bound(begin, m_maps.end(), first + 0x100000000ULL);
+    size_t count = end - begin;
+    m_maps.erase(begin, end);
+    return count;
+}
+
+size_t audio_mapping_set::get_stream_channel(uint16_t stream_index, uint16_t stream_channel, std::vector<audio_mapping> &maps) const
+{
+    uint64_t first = ((uint64_t)stream_index << 48) | ((uint64_t)stream_channel << 32);
+    size_t count = 0;
+    for(std::vector<uint64_t>::const_iterator it = std::lower_bound(m_maps.begin(), m_maps.end(), first);
+        it != m_maps.end() && (*it >> 32) == (first >> 32); ++it)
+    {
+        maps.push_back(unpack(*it));
+        count++;
+    }
+    return count;
+}
+
+void audio_mapping_set::clear()
+{
+    m_maps.clear();
+}
+
+size_t audio_mapping_set::size() const
+{
+    return m_maps.size();
+}
+
+audio_mapping audio_mapping_set::at(size_t index) const
+{
+    return unpack(m_maps.at(index));
+}
+
+void audio_mapping_set::diff(const audio_mapping_set &from, const audio_mapping_set &to,
+                             std::vector<audio_mapping> &removed, std::vector<audio_mapping> &added)
+{
+    size_t i = 0;
+    size_t j = 0;
+    while(i < from.m_maps.size() || j < to.m_maps.size())
+    {
+        if(j == to.m_maps.size() || (i < from.m_maps.size() && from.m_maps[i] < to.m_maps[j]))
+        {
+            removed.push_back(unpack(from.m_maps[i++]));
+        }
+        else if(i == from.m_maps.size() || to.m_maps[j] < from.m_maps[i])
+        {
+            added.push_back(unpack(to.m_maps[j++]));
+        }
+        else
+        {
+            i++;
+            j++;
+        }
+    }
+}
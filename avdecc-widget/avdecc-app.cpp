@@ -21,21 +21,61 @@
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <cstdint>
+#include <thread>
 
 #include <wx/listbox.h>
 #include <wx/listctrl.h>
 #include <wx/notebook.h>
 #include <wx/utils.h>
+#include <wx/filedlg.h>
+#include <wx/config.h>
 
 #include "avdecc-app.h"
 #include "notif_log.h"
 #include "../sample.xpm"
 
+static const size_t acmp_max_in_flight = 16;
+static const uint32_t listener_poll_interval_ms = 5000;
+static const int counter_budget_per_second = 50;
+
+static const char *avb_interface_counter_names[] = {"LINK_UP", "LINK_DOWN", "FRAMES_TX", "FRAMES_RX",
+                                                    "RX_CRC_ERROR", "GPTP_GM_CHANGED"};
+static const char *stream_input_counter_names[] = {"MEDIA_LOCKED", "MEDIA_UNLOCKED", "STREAM_RESET", "SEQ_NUM_MISMATCH",
+                                                   "MEDIA_RESET", "TIMESTAMP_UNCERTAIN", "TIMESTAMP_VALID",
+                                                   "TIMESTAMP_NOT_VALID", "UNSUPPORTED_FORMAT", "LATE_TIMESTAMP",
+                                                   "EARLY_TIMESTAMP", "FRAMES_RX", "FRAMES_TX"};
+static const char *clock_domain_counter_names[] = {"LOCKED", "UNLOCKED"};
+static const uint32_t counter_trend_window_ms = 10 * 60000;
+static const size_t counter_trend_points = 20;
+
+// taken during static initialisation, as close to process start as the widget can get
+static const uint64_t process_start_ms = notification_coalescer::now_ms();
+static const uint64_t first_paint_budget_ms = 200;
+
+static wxString format_command_status(uint32_t cmd_status)
+{
+    if(cmd_status == send_failed_status)
+        return wxT("not sent");
+    return avdecc_lib::utility::aem_cmd_status_value_to_name(cmd_status);
+}
+
+static unsigned int channel_count_from_format(const char *current_format)
+{
+    return stream_format_channel_count(avdecc_lib::utility::ieee1722_format_name_to_value(current_format));
+}
+
 class AVDECC_App : public wxApp
 {
 public:
+    AVDECC_App() : m_startup_bench_failed(false) {}
     virtual bool OnInit() { (new AVDECC_Controller())->Show(); return true; }
+    virtual int OnRun() { int code = wxApp::OnRun(); return m_startup_bench_failed ? 1 : code; }
+    void set_startup_bench_failed(bool failed) { m_startup_bench_failed = failed; }
+
+private:
+    bool m_startup_bench_failed; // the first paint missed its budget under AVDECC_WIDGET_STARTUP_BENCH
 };
 
 // ----------------------------------------------------------------------------
@@ -44,25 +84,65 @@ public:
 
 wxBEGIN_EVENT_TABLE(AVDECC_Controller, wxFrame)
     EVT_MENU(HtmlLbox_Quit,  AVDECC_Controller::OnQuit)
-    EVT_TIMER(EndStationTimer, AVDECC_Controller::OnIncrementTimer)
+    EVT_MENU(TraceToggle, AVDECC_Controller::OnTraceToggle)
+    EVT_MENU(TraceWrite, AVDECC_Controller::OnTraceWrite)
+    EVT_MENU(InventoryExport, AVDECC_Controller::OnInventoryExport)
+    EVT_MENU(FirmwareUpload, AVDECC_Controller::OnFirmwareUpload)
+    EVT_TIMER(RegistrationTimer, AVDECC_Controller::OnRegistrationTimer)
+    EVT_TIMER(NotificationTimer, AVDECC_Controller::OnNotificationTimer)
+    EVT_THREAD(StackReady, AVDECC_Controller::OnStackReady)
     EVT_LIST_ITEM_ACTIVATED(wxID_ANY, AVDECC_Controller::OnEndStationDClick)
+    EVT_TEXT(EndStationFilter, AVDECC_Controller::OnFilterText)
 wxEND_EVENT_TABLE()
 
 IMPLEMENT_APP(AVDECC_App)
 
 AVDECC_Controller::AVDECC_Controller()
 : wxFrame(NULL, wxID_ANY, wxT("AVDECC-LIB Controller widget"),
-          wxDefaultPosition, wxSize(600,300))
+          wxDefaultPosition, wxSize(600,300)),
+  m_listener_poller(listener_poll_interval_ms),
+  m_counter_monitor(counter_budget_per_second),
+  m_commands(pending_commands, [this]() { return (void *)(intptr_t)get_next_notification_id(); },
+             [](const notification_record &record)
+             {
+                 return record.notification_type == avdecc_lib::RESPONSE_RECEIVED &&
+                        record.cmd_status == avdecc_lib::AEM_STATUS_SUCCESS;
+             }),
+  m_alive(new std::atomic<bool>(true))
 {
-    netif = avdecc_lib::create_net_interface();
-    netif->select_interface_by_num(1);
-    controller_obj = avdecc_lib::create_controller(netif, notification_callback, log_callback, log_level);
-    sys = avdecc_lib::create_system(avdecc_lib::system::LAYER2_MULTITHREADED_CALLBACK, netif, controller_obj);
-    sys->process_start();
+    const char *trace_path = getenv("AVDECC_WIDGET_TRACE");
+    if(trace_path && trace_path[0] != '\0')
+    {
+        trace_log::enable(trace_path);
+    }
+    trace_log::set_thread_name("wx event loop");
+    console_log::start();
+
+    // opening the NICs and starting avdecc-lib can take seconds; the frame is shown meanwhile
+    std::vector<uint32_t> interface_nums = avdecc_interface::parse_interface_list(getenv("AVDECC_WIDGET_INTERFACES"));
+    m_stack_thread = std::thread([this, interface_nums]()
+    {
+        trace_log::set_thread_name("avdecc-lib startup");
+        open_interfaces(interface_nums);
+        wxQueueEvent(this, new wxThreadEvent(wxEVT_THREAD, StackReady));
+    });
+    current_interface_index = 0;
     m_end_station_count = 0;
-    m_timer = new wxTimer(this, EndStationTimer);
+    m_discovered_count = 0;
+    m_entity_generation = 0;
+    m_timer = new wxTimer(this, RegistrationTimer);
     m_timer->Start(1000, wxTIMER_CONTINUOUS);
+    m_notification_timer = new wxTimer(this, NotificationTimer);
+    m_notification_timer->Start(notification_coalesce_window_ms, wxTIMER_CONTINUOUS);
+    m_acmp_queue = new acmp_command_queue(pending_commands, acmp_max_in_flight);
+    m_acmp_queue->set_sender([this]() { return (void *)(intptr_t)get_next_notification_id(); },
+                             [this](const acmp_command &command, void *cmd_notification_id)
+                             {
+                                 return send_acmp_command(command, cmd_notification_id);
+                             });
+    m_acmp_queue->set_reader([this](acmp_result &result) { return read_listener_state(result); });
     notification_id = 1;
+    m_firmware_entity_id = 0;
 
     // set the frame icon
     SetIcon(wxICON(sample));
@@ -71,6 +151,16 @@ AVDECC_Controller::AVDECC_Controller()
     
     // create a menu bar
     wxMenu *menuFile = new wxMenu;
+    menuFile->AppendCheckItem(TraceToggle, wxT("&Record Trace"), wxT("Record trace events for Chrome/Perfetto"));
+    menuFile->Append(TraceWrite, wxT("&Write Trace"), wxT("Write recorded trace events to disk"));
+    menuFile->Check(TraceToggle, trace_log::enabled());
+    menuFile->AppendSeparator();
+    menuFile->Append(InventoryExport, wxT("&Export Inventory..."), wxT("Export every end station to CSV or JSON"));
+    menuFile->Append(FirmwareUpload, wxT("&Upload Firmware..."), wxT("Upload a firmware image to the selected end station"));
+    // both need the interfaces, which OnStackReady brings in
+    menuFile->Enable(InventoryExport, false);
+    menuFile->Enable(FirmwareUpload, false);
+    menuFile->AppendSeparator();
     menuFile->Append(HtmlLbox_Quit, wxT("E&xit\tAlt-X"), wxT("Quit this program"));
 
     // now append the freshly created menu to the menu bar...
@@ -83,405 +173,1521 @@ AVDECC_Controller::AVDECC_Controller()
     
 #if wxUSE_STATUSBAR
     CreateStatusBar(2);
-    SetStatusText(wxT("Welcome to avdecc-lib controller!"));
+    SetStatusText(wxT("Starting avdecc-lib..."));
 #endif // wxUSE_STATUSBAR
     CreateEndStationListFormat();
-    CreateEndStationList();
+    Bind(wxEVT_IDLE, &AVDECC_Controller::OnFirstIdle, this);
 }
 
 AVDECC_Controller::~AVDECC_Controller()
 {
-    sys->process_close();
-    sys->destroy();
-    controller_obj->destroy();
-    netif->destroy();
+    m_alive->store(false);
+    if(trace_log::enabled())
+    {
+        trace_log::write();
+    }
+    if(m_firmware_upload)
+    {
+        m_firmware_upload->cancel();
+    }
+    m_firmware_rollout.abort();
+    published_entities.set_reader(entity_table::reader());
+    if(m_stack_thread.joinable())
+    {
+        m_stack_thread.join();
+    }
+    // interfaces opened after the last event loop pass were never adopted
+    m_interfaces.insert(m_interfaces.end(), m_opened_interfaces.begin(), m_opened_interfaces.end());
+    m_opened_interfaces.clear();
+    for(size_t i = 0; i < m_interfaces.size(); i++)
+    {
+        delete m_interfaces[i];
+    }
+    m_interfaces.clear();
+    delete m_acmp_queue;
     m_timer->Stop();
+    m_notification_timer->Stop();
+    console_log::stop();
     delete wxLog::SetActiveTarget(NULL);
 }
 
-void AVDECC_Controller::CreateEndStationList()
+void AVDECC_Controller::open_interfaces(const std::vector<uint32_t> &interface_nums)
 {
-	wxMilliSleep(1000); //delay to process end stations (will be replaced by timer method)
+    std::vector<avdecc_interface *> interfaces;
+    std::vector<std::thread> openers;
 
-    for (unsigned int i = 0; i < controller_obj->get_end_station_count(); i++)
+    for(size_t i = 0; i < interface_nums.size(); i++)
     {
-        avdecc_lib::end_station *end_station = controller_obj->get_end_station_by_index(i);
-        
-        if (end_station)
+        if(i == max_callback_slots)
         {
-            uint64_t end_station_entity_id = end_station->entity_id();
-            avdecc_lib::entity_descriptor_response *ent_desc_resp = NULL;
-            if (end_station->entity_desc_count())
-            {
-                uint16_t current_entity = end_station->get_current_entity_index();
-                ent_desc_resp = end_station->get_entity_desc_by_index(current_entity)->get_entity_response();
-            }
-            const char *end_station_name = "";
-            const char *fw_ver = "";
-            if (ent_desc_resp)
-            {
-                end_station_name = (const char *)ent_desc_resp->entity_name();
-                fw_ver = (const char *)ent_desc_resp->firmware_version();
-            }
-            uint64_t end_station_mac = end_station->mac();
-            
-            wxListItem item;
-            item.SetId(i);
-            details_list->InsertItem(item);
-            details_list->SetItem(i, 0, end_station->get_connection_status());
-            details_list->SetItem(i, 1, end_station_name);
-            details_list->SetItem(i, 2, wxString::Format("0x%llx", end_station_entity_id));
-            details_list->SetItem(i, 3, fw_ver);
-            details_list->SetItem(i, 4, wxString::Format("%llx",end_station_mac));
-            delete ent_desc_resp;
+            console_log::line("Only the first %u network interfaces are opened", (unsigned int)max_callback_slots);
+            break;
         }
-        m_end_station_count++;
+        callback_interface_nums[i] = interface_nums[i];
+        interfaces.push_back(new avdecc_interface(interface_nums[i]));
     }
-#if wxUSE_STATUSBAR
-    SetStatusText(wxString::Format(
-                                   wxT("# end stations found = %u"),
-                                   m_end_station_count
-                                   ));
-#endif // wxUSE_STATUSBAR
-}
-
-
-// ----------------------------------------------------------------------------
-// menu event handlers
-// ----------------------------------------------------------------------------
-
-void AVDECC_Controller::OnQuit(wxCommandEvent& WXUNUSED(event))
-{
-    // true is to force the frame to close
-    Close(true);
-}
+    std::vector<int> status(interfaces.size(), -1);
 
-void AVDECC_Controller::OnEndStationDClick(wxListEvent& event)
-{
-    avdecc_lib::end_station *end_station = controller_obj->get_end_station_by_index(event.GetIndex());
-    avdecc_lib::entity_descriptor *entity;
-    avdecc_lib::configuration_descriptor *configuration;
-    get_current_entity_and_descriptor(end_station, &entity, &configuration);
-    
-    current_end_station_index = event.GetIndex();
-    
-    avdecc_lib::audio_unit_descriptor *audio_unit_desc = configuration->get_audio_unit_desc_by_index(0);
-    avdecc_lib::audio_unit_descriptor_response *audio_unit_resp_ref = audio_unit_desc->get_audio_unit_response();
-    avdecc_lib::strings_descriptor *strings_desc = configuration->get_strings_desc_by_index(0);
-    avdecc_lib::strings_descriptor_response *strings_resp_ref = strings_desc->get_strings_response();
-
-    uint16_t number_of_stream_input_ports = configuration->stream_input_desc_count();
-    uint16_t number_of_stream_output_ports = configuration->stream_output_desc_count();
-
-    wxString entity_id = wxString::Format("0x%llx",end_station->entity_id());
-    avdecc_lib::entity_descriptor_response *entity_desc_resp = entity->get_entity_response();
-    wxString entity_name = entity_desc_resp->entity_name();
-    wxString default_name = strings_resp_ref->get_string_by_index(1);
-    wxString mac = wxString::Format("%llx",end_station->mac());
-    wxString fw_ver = (const char *)entity_desc_resp->firmware_version();
-    init_sample_rate = audio_unit_resp_ref->current_sampling_rate();
-    
-    config = new end_station_configuration(entity_name, entity_id, default_name, mac, fw_ver, init_sample_rate);
-    stream_config = new stream_configuration(number_of_stream_input_ports, number_of_stream_output_ports);
-
-    delete audio_unit_resp_ref;
-    delete entity_desc_resp;
-    delete strings_resp_ref;
-    
-    for(unsigned int i = 0; i < number_of_stream_input_ports; i++)
-    {
-        avdecc_lib::stream_input_descriptor *stream_input_desc_ref = configuration->get_stream_input_desc_by_index(i);
-        if(stream_input_desc_ref)
-        {
-            struct stream_configuration_details input_stream_details;
-            
-            avdecc_lib::stream_input_descriptor_response *stream_input_resp_ref = stream_input_desc_ref->get_stream_input_response();
-            const uint8_t * object_name = stream_input_resp_ref->object_name();
-            const uint8_t * stream_input_name;
-            if(object_name[0] == '\0')
-            {
-                stream_input_name = configuration->get_strings_desc_string_by_reference(stream_input_resp_ref->localized_description());
-            }
-            else
-            {
-                stream_input_name = object_name;
-            }
-            
-            input_stream_details.stream_name = stream_input_name;
-            
-            const char * current_format = stream_input_resp_ref->current_format();
-            uint64_t value = avdecc_lib::utility::ieee1722_format_name_to_value(current_format);
-            value = value << 44;
-            value = value >> 52;
-        
-            if(value == 1) //channel count 1
-            {
-                input_stream_details.channel_count = 1;
-            }
-            else if(value == 2) //channel count 2
-            {
-                input_stream_details.channel_count = 2;
-            }
-            else //channel count 2
-            {
-                input_stream_details.channel_count = 8;
-            }
-            stream_config->input_stream_config.push_back(input_stream_details);
-            delete stream_input_resp_ref;
-        }
-    }
-    
-    for(unsigned int i = 0; i < number_of_stream_output_ports; i++)
+    // opening a capture device can be slow, so bring the NICs up together
+    for(size_t i = 0; i < interfaces.size(); i++)
     {
-        avdecc_lib::stream_output_descriptor *stream_output_desc_ref = configuration->get_stream_output_desc_by_index(i);
-        if(stream_output_desc_ref)
+        openers.push_back(std::thread([&interfaces, &status, i, this]()
         {
-            struct stream_configuration_details output_stream_details;
-
-            avdecc_lib::stream_output_descriptor_response *stream_output_resp_ref = stream_output_desc_ref->get_stream_output_response();
-            const uint8_t * object_name = stream_output_resp_ref->object_name();
-            const uint8_t * stream_output_name;
-            if(object_name[0] == '\0')
-            {
-                stream_output_name = configuration->get_strings_desc_string_by_reference(stream_output_resp_ref->localized_description());
-            }
-            else
-            {
-                stream_output_name = object_name;
-            }
-            
-            output_stream_details.stream_name = stream_output_name;
-
-            const char * current_format = stream_output_resp_ref->current_format();
-            uint64_t value = avdecc_lib::utility::ieee1722_format_name_to_value(current_format);
-            value = value << 44;
-            value = value >> 52;
-            
-            if(value == 1) //channel count 1
-            {
-                output_stream_details.channel_count = 1;
-            }
-            else if(value == 2) //channel count 2
-            {
-                output_stream_details.channel_count = 2;
-            }
-            else //channel count 8
-            {
-                output_stream_details.channel_count = 8;
-            }
-            stream_config->output_stream_config.push_back(output_stream_details);
-            delete stream_output_resp_ref;
-        }
+            status[i] = interfaces[i]->open(notification_callbacks[i], log_callback, log_level);
+        }));
     }
-    details = new end_station_details(this, config, stream_config);
-    int retval = details->ShowModal();
-    
-    if (retval == wxID_CANCEL)
+    for(size_t i = 0; i < openers.size(); i++)
     {
-        details->OnCancel();
-        std::cout << "Cancel" << std::endl;
+        openers[i].join();
     }
-    else if (retval == wxID_OK)
-    {
-        details->OnOK();
-        std::cout << "Apply" << std::endl;
 
-        if(details->m_end_station_config->get_sample_rate() != init_sample_rate)
+    for(size_t i = 0; i < interfaces.size(); i++)
+    {
+        if(status[i] == 0)
         {
-            cmd_set_sampling_rate(details->m_sampling_rate);
+            std::lock_guard<std::mutex> guard(m_stack_lock);
+            m_opened_interfaces.push_back(interfaces[i]);
         }
         else
         {
-            //same value
-        }
-        
-        for(int i = 0; i < details->m_stream_input_count; i++)
-        {
-            struct stream_configuration_details avdecc_stream_input_details;
-            struct stream_configuration_details dialog_stream_input_details;
-            
-            stream_config->get_stream_input_details_by_index(i, avdecc_stream_input_details);
-            details->m_stream_config->get_stream_input_details_by_index(i, dialog_stream_input_details);
-            
-            if(dialog_stream_input_details.channel_count != avdecc_stream_input_details.channel_count)
-            {
-                unsigned int stream_index = channel_count_and_sample_rate_to_stream_index(dialog_stream_input_details.channel_count,
-                                                                                          details->m_sampling_rate);
-                if(stream_index != -1)
-                {
-                    cmd_set_stream_format("STREAM_INPUT", i, stream_index);
-                }
-                else
-                {
-                    //error, stream_format not found
-                }
-            }
-            else
-            {
-                //same value
-            }
-        }
-        
-        for(int i = 0; i < details->m_stream_output_count; i++)
-        {
-            struct stream_configuration_details avdecc_stream_output_details;
-            struct stream_configuration_details dialog_stream_output_details;
-            
-            stream_config->get_stream_output_details_by_index(i, avdecc_stream_output_details);
-            details->m_stream_config->get_stream_output_details_by_index(i, dialog_stream_output_details);
-            
-            if(dialog_stream_output_details.channel_count != avdecc_stream_output_details.channel_count)
-            {
-                unsigned int stream_index = channel_count_and_sample_rate_to_stream_index(dialog_stream_output_details.channel_count,
-                                                                                          details->m_sampling_rate);
-                if(stream_index != -1)
-                {
-                    cmd_set_stream_format("STREAM_OUTPUT", i, stream_index);
-                }
-                else
-                {
-                    //error, stream_format not found
-                }
-            }
-            else
-            {
-                //same value
-            }
+            console_log::line("Unable to open network interface %u", interfaces[i]->get_interface_num());
+            delete interfaces[i];
         }
-        details->Destroy();
     }
-    else
+}
+
+/*
+ * Runs on the GUI thread once the startup thread has opened the interfaces.
+ * Only from here on does the GUI touch m_interfaces, so nothing before this
+ * needs a lock.
+ */
+void AVDECC_Controller::OnStackReady(wxThreadEvent& WXUNUSED(event))
+{
+    m_stack_thread.join();
     {
-        //not supported
+        std::lock_guard<std::mutex> guard(m_stack_lock);
+        m_interfaces.swap(m_opened_interfaces);
     }
-	delete config;
-	delete stream_config;
+
+    published_entities.set_reader([this](uint32_t interface_index, uint64_t entity_id, entity_record &record)
+    {
+        return read_entity_record(interface_index, entity_id, record);
+    });
+    publish_known_entities();
+    CreateEndStationList();
+#if wxUSE_MENUS
+    GetMenuBar()->Enable(InventoryExport, true);
+    GetMenuBar()->Enable(FirmwareUpload, true);
+#endif // wxUSE_MENUS
+
+    uint64_t elapsed = notification_coalescer::now_ms() - process_start_ms;
+    console_log::line("%u network interfaces ready %u ms after start", (unsigned int)m_interfaces.size(), (unsigned int)elapsed);
+#if wxUSE_STATUSBAR
+    SetStatusText(wxString::Format(wxT("%u network interfaces ready"), (unsigned int)m_interfaces.size()));
+#endif // wxUSE_STATUSBAR
+}
+
+/*
+ * The first idle event after Show() comes once the initial paint has been
+ * handled. With AVDECC_WIDGET_STARTUP_BENCH set, the time to get here is
+ * written to that file as JSON and the widget exits, failing if it took
+ * longer than the first paint budget.
+ */
+void AVDECC_Controller::OnFirstIdle(wxIdleEvent& event)
+{
+    Unbind(wxEVT_IDLE, &AVDECC_Controller::OnFirstIdle, this);
+    event.Skip();
+
+    uint64_t elapsed = notification_coalescer::now_ms() - process_start_ms;
+    console_log::line("First paint %u ms after start", (unsigned int)elapsed);
+
+    const char *bench_path = getenv("AVDECC_WIDGET_STARTUP_BENCH");
+    if(!bench_path || bench_path[0] == '\0')
+        return;
+
+    bool failed = elapsed > first_paint_budget_ms;
+    wxGetApp().set_startup_bench_failed(failed);
+    console_log::line("startup_bench: first paint %u ms, budget %u ms, %s", (unsigned int)elapsed,
+                      (unsigned int)first_paint_budget_ms, failed ? "FAILED" : "passed");
+    std::ofstream bench(bench_path);
+    bench << "{\"first_paint_ms\": " << elapsed << ", \"budget_ms\": " << first_paint_budget_ms
+          << ", \"passed\": " << (failed ? "false" : "true") << "}\n";
+    Close(true);
 }
 
-unsigned int AVDECC_Controller::channel_count_and_sample_rate_to_stream_index(unsigned int channel_count, uint32_t sampling_rate)
+/*
+ * Hands a completion from a worker thread to the GUI thread unless the frame
+ * has been destroyed. The call is queued on the application, which outlives
+ * the frame, and the token is checked again on the GUI thread, where the
+ * destructor clears it, so a frame destroyed while the call was queued is
+ * never touched.
+ */
+void AVDECC_Controller::call_while_alive(const std::shared_ptr<std::atomic<bool>> &alive, const std::function<void()> &call)
 {
-    switch(channel_count)
+    if(!alive->load(std::memory_order_acquire))
+        return;
+    wxTheApp->CallAfter([alive, call]()
     {
-        case 1:
-            if(sampling_rate == 48000)
-            {
-                return 0;
-            }
-            else
-            {
-                return 4;
-            }
-            break;
-        case 2:
-            if(sampling_rate == 48000)
-            {
-                return 1;
-            }
-            else
-            {
-                return 5;
-            }
-            break;
-        case 4:
-            if(sampling_rate == 48000)
-            {
-                return 2;
-            }
-            else
-            {
-                return 6;
-            }
-            break;
-        case 8:
-            if(sampling_rate == 48000)
-            {
-                return 3;
-            }
-            else
-            {
-                return 7;
-            }
-            break;
-    }
-    return -1; //not found
+        if(alive->load(std::memory_order_acquire))
+            call();
+    });
 }
 
+/*
+ * NULL when the interface is not open, which is every interface when none
+ * could be opened.
+ */
+avdecc_lib::controller * AVDECC_Controller::current_controller() const
+{
+    if(current_interface_index >= m_interfaces.size())
+        return NULL;
+    return m_interfaces[current_interface_index]->get_controller();
+}
 
-int AVDECC_Controller::get_current_entity_and_descriptor(avdecc_lib::end_station *end_station,
-                                                         avdecc_lib::entity_descriptor **entity, avdecc_lib::configuration_descriptor **configuration)
+avdecc_lib::system * AVDECC_Controller::current_system() const
 {
-    *entity = NULL;
-    *configuration = NULL;
-    
-    uint16_t current_entity = end_station->get_current_entity_index();
-    if (current_entity >= end_station->entity_desc_count())
+    if(current_interface_index >= m_interfaces.size())
+        return NULL;
+    return m_interfaces[current_interface_index]->get_system();
+}
+
+/*
+ * Runs on the GUI thread through published_entities, once per coalesce
+ * window for each entity a notification said had changed. Only the
+ * controller of the interface that reported the change is read.
+ */
+bool AVDECC_Controller::read_entity_record(uint32_t interface_index, uint64_t entity_id, entity_record &record)
+{
+    size_t n = interface_index;
+    avdecc_lib::end_station *end_station;
+    uint32_t end_station_index;
+    if (n >= m_interfaces.size() || !m_interfaces[n]->find_end_station(entity_id, &end_station, &end_station_index))
+        return false;
+
+    avdecc_lib::entity_descriptor *entity = NULL;
+    avdecc_lib::entity_descriptor_response *ent_desc_resp = NULL;
+    if (end_station->entity_desc_count())
     {
-        atomic_cout << "Current entity not available" << std::endl;
-        return 1;
+        uint16_t current_entity = end_station->get_current_entity_index();
+        entity = end_station->get_entity_desc_by_index(current_entity);
+        ent_desc_resp = entity->get_entity_response();
     }
-    
-    *entity = end_station->get_entity_desc_by_index(current_entity);
-    
-    uint16_t current_config = end_station->get_current_config_index();
-    if (current_config >= (*entity)->config_desc_count())
+    const char *end_station_name = "";
+    const char *fw_ver = "";
+    uint64_t entity_model_id = 0;
+    if (ent_desc_resp)
     {
-        atomic_cout << "Current configuration not available" << std::endl;
-        return 1;
+        end_station_name = (const char *)ent_desc_resp->entity_name();
+        fw_ver = (const char *)ent_desc_resp->firmware_version();
+        entity_model_id = ent_desc_resp->entity_model_id();
     }
-    
-    *configuration = (*entity)->get_config_desc_by_index(current_config);
-    
-    return 0;
+
+    record.entity_id = entity_id;
+    record.mac = end_station->mac();
+    record.entity_model_id = entity_model_id;
+    record.name = string_pool::intern(end_station_name);
+    record.fw_ver = string_pool::intern(fw_ver);
+    record.interface_name = string_pool::intern(m_interfaces[n]->get_name());
+    record.connection_status = end_station->get_connection_status();
+    record.interface_index = (uint32_t)n;
+    record.end_station_index = end_station_index;
+    delete ent_desc_resp;
+
+    // the configuration descriptor arrives later during enumeration
+    uint16_t current_config = end_station->get_current_config_index();
+    if (entity && current_config < entity->config_desc_count())
+        read_entity_configuration(entity->get_config_desc_by_index(current_config), record);
+    return true;
 }
 
-int AVDECC_Controller::get_current_end_station_entity_and_descriptor(avdecc_lib::end_station **end_station,
-                                                                     avdecc_lib::entity_descriptor **entity, avdecc_lib::configuration_descriptor **configuration)
+/*
+ * Copies the parts of the current configuration the GUI uses into the
+ * record, and reads the entity's model the first time one is seen with all
+ * of its stream descriptors.
+ */
+void AVDECC_Controller::read_entity_configuration(avdecc_lib::configuration_descriptor *configuration, entity_record &record)
 {
-    if (get_current_end_station(end_station))
-        return 1;
-    
-    if (get_current_entity_and_descriptor(*end_station, entity, configuration))
+    record.enumerated = true;
+    record.avb_interface_count = configuration->avb_interface_desc_count();
+    record.clock_domain_count = configuration->clock_domain_desc_count();
+
+    avdecc_lib::audio_unit_descriptor *audio_unit_desc = configuration->get_audio_unit_desc_by_index(0);
+    if (audio_unit_desc)
     {
-        atomic_cout << "Current End Station not fully enumerated" << std::endl;
-        return 1;
+        avdecc_lib::audio_unit_descriptor_response *audio_unit_resp_ref = audio_unit_desc->get_audio_unit_response();
+        record.sample_rate = audio_unit_resp_ref->current_sampling_rate();
+        delete audio_unit_resp_ref;
     }
-    return 0;
-}
 
-int AVDECC_Controller::get_current_end_station(avdecc_lib::end_station **end_station) const
-{
-    if (current_end_station_index >= controller_obj->get_end_station_count())
+    bool complete = true;
+    for (uint16_t i = 0; i < configuration->stream_input_desc_count(); i++)
     {
-        atomic_cout << "No End Stations available" << std::endl;
-        *end_station = NULL;
-        return 1;
+        avdecc_lib::stream_input_descriptor *stream_input_desc_ref = configuration->get_stream_input_desc_by_index(i);
+        if (!stream_input_desc_ref)
+        {
+            complete = false;
+            continue;
+        }
+        avdecc_lib::stream_input_descriptor_response *stream_input_resp_ref = stream_input_desc_ref->get_stream_input_response();
+        entity_stream stream;
+        stream.input = true;
+        stream.stream_index = i;
+        stream.name = string_pool::intern(get_stream_name(configuration, stream_input_resp_ref->object_name(),
+                                                          stream_input_resp_ref->localized_description()));
+        stream.format = string_pool::intern(stream_input_resp_ref->current_format());
+        record.streams.push_back(stream);
+        delete stream_input_resp_ref;
     }
-    
-    *end_station = controller_obj->get_end_station_by_index(current_end_station_index);
-    return 0;
-}
 
-void AVDECC_Controller::OnIncrementTimer(wxTimerEvent& event)
-{
-    if(m_end_station_count < controller_obj->get_end_station_count())
+    for (uint16_t i = 0; i < configuration->stream_output_desc_count(); i++)
     {
-        details_list->DeleteAllItems();
-        CreateEndStationList();
+        avdecc_lib::stream_output_descriptor *stream_output_desc_ref = configuration->get_stream_output_desc_by_index(i);
+        if (!stream_output_desc_ref)
+        {
+            complete = false;
+            continue;
+        }
+        avdecc_lib::stream_output_descriptor_response *stream_output_resp_ref = stream_output_desc_ref->get_stream_output_response();
+        entity_stream stream;
+        stream.input = false;
+        stream.stream_index = i;
+        stream.name = string_pool::intern(get_stream_name(configuration, stream_output_resp_ref->object_name(),
+                                                          stream_output_resp_ref->localized_description()));
+        stream.format = string_pool::intern(stream_output_resp_ref->current_format());
+        record.streams.push_back(stream);
+        delete stream_output_resp_ref;
     }
-    else
+
+    // a model read before enumeration finished would be shared with its gaps
+    if (complete && configuration->get_strings_desc_by_index(0) && !m_models.find(record.entity_model_id))
+        m_models.insert(read_entity_model(record.entity_model_id, configuration));
+}
+
+/*
+ * Entities found before the reader was installed never get a notification
+ * the table acts on, so read them in once, interface by interface. The
+ * lost-callback recount in OnRegistrationTimer does the same; a response
+ * stored meanwhile is read again when its notification is flushed.
+ */
+void AVDECC_Controller::publish_known_entities()
+{
+    for (size_t n = 0; n < m_interfaces.size(); n++)
     {
-        //no added end stations found
+        std::vector<uint64_t> entity_ids;
+        avdecc_lib::controller *controller_obj = m_interfaces[n]->get_controller();
+        for (unsigned int i = 0; i < controller_obj->get_end_station_count(); i++)
+        {
+            avdecc_lib::end_station *end_station = controller_obj->get_end_station_by_index(i);
+            if (end_station)
+                entity_ids.push_back(end_station->entity_id());
+        }
+        published_entities.refresh((uint32_t)n, entity_ids);
     }
 }
 
-void AVDECC_Controller::CreateEndStationListFormat()
+/*
+ * Re-reads each entity the flushed notifications changed, once per
+ * interface however many packets reported it in this window.
+ */
+void AVDECC_Controller::refresh_notified_entities()
 {
-    wxNotebook *notebook = new wxNotebook(this, wxID_ANY, wxDefaultPosition, wxSize(700,200), wxGROW);
-    wxPanel * window1 = new wxPanel(notebook, wxID_ANY, wxDefaultPosition, wxSize(700, 200), wxGROW);
+    for (size_t n = 0; n < m_interfaces.size(); n++)
+    {
+        std::vector<uint64_t> entity_ids;
+        for (size_t i = 0; i < m_notification_batch.size(); i++)
+        {
+            const notification_record &record = m_notification_batch[i];
+            if (record.interface_num == m_interfaces[n]->get_interface_num() &&
+                changes_entity_record(record.notification_type, record.cmd_type, record.cmd_status))
+                entity_ids.push_back(record.entity_id);
+        }
+        if (entity_ids.empty())
+            continue;
+
+        std::sort(entity_ids.begin(), entity_ids.end());
+        entity_ids.erase(std::unique(entity_ids.begin(), entity_ids.end()), entity_ids.end());
+        published_entities.refresh((uint32_t)n, entity_ids);
+    }
+}
+
+/*
+ * Brings the list up to date with the latest published entity table. Only
+ * chunks that changed since the last call are walked; when nothing changed
+ * this is a single atomic load.
+ */
+void AVDECC_Controller::CreateEndStationList()
+{
+    std::shared_ptr<const entity_table::version> entities = published_entities.current();
+    if (entities->get_generation() == m_entity_generation)
+        return;
+
+    TRACE_SPAN_ARG("gui", "CreateEndStationList", entities->size());
+
+    for (size_t n = 0; n < entities->get_chunk_count(); n++)
+    {
+        const entity_table::chunk &chunk = entities->get_chunk(n);
+        if (chunk.generation <= m_entity_generation)
+            continue;
+
+        for (size_t i = 0; i < chunk.records.size(); i++)
+        {
+            details_list->update_entity(chunk.records[i]);
+        }
+    }
+    details_list->refresh_rows();
+    m_entity_generation = entities->get_generation();
+    m_end_station_count = (unsigned int)entities->size();
+#if wxUSE_STATUSBAR
+    SetStatusText(wxString::Format(
+                                   wxT("# end stations found = %u"),
+                                   m_end_station_count
+                                   ));
+#endif // wxUSE_STATUSBAR
+}
+
+
+// ----------------------------------------------------------------------------
+// menu event handlers
+// ----------------------------------------------------------------------------
+
+void AVDECC_Controller::OnQuit(wxCommandEvent& WXUNUSED(event))
+{
+    // true is to force the frame to close
+    Close(true);
+}
+
+void AVDECC_Controller::OnTraceToggle(wxCommandEvent& event)
+{
+    if(event.IsChecked())
+    {
+        std::string path = trace_log::output_path();
+        trace_log::enable(path.empty() ? "avdecc-widget-trace.json" : path);
+        trace_log::set_thread_name("wx event loop");
+    }
+    else
+    {
+        trace_log::disable();
+    }
+}
+
+void AVDECC_Controller::OnTraceWrite(wxCommandEvent& WXUNUSED(event))
+{
+    std::string path = trace_log::output_path();
+    if(path.empty())
+    {
+        SetStatusText(wxT("Trace recording has not been started"));
+        return;
+    }
+
+    if(trace_log::write(path) == 0)
+        SetStatusText(wxString::Format(wxT("Trace written to %s"), path.c_str()));
+    else
+        SetStatusText(wxString::Format(wxT("Unable to write trace to %s"), path.c_str()));
+}
+
+void AVDECC_Controller::OnInventoryExport(wxCommandEvent& WXUNUSED(event))
+{
+    if(m_inventory_writer.is_busy())
+    {
+        SetStatusText(wxT("An inventory export is already running"));
+        return;
+    }
+
+    wxFileDialog dialog(this, wxT("Export Inventory"), wxEmptyString, wxT("inventory.csv"),
+                        wxT("CSV files (*.csv)|*.csv|JSON files (*.json)|*.json"),
+                        wxFD_SAVE | wxFD_OVERWRITE_PROMPT);
+    if(dialog.ShowModal() != wxID_OK)
+        return;
+
+    inventory_format format = dialog.GetFilterIndex() == 1 || dialog.GetPath().Lower().EndsWith(wxT(".json")) ?
+                              INVENTORY_JSON : INVENTORY_CSV;
+    wxString path = dialog.GetPath();
+
+    // the export thread snapshots this version itself; the frame may be gone by the time it finishes
+    std::shared_ptr<std::atomic<bool>> alive = m_alive;
+    m_inventory_writer.start(published_entities.current(), std::string(path.utf8_str()), format,
+                             [this, alive, path](bool ok, size_t entity_count, double seconds)
+                             {
+                                 call_while_alive(alive, [this, path, ok, entity_count, seconds]()
+                                 {
+                                     if(ok)
+                                         SetStatusText(wxString::Format(wxT("Exported %u end stations to %s in %.0f ms"),
+                                                                        (unsigned int)entity_count, path, seconds * 1000));
+                                     else
+                                         SetStatusText(wxString::Format(wxT("Unable to export inventory to %s"), path));
+                                 });
+                             });
+    SetStatusText(wxString::Format(wxT("Exporting inventory to %s"), path));
+}
+
+void AVDECC_Controller::OnFirmwareUpload(wxCommandEvent& WXUNUSED(event))
+{
+    if(m_firmware_upload)
+    {
+        SetStatusText(wxT("A firmware upload is already running"));
+        return;
+    }
+
+    const entity_record *record = details_list->get_entity_by_row(
+        details_list->GetNextItem(-1, wxLIST_NEXT_ALL, wxLIST_STATE_SELECTED));
+    if(!record)
+    {
+        SetStatusText(wxT("Select an end station to upload firmware to"));
+        return;
+    }
+    uint64_t entity_id = record->entity_id;
+
+    wxFileDialog dialog(this, wxT("Upload Firmware"), wxEmptyString, wxEmptyString,
+                        wxT("Firmware images (*.bin)|*.bin|All files (*.*)|*.*"),
+                        wxFD_OPEN | wxFD_FILE_MUST_EXIST);
+    if(dialog.ShowModal() != wxID_OK)
+        return;
+    std::string path(dialog.GetPath().utf8_str());
+
+    // pick up where an earlier attempt with the same image stopped, even in an earlier session
+    uint64_t resume_offset = load_firmware_resume(entity_id, path);
+
+    std::string error;
+    m_firmware_upload = start_firmware_upload(entity_id, path, resume_offset, error);
+    if(!m_firmware_upload)
+    {
+        SetStatusText(wxString::FromUTF8(error.c_str()));
+        return;
+    }
+
+    m_firmware_entity_id = entity_id;
+    m_firmware_path = path;
+    SetStatusText(wxString::Format(wxT("Uploading %s to 0x%llx"), dialog.GetPath(), (unsigned long long)entity_id));
+}
+
+/*
+ * Opens the first memory object of an end station for upload and starts
+ * writing the image to it. Returns NULL with a reason in error on failure.
+ */
+std::shared_ptr<firmware_upload> AVDECC_Controller::start_firmware_upload(uint64_t entity_id, const std::string &path,
+                                                                          uint64_t resume_offset, std::string &error)
+{
+    // found by ID; the current end station belongs to the details dialog
+    avdecc_lib::end_station *end_station;
+    avdecc_lib::configuration_descriptor *configuration;
+    if(get_entity_configuration(entity_id, &end_station, &configuration))
+    {
+        error = "end station is no longer enumerated";
+        return std::shared_ptr<firmware_upload>();
+    }
+    if(configuration->memory_object_desc_count() == 0)
+    {
+        error = "end station has no memory object to upload to";
+        return std::shared_ptr<firmware_upload>();
+    }
+
+    std::shared_ptr<firmware_upload> upload = std::make_shared<firmware_upload>(pending_commands,
+        [this]() { return (void *)(intptr_t)get_next_notification_id(); },
+        [end_station](void *cmd_notification_id, uint64_t address, const uint8_t *data, size_t length)
+        {
+            return end_station->send_aecp_address_access_cmd(cmd_notification_id, avdecc_lib::AECP_AA_MODE_WRITE,
+                                                             (unsigned int)length, address, const_cast<uint8_t *>(data));
+        },
+        [](const notification_record &record)
+        {
+            return record.notification_type == avdecc_lib::RESPONSE_RECEIVED &&
+                   record.cmd_status == avdecc_lib::AEM_STATUS_SUCCESS;
+        });
+    if(upload->open(path))
+    {
+        error = "unable to open " + path;
+        return std::shared_ptr<firmware_upload>();
+    }
+
+    avdecc_lib::memory_object_descriptor *memory_object = configuration->get_memory_object_desc_by_index(0);
+    if(!memory_object)
+    {
+        error = "end station has no memory object to upload to";
+        return std::shared_ptr<firmware_upload>();
+    }
+    avdecc_lib::memory_object_descriptor_response *memory_object_resp_ref = memory_object->get_memory_object_response();
+    uint64_t start_address = memory_object_resp_ref->start_address();
+    delete memory_object_resp_ref;
+
+    // the memory object is opened for upload before any data is written, and the device stores the image once it is all there
+    upload->set_operations([memory_object](void *cmd_notification_id)
+                           {
+                               return memory_object->send_start_operation_cmd(cmd_notification_id,
+                                                                              avdecc_lib::MEMORY_OBJECT_OPERATION_UPLOAD);
+                           },
+                           [memory_object](void *cmd_notification_id)
+                           {
+                               return memory_object->send_start_operation_cmd(cmd_notification_id,
+                                                                              avdecc_lib::MEMORY_OBJECT_OPERATION_STORE_AND_REBOOT);
+                           });
+    upload->start(start_address, resume_offset);
+    return upload;
+}
+
+/*
+ * Resume points are kept in the user's wxConfig so an upload cut short by
+ * a restart can pick up again. A point only applies to the same path with
+ * the same size, so an image rebuilt in place starts over.
+ */
+uint64_t AVDECC_Controller::load_firmware_resume(uint64_t entity_id, const std::string &path)
+{
+    wxConfigBase *config = wxConfigBase::Get();
+    wxString key = wxString::Format(wxT("/FirmwareResume/%016llx/"), (unsigned long long)entity_id);
+    wxString saved_path;
+    wxString saved_size;
+    wxString saved_offset;
+    unsigned long long size;
+    unsigned long long offset;
+    if(!config->Read(key + wxT("Path"), &saved_path) || saved_path != wxString::FromUTF8(path.c_str()) ||
+       !config->Read(key + wxT("Size"), &saved_size) || !saved_size.ToULongLong(&size) ||
+       !config->Read(key + wxT("Offset"), &saved_offset) || !saved_offset.ToULongLong(&offset))
+        return 0;
+
+    mapped_file image;
+    if(image.open(path) || image.size() != size || offset > size)
+        return 0;
+    return offset;
+}
+
+void AVDECC_Controller::save_firmware_resume(uint64_t entity_id, const std::string &path, uint64_t size, uint64_t offset)
+{
+    wxConfigBase *config = wxConfigBase::Get();
+    wxString key = wxString::Format(wxT("/FirmwareResume/%016llx/"), (unsigned long long)entity_id);
+    if(offset == 0)
+    {
+        config->DeleteGroup(key);
+    }
+    else
+    {
+        config->Write(key + wxT("Path"), wxString::FromUTF8(path.c_str()));
+        config->Write(key + wxT("Size"), wxString::Format(wxT("%llu"), (unsigned long long)size));
+        config->Write(key + wxT("Offset"), wxString::Format(wxT("%llu"), (unsigned long long)offset));
+    }
+    config->Flush();
+}
+
+void AVDECC_Controller::StartRollout()
+{
+    if(m_firmware_rollout.is_running())
+        return;
+
+    std::vector<rollout_candidate> candidates;
+    for(size_t i = 0; i < details_list->get_entity_count(); i++)
+    {
+        const entity_record &record = details_list->get_entity(i);
+        rollout_candidate candidate;
+        candidate.entity_id = record.entity_id;
+        candidate.entity_model_id = record.entity_model_id;
+        candidate.name = string_pool::get(record.name);
+        candidate.firmware_version = string_pool::get(record.fw_ver);
+        candidates.push_back(candidate);
+    }
+
+    rollout_dialog dialog(this, candidates);
+    if(dialog.ShowModal() != wxID_OK)
+        return;
+
+    std::vector<uint64_t> targets;
+    dialog.get_targets(targets);
+    if(targets.empty() || dialog.get_image_path().IsEmpty() || dialog.get_target_version().IsEmpty())
+    {
+        rollout_page->set_status(wxT("A rollout needs targets, an image and the new firmware version"));
+        return;
+    }
+
+    rollout_options options;
+    dialog.get_options(options);
+    m_rollout_image = std::string(dialog.get_image_path().utf8_str());
+    m_firmware_rollout.start(targets, std::string(dialog.get_target_version().utf8_str()), options,
+                             notification_coalescer::now_ms());
+    rollout_page->refresh_devices();
+}
+
+void AVDECC_Controller::ProcessRollout()
+{
+    if(!m_firmware_rollout.is_running())
+        return;
+
+    uint64_t now_ms = notification_coalescer::now_ms();
+    m_firmware_rollout.tick(now_ms,
+                            [this](uint64_t entity_id, uint64_t resume_offset, std::string &error)
+                            {
+                                return start_firmware_upload(entity_id, m_rollout_image, resume_offset, error);
+                            },
+                            [this](uint64_t entity_id)
+                            {
+                                read_firmware_version(entity_id);
+                            });
+
+    // only rows with a new stage or a moving upload are repainted
+    std::vector<size_t> changed;
+    m_firmware_rollout.take_changed(changed);
+    for(size_t i = 0; i < changed.size(); i++)
+    {
+        rollout_page->refresh_device(changed[i]);
+    }
+    if(!m_firmware_rollout.is_running())
+        rollout_page->refresh_devices();
+    rollout_page->set_status(wxString::Format(wxT("Wave %u of %u: %u done, %u failed, %u uploading at %.2f MB/s, %u s elapsed"),
+                                              std::min(m_firmware_rollout.get_current_wave() + 1, m_firmware_rollout.get_wave_count()),
+                                              m_firmware_rollout.get_wave_count(),
+                                              (unsigned int)m_firmware_rollout.get_stage_count(ROLLOUT_DONE),
+                                              (unsigned int)m_firmware_rollout.get_stage_count(ROLLOUT_FAILED),
+                                              (unsigned int)m_firmware_rollout.get_stage_count(ROLLOUT_UPLOADING),
+                                              m_firmware_rollout.get_throughput() / (1024 * 1024),
+                                              (unsigned int)(m_firmware_rollout.get_elapsed_ms(now_ms) / 1000)));
+}
+
+/*
+ * Reads the entity descriptor from the device rather than trusting what
+ * avdecc-lib held from before the reboot. The response is read on the
+ * callback thread, as it arrives, and handed to the rollout on the GUI
+ * thread.
+ */
+void AVDECC_Controller::read_firmware_version(uint64_t entity_id)
+{
+    avdecc_lib::end_station *end_station = NULL;
+    for(size_t i = 0; i < m_interfaces.size() && !end_station; i++)
+    {
+        m_interfaces[i]->find_end_station(entity_id, &end_station, NULL);
+    }
+    if(!end_station || end_station->get_connection_status() != 'C')
+    {
+        m_firmware_rollout.version_read(entity_id, false, std::string(), notification_coalescer::now_ms());
+        return;
+    }
+
+    std::shared_ptr<std::atomic<bool>> alive = m_alive;
+    m_commands.send([end_station](void *cmd_notification_id)
+    {
+        return end_station->send_read_desc_cmd(cmd_notification_id, avdecc_lib::AEM_DESC_ENTITY, 0);
+    })
+    .on_complete([this, alive, end_station, entity_id](bool succeeded, const notification_record &)
+    {
+        std::string version;
+        if(succeeded && end_station->entity_desc_count())
+        {
+            avdecc_lib::entity_descriptor_response *ent_desc_resp =
+                end_station->get_entity_desc_by_index(end_station->get_current_entity_index())->get_entity_response();
+            version = (const char *)ent_desc_resp->firmware_version();
+            delete ent_desc_resp;
+        }
+        else
+        {
+            succeeded = false;
+        }
+
+        call_while_alive(alive, [this, entity_id, succeeded, version]()
+        {
+            m_firmware_rollout.version_read(entity_id, succeeded, version, notification_coalescer::now_ms());
+        });
+    });
+}
+
+void AVDECC_Controller::ProcessFirmwareUpload()
+{
+    if(!m_firmware_upload)
+        return;
+
+    double percent = m_firmware_upload->get_size() ?
+                     100.0 * m_firmware_upload->get_acked_bytes() / m_firmware_upload->get_size() : 100.0;
+    double rate = m_firmware_upload->get_throughput() / (1024 * 1024);
+
+    switch(m_firmware_upload->get_state())
+    {
+    case firmware_upload::UPLOAD_RUNNING:
+        SetStatusText(wxString::Format(wxT("Firmware %.1f%% %.2f MB/s (%u in flight)"),
+                                       percent, rate, m_firmware_upload->get_window()), 1);
+        return;
+
+    case firmware_upload::UPLOAD_DONE:
+        save_firmware_resume(m_firmware_entity_id, m_firmware_path, m_firmware_upload->get_size(), 0);
+        SetStatusText(wxString::Format(wxT("Firmware uploaded to 0x%llx and stored at %.2f MB/s"),
+                                       (unsigned long long)m_firmware_entity_id, rate));
+        break;
+
+    default:
+        save_firmware_resume(m_firmware_entity_id, m_firmware_path, m_firmware_upload->get_size(),
+                             m_firmware_upload->get_resume_offset());
+        SetStatusText(wxString::Format(wxT("Firmware upload to 0x%llx stopped at %.1f%% (%s), upload again to resume"),
+                                       (unsigned long long)m_firmware_entity_id, percent,
+                                       wxString::FromUTF8(m_firmware_upload->get_error().c_str())));
+        break;
+    }
+
+    SetStatusText(wxEmptyString, 1);
+    m_firmware_upload.reset();
+}
+
+void AVDECC_Controller::OnEndStationDClick(wxListEvent& event)
+{
+    trace_span read_span("gui", "OnEndStationDClick.read_descriptors");
+
+    const entity_record *record = details_list->get_entity_by_row(event.GetIndex());
+    if(!record)
+        return;
+
+    current_interface_index = record->interface_index;
+    current_end_station_index = record->end_station_index;
+    uint64_t entity_id = record->entity_id;
+    read_span.set_arg(entity_id);
+
+    // without a registration nothing would have told the cache about changes
+    if(m_config_cache.find(entity_id) && m_config_cache.is_registered(entity_id))
+    {
+        read_span.end();
+        ShowEndStationDetails(entity_id);
+        return;
+    }
+
+    std::shared_ptr<config_builder> builder;
+    command_future read = read_entity_config(*record, builder);
+    if(!builder)
+    {
+        SetStatusText(wxString::Format(wxT("0x%llx is not fully enumerated yet"), (unsigned long long)entity_id));
+        return;
+    }
+
+    SetStatusText(wxString::Format(wxT("Reading configuration of 0x%llx"), (unsigned long long)entity_id));
+
+    // mapping pages are answered on the callback thread; the dialog opens back on the GUI thread
+    std::shared_ptr<std::atomic<bool>> alive = m_alive;
+    read.on_complete([this, alive, entity_id, builder](bool succeeded, const notification_record &record)
+    {
+        // a partial mapping set would be cached as if it were the device's
+        if(!succeeded)
+        {
+            wxString reason = record.notification_type == avdecc_lib::COMMAND_TIMEOUT ? wxString(wxT("timed out")) :
+                              format_command_status(record.cmd_status);
+            call_while_alive(alive, [this, entity_id, reason]()
+            {
+                SetStatusText(wxString::Format(wxT("Reading configuration of 0x%llx failed: %s"),
+                                               (unsigned long long)entity_id, reason));
+            });
+            return;
+        }
+
+        config_snapshot entity_config = builder->build();
+        call_while_alive(alive, [this, entity_id, entity_config]()
+        {
+            m_config_cache.store(entity_id, entity_config);
+            ShowEndStationDetails(entity_id);
+        });
+    });
+}
+
+void AVDECC_Controller::ShowEndStationDetails(uint64_t entity_id)
+{
+    // another row may have been opened while this one was being read
+    const entity_record *record = details_list->get_entity_by_id(entity_id);
+    if(!record || !m_config_cache.find(entity_id))
+        return;
+
+    current_interface_index = record->interface_index;
+    current_end_station_index = record->end_station_index;
+
+    // the dialog shares the cached snapshot; patches to the cache while it is open make new versions
+    const config_snapshot initial = *m_config_cache.find(entity_id);
+
+    details = new end_station_details(this, initial);
+    std::shared_ptr<std::atomic<bool>> alive = m_alive;
+    details->SetLiveApply([this, alive, entity_id](const config_snapshot &from, const config_snapshot &to,
+                                                   const end_station_details::live_done &done)
+    {
+        std::shared_ptr<config_transaction> transaction = build_apply_transaction(entity_id, from, to);
+        if(!transaction || !transaction->get_step_count())
+        {
+            done(true);
+            return;
+        }
+        SetStatusText(wxString::Format(wxT("Applying %u changes to 0x%llx"),
+                                       (unsigned int)transaction->get_step_count(), (unsigned long long)entity_id));
+        transaction->run([this, alive, entity_id, to, done](const transaction_report &report)
+        {
+            call_while_alive(alive, [this, entity_id, to, report, done]()
+            {
+                ReportApply(entity_id, to, report);
+                done(report.outcome == TRANSACTION_COMMITTED);
+            });
+        });
+    });
+    int retval = details->ShowModal();
+    
+    if (retval == wxID_CANCEL)
+    {
+        details->OnCancel();
+        console_log::line("Cancel");
+    }
+    else if (retval == wxID_OK)
+    {
+        details->OnOK();
+        console_log::line("Apply");
+
+        // waits for a live apply still in flight; anything it committed is not sent again
+        details->ApplyAndDestroy();
+    }
+    else
+    {
+        //not supported
+    }
+}
+
+/*
+ * Turns the difference between two snapshots into transaction steps, each
+ * with the value read from the device beforehand as its rollback. Phases
+ * keep the dependencies in order: sampling rate, then stream formats at the
+ * new rate, then mapping removals before additions.
+ */
+std::shared_ptr<config_transaction> AVDECC_Controller::build_apply_transaction(uint64_t entity_id, const config_snapshot &initial,
+                                                                               const config_snapshot &applied)
+{
+    // the device is found by ID; the current row may have changed since the dialog opened
+    avdecc_lib::end_station *end_station;
+    avdecc_lib::configuration_descriptor *configuration;
+    if(get_entity_configuration(entity_id, &end_station, &configuration))
+        return std::shared_ptr<config_transaction>();
+
+    std::shared_ptr<config_transaction> transaction = std::make_shared<config_transaction>(m_commands);
+
+    // rollback formats come from the published record, re-read as each change is flushed
+    const entity_record *record = details_list->get_entity_by_id(entity_id);
+
+    uint32_t new_rate = applied.entity().get_sample_rate();
+    avdecc_lib::audio_unit_descriptor *audio_unit_desc_ref = configuration->get_audio_unit_desc_by_index(0);
+    if(new_rate != initial.entity().get_sample_rate() && audio_unit_desc_ref)
+    {
+        // the snapshot may predate a change made elsewhere, so the rollback rate comes from the device
+        std::shared_ptr<uint32_t> old_rate = std::make_shared<uint32_t>(initial.entity().get_sample_rate());
+        transaction->add_read("GET_SAMPLING_RATE",
+                              [audio_unit_desc_ref](void *id) { return audio_unit_desc_ref->send_get_sampling_rate_cmd(id); },
+                              [audio_unit_desc_ref, old_rate](const notification_record &)
+                              {
+                                  avdecc_lib::audio_unit_get_sampling_rate_response *sampling_rate_resp_ref =
+                                      audio_unit_desc_ref->get_audio_unit_get_sampling_rate_response();
+                                  *old_rate = sampling_rate_resp_ref->get_sampling_rate_sampling_rate();
+                                  delete sampling_rate_resp_ref;
+                              });
+        transaction->add_step(0, "SET_SAMPLING_RATE",
+                              [audio_unit_desc_ref, new_rate](void *id) { return audio_unit_desc_ref->send_set_sampling_rate_cmd(id, new_rate); },
+                              [audio_unit_desc_ref, old_rate](void *id) { return audio_unit_desc_ref->send_set_sampling_rate_cmd(id, *old_rate); });
+    }
+
+    for(unsigned int i = 0; !applied.shares_streams(true, initial) && i < applied.get_stream_input_count(); i++)
+    {
+        if(applied.streams(true)[i].channel_count == initial.streams(true)[i].channel_count)
+            continue;
+
+        avdecc_lib::stream_input_descriptor *stream_input_desc_ref = configuration->get_stream_input_desc_by_index(i);
+        unsigned int format_index = stream_format_index(applied.streams(true)[i].channel_count, new_rate);
+        if(!stream_input_desc_ref || format_index == (unsigned int)-1)
+        {
+            console_log::line("STREAM_INPUT %u: no stream format for %u channels", i, applied.streams(true)[i].channel_count);
+            continue;
+        }
+
+        uint64_t new_format = avdecc_lib::utility::ieee1722_format_index_to_value(format_index);
+        const stream_model *stream = applied.model() ? applied.model()->find_stream(true, i) : NULL;
+        if(stream && !stream->formats.empty() && !stream->supports(new_format))
+        {
+            console_log::line("STREAM_INPUT %u does not support %u channels at %u Hz", i, applied.streams(true)[i].channel_count, new_rate);
+            continue;
+        }
+
+        const entity_stream *current = record ? record->find_stream(true, (uint16_t)i) : NULL;
+        if(!current)
+            continue;
+        uint64_t old_format = avdecc_lib::utility::ieee1722_format_name_to_value(string_pool::get(current->format).utf8_str());
+
+        transaction->add_step(1, std::string(wxString::Format("SET_STREAM_FORMAT STREAM_INPUT %u", i).utf8_str()),
+                              [stream_input_desc_ref, new_format](void *id) { return stream_input_desc_ref->send_set_stream_format_cmd(id, new_format); },
+                              [stream_input_desc_ref, old_format](void *id) { return stream_input_desc_ref->send_set_stream_format_cmd(id, old_format); });
+    }
+
+    for(unsigned int i = 0; !applied.shares_streams(false, initial) && i < applied.get_stream_output_count(); i++)
+    {
+        if(applied.streams(false)[i].channel_count == initial.streams(false)[i].channel_count)
+            continue;
+
+        avdecc_lib::stream_output_descriptor *stream_output_desc_ref = configuration->get_stream_output_desc_by_index(i);
+        unsigned int format_index = stream_format_index(applied.streams(false)[i].channel_count, new_rate);
+        if(!stream_output_desc_ref || format_index == (unsigned int)-1)
+        {
+            console_log::line("STREAM_OUTPUT %u: no stream format for %u channels", i, applied.streams(false)[i].channel_count);
+            continue;
+        }
+
+        uint64_t new_format = avdecc_lib::utility::ieee1722_format_index_to_value(format_index);
+        const stream_model *stream = applied.model() ? applied.model()->find_stream(false, i) : NULL;
+        if(stream && !stream->formats.empty() && !stream->supports(new_format))
+        {
+            console_log::line("STREAM_OUTPUT %u does not support %u channels at %u Hz", i, applied.streams(false)[i].channel_count, new_rate);
+            continue;
+        }
+
+        const entity_stream *current = record ? record->find_stream(false, (uint16_t)i) : NULL;
+        if(!current)
+            continue;
+        uint64_t old_format = avdecc_lib::utility::ieee1722_format_name_to_value(string_pool::get(current->format).utf8_str());
+
+        transaction->add_step(1, std::string(wxString::Format("SET_STREAM_FORMAT STREAM_OUTPUT %u", i).utf8_str()),
+                              [stream_output_desc_ref, new_format](void *id) { return stream_output_desc_ref->send_set_stream_format_cmd(id, new_format); },
+                              [stream_output_desc_ref, old_format](void *id) { return stream_output_desc_ref->send_set_stream_format_cmd(id, old_format); });
+    }
+
+    for(int direction = 0; direction < 2; direction++)
+    {
+        bool input = direction == 0;
+        if(applied.shares_mappings(input, initial))
+            continue;
+
+        avdecc_lib::stream_port_input_descriptor *stream_port_input_desc_ref = NULL;
+        avdecc_lib::stream_port_output_descriptor *stream_port_output_desc_ref = NULL;
+        if(input)
+            stream_port_input_desc_ref = configuration->get_stream_port_input_desc_by_index(0);
+        else
+            stream_port_output_desc_ref = configuration->get_stream_port_output_desc_by_index(0);
+        if(!stream_port_input_desc_ref && !stream_port_output_desc_ref)
+            continue;
+
+        std::vector<audio_mapping> removed;
+        std::vector<audio_mapping> added;
+        audio_mapping_set::diff(initial.mappings(input), applied.mappings(input), removed, added);
+
+        // one step per PDU, each packed with as many mappings as fit
+        for(int pass = 0; pass < 2; pass++)
+        {
+            const std::vector<audio_mapping> &maps = pass == 0 ? removed : added;
+            bool add = pass == 1;
+            for(size_t first = 0; first < maps.size(); first += audio_mapping_set::max_mappings_per_pdu)
+            {
+                std::vector<audio_mapping> chunk(maps.begin() + first,
+                                                 maps.begin() + std::min(maps.size(), first + audio_mapping_set::max_mappings_per_pdu));
+                transaction->add_step(2 + pass, add ? "ADD_AUDIO_MAPPINGS" : "REMOVE_AUDIO_MAPPINGS",
+                                      [stream_port_input_desc_ref, stream_port_output_desc_ref, chunk, add](void *id)
+                                      {
+                                          return send_audio_mappings(stream_port_input_desc_ref, stream_port_output_desc_ref, chunk, add, id);
+                                      },
+                                      [stream_port_input_desc_ref, stream_port_output_desc_ref, chunk, add](void *id)
+                                      {
+                                          return send_audio_mappings(stream_port_input_desc_ref, stream_port_output_desc_ref, chunk, !add, id);
+                                      });
+            }
+        }
+    }
+
+    return transaction;
+}
+
+int AVDECC_Controller::send_audio_mappings(avdecc_lib::stream_port_input_descriptor *stream_port_input_desc_ref,
+                                           avdecc_lib::stream_port_output_descriptor *stream_port_output_desc_ref,
+                                           const std::vector<audio_mapping> &maps, bool add, void *cmd_notification_id)
+{
+    for(size_t i = 0; i < maps.size(); i++)
+    {
+        struct avdecc_lib::audio_map_mapping map;
+        map.stream_index = maps[i].stream_index;
+        map.stream_channel = maps[i].stream_channel;
+        map.cluster_offset = maps[i].cluster_offset;
+        map.cluster_channel = maps[i].cluster_channel;
+        if(stream_port_input_desc_ref)
+            stream_port_input_desc_ref->store_pending_map(map);
+        else
+            stream_port_output_desc_ref->store_pending_map(map);
+    }
+
+    if(stream_port_input_desc_ref && add)
+        return stream_port_input_desc_ref->send_add_audio_mappings_cmd(cmd_notification_id);
+    else if(stream_port_input_desc_ref)
+        return stream_port_input_desc_ref->send_remove_audio_mappings_cmd(cmd_notification_id);
+    else if(add)
+        return stream_port_output_desc_ref->send_add_audio_mappings_cmd(cmd_notification_id);
+    return stream_port_output_desc_ref->send_remove_audio_mappings_cmd(cmd_notification_id);
+}
+
+void AVDECC_Controller::ReportApply(uint64_t entity_id, const config_snapshot &applied, const transaction_report &report)
+{
+    wxString outcome;
+    switch(report.outcome)
+    {
+    case TRANSACTION_COMMITTED:
+        // rate and format changes reach the cache through their SET_* responses
+        m_config_cache.set_audio_mappings(entity_id, true, applied.mappings(true));
+        m_config_cache.set_audio_mappings(entity_id, false, applied.mappings(false));
+        outcome = wxString::Format(wxT("Applied %u changes to 0x%llx in %u ms"), (unsigned int)report.step_count,
+                                   (unsigned long long)entity_id, (unsigned int)report.elapsed_ms);
+        break;
+
+    case TRANSACTION_ROLLED_BACK:
+        outcome = wxString::Format(wxT("Apply to 0x%llx failed at %s (%s); %u changes rolled back"),
+                                   (unsigned long long)entity_id, report.failed_step.c_str(),
+                                   format_command_status(report.failed_status),
+                                   (unsigned int)report.reverted_count);
+        break;
+
+    case TRANSACTION_READ_FAILED:
+        outcome = wxString::Format(wxT("Apply to 0x%llx not sent: reading %s failed (%s)"),
+                                   (unsigned long long)entity_id, report.failed_step.c_str(),
+                                   format_command_status(report.failed_status));
+        break;
+
+    case TRANSACTION_ROLLBACK_FAILED:
+    {
+        std::string failures;
+        for(size_t i = 0; i < report.rollback_failures.size(); i++)
+        {
+            failures += (i ? ", " : "") + report.rollback_failures[i];
+        }
+        outcome = wxString::Format(wxT("Apply to 0x%llx failed at %s (%s); could not roll back %s"),
+                                   (unsigned long long)entity_id, report.failed_step.c_str(),
+                                   format_command_status(report.failed_status),
+                                   failures.c_str());
+        break;
+    }
+    }
+
+    console_log::line("%s", (const char *)outcome.utf8_str());
+    SetStatusText(outcome);
+}
+
+std::shared_ptr<const entity_model> AVDECC_Controller::read_entity_model(uint64_t entity_model_id,
+                                                                         avdecc_lib::configuration_descriptor *configuration)
+{
+    TRACE_SPAN_ARG("callback", "read_entity_model", entity_model_id);
+
+    std::shared_ptr<entity_model> model = std::make_shared<entity_model>(entity_model_id);
+
+    avdecc_lib::strings_descriptor *strings_desc = configuration->get_strings_desc_by_index(0);
+    if(strings_desc)
+    {
+        avdecc_lib::strings_descriptor_response *strings_resp_ref = strings_desc->get_strings_response();
+        for(size_t i = 0; i < entity_model::strings_count; i++)
+        {
+            model->set_string(i, wxString((const char *)strings_resp_ref->get_string_by_index(i)));
+        }
+        delete strings_resp_ref;
+    }
+
+    // streams missing a descriptor keep an empty entry so indices still line up
+    for(uint16_t i = 0; i < configuration->stream_input_desc_count(); i++)
+    {
+        stream_model stream;
+        stream.default_name = 0;
+        avdecc_lib::stream_input_descriptor *stream_input_desc_ref = configuration->get_stream_input_desc_by_index(i);
+        if(stream_input_desc_ref)
+        {
+            avdecc_lib::stream_input_descriptor_response *stream_input_resp_ref = stream_input_desc_ref->get_stream_input_response();
+            stream.default_name = string_pool::intern((const char *)configuration->get_strings_desc_string_by_reference(
+                                                          stream_input_resp_ref->localized_description()));
+            for(uint16_t f = 0; f < stream_input_resp_ref->number_of_formats(); f++)
+            {
+                stream.formats.push_back(stream_input_resp_ref->get_supported_stream_fmt_by_index(f));
+            }
+            delete stream_input_resp_ref;
+        }
+        model->add_stream(true, stream);
+    }
+
+    for(uint16_t i = 0; i < configuration->stream_output_desc_count(); i++)
+    {
+        stream_model stream;
+        stream.default_name = 0;
+        avdecc_lib::stream_output_descriptor *stream_output_desc_ref = configuration->get_stream_output_desc_by_index(i);
+        if(stream_output_desc_ref)
+        {
+            avdecc_lib::stream_output_descriptor_response *stream_output_resp_ref = stream_output_desc_ref->get_stream_output_response();
+            stream.default_name = string_pool::intern((const char *)configuration->get_strings_desc_string_by_reference(
+                                                          stream_output_resp_ref->localized_description()));
+            for(uint16_t f = 0; f < stream_output_resp_ref->number_of_formats(); f++)
+            {
+                stream.formats.push_back(stream_output_resp_ref->get_supported_stream_fmt_by_index(f));
+            }
+            delete stream_output_resp_ref;
+        }
+        model->add_stream(false, stream);
+    }
+
+    console_log::line("Entity model 0x%" PRIx64 ": %u input and %u output streams",
+                      entity_model_id, (unsigned int)model->streams(true).size(), (unsigned int)model->streams(false).size());
+    return model;
+}
+
+/*
+ * Fills a builder from the entity's published record and model, then reads
+ * the audio mappings from the device. The builder is left empty if the
+ * entity is not enumerated yet. The returned future fails if any mapping
+ * page could not be read, in which case the builder holds a partial set and
+ * must not be used.
+ */
+command_future AVDECC_Controller::read_entity_config(const entity_record &record, std::shared_ptr<config_builder> &builder)
+{
+    // the model is read with the entity record once its descriptors are all in
+    std::shared_ptr<const entity_model> model = m_models.find(record.entity_model_id);
+    avdecc_lib::end_station *end_station;
+    avdecc_lib::configuration_descriptor *configuration;
+    if(!record.enumerated || !model || get_entity_configuration(record.entity_id, &end_station, &configuration))
+        return command_future::ready(false, notification_record());
+
+    builder = std::make_shared<config_builder>(end_station_configuration(string_pool::get(record.name), record.entity_id,
+                                                                         model->get_string(1), record.mac,
+                                                                         string_pool::get(record.fw_ver), record.sample_rate));
+    builder->set_model(model);
+
+    for(size_t i = 0; i < record.streams.size(); i++)
+    {
+        struct stream_configuration_details stream_details;
+        stream_details.stream_name = record.streams[i].name;
+        stream_details.channel_count = channel_count_from_format(string_pool::get(record.streams[i].format).utf8_str());
+        builder->add_stream(record.streams[i].input, stream_details);
+    }
+
+    // both directions are read at once, each into its own set
+    std::vector<command_future> reads;
+    reads.push_back(read_audio_mappings(configuration, true, 0, &builder->edit_mappings(true)));
+    reads.push_back(read_audio_mappings(configuration, false, 0, &builder->edit_mappings(false)));
+    return command_future::when_all(reads);
+}
+
+/*
+ * Reads the dynamic mappings of the first stream port in one direction. The
+ * first GET_AUDIO_MAP response says how many pages there are, so each page
+ * is requested from the continuation of the one before. An entity without a
+ * stream port in that direction has no mappings to read, which is not a
+ * failure.
+ */
+command_future AVDECC_Controller::read_audio_mappings(avdecc_lib::configuration_descriptor *configuration, bool input,
+                                                      uint16_t map_index, audio_mapping_set *mappings)
+{
+    avdecc_lib::stream_port_input_descriptor *stream_port_input_desc_ref = NULL;
+    avdecc_lib::stream_port_output_descriptor *stream_port_output_desc_ref = NULL;
+    if(input)
+        stream_port_input_desc_ref = configuration->get_stream_port_input_desc_by_index(0);
+    else
+        stream_port_output_desc_ref = configuration->get_stream_port_output_desc_by_index(0);
+    if(!stream_port_input_desc_ref && !stream_port_output_desc_ref)
+        return command_future::ready(true, notification_record());
+
+    return m_commands.send([stream_port_input_desc_ref, stream_port_output_desc_ref, map_index](void *cmd_notification_id)
+    {
+        if(stream_port_input_desc_ref)
+            return stream_port_input_desc_ref->send_get_audio_map_cmd(cmd_notification_id, map_index);
+        return stream_port_output_desc_ref->send_get_audio_map_cmd(cmd_notification_id, map_index);
+    })
+    .then([this, configuration, input, map_index, mappings,
+           stream_port_input_desc_ref, stream_port_output_desc_ref](const notification_record &record) -> command_future
+    {
+        uint16_t number_of_maps;
+        if(stream_port_input_desc_ref)
+        {
+            avdecc_lib::stream_port_input_get_audio_map_response *audio_map_resp_ref = stream_port_input_desc_ref->get_stream_port_input_audio_map_response();
+            number_of_maps = audio_map_resp_ref->number_of_maps();
+            for(size_t i = 0; i < audio_map_resp_ref->number_of_mappings(); i++)
+            {
+                struct avdecc_lib::audio_map_mapping map;
+                if(audio_map_resp_ref->get_mapping(i, map) == 0)
+                {
+                    audio_mapping mapping = {map.stream_index, map.stream_channel, map.cluster_offset, map.cluster_channel};
+                    mappings->add(mapping);
+                }
+            }
+            delete audio_map_resp_ref;
+        }
+        else
+        {
+            avdecc_lib::stream_port_output_get_audio_map_response *audio_map_resp_ref = stream_port_output_desc_ref->get_stream_port_output_audio_map_response();
+            number_of_maps = audio_map_resp_ref->number_of_maps();
+            for(size_t i = 0; i < audio_map_resp_ref->number_of_mappings(); i++)
+            {
+                struct avdecc_lib::audio_map_mapping map;
+                if(audio_map_resp_ref->get_mapping(i, map) == 0)
+                {
+                    audio_mapping mapping = {map.stream_index, map.stream_channel, map.cluster_offset, map.cluster_channel};
+                    mappings->add(mapping);
+                }
+            }
+            delete audio_map_resp_ref;
+        }
+
+        if(map_index + 1 < number_of_maps)
+            return read_audio_mappings(configuration, input, map_index + 1, mappings);
+        return command_future::ready(true, record);
+    });
+}
+
+int AVDECC_Controller::get_current_entity_and_descriptor(avdecc_lib::end_station *end_station,
+                                                         avdecc_lib::entity_descriptor **entity, avdecc_lib::configuration_descriptor **configuration)
+{
+    *entity = NULL;
+    *configuration = NULL;
+    
+    uint16_t current_entity = end_station->get_current_entity_index();
+    if (current_entity >= end_station->entity_desc_count())
+    {
+        console_log::line("Current entity not available");
+        return 1;
+    }
+    
+    *entity = end_station->get_entity_desc_by_index(current_entity);
+    
+    uint16_t current_config = end_station->get_current_config_index();
+    if (current_config >= (*entity)->config_desc_count())
+    {
+        console_log::line("Current configuration not available");
+        return 1;
+    }
+    
+    *configuration = (*entity)->get_config_desc_by_index(current_config);
+    
+    return 0;
+}
+
+int AVDECC_Controller::get_current_end_station_entity_and_descriptor(avdecc_lib::end_station **end_station,
+                                                                     avdecc_lib::entity_descriptor **entity, avdecc_lib::configuration_descriptor **configuration)
+{
+    if (get_current_end_station(end_station))
+        return 1;
+    
+    if (get_current_entity_and_descriptor(*end_station, entity, configuration))
+    {
+        console_log::line("Current End Station not fully enumerated");
+        return 1;
+    }
+    return 0;
+}
+
+int AVDECC_Controller::get_current_end_station(avdecc_lib::end_station **end_station) const
+{
+    avdecc_lib::controller *controller_obj = current_controller();
+    if (!controller_obj || current_end_station_index >= controller_obj->get_end_station_count())
+    {
+        console_log::line("No End Stations available");
+        *end_station = NULL;
+        return 1;
+    }
+    
+    *end_station = controller_obj->get_end_station_by_index(current_end_station_index);
+    return 0;
+}
+
+int AVDECC_Controller::get_entity_configuration(uint64_t entity_id, avdecc_lib::end_station **end_station,
+                                                avdecc_lib::configuration_descriptor **configuration)
+{
+    *end_station = NULL;
+    *configuration = NULL;
+
+    for(size_t i = 0; i < m_interfaces.size(); i++)
+    {
+        if(m_interfaces[i]->find_end_station(entity_id, end_station, NULL))
+        {
+            avdecc_lib::entity_descriptor *entity;
+            return get_current_entity_and_descriptor(*end_station, &entity, configuration);
+        }
+    }
+    return 1;
+}
+
+wxString AVDECC_Controller::get_stream_name(avdecc_lib::configuration_descriptor *configuration,
+                                            const uint8_t *object_name, uint16_t localized_description)
+{
+    if(object_name[0] == '\0')
+    {
+        return wxString((const char *)configuration->get_strings_desc_string_by_reference(localized_description));
+    }
+    return wxString((const char *)object_name);
+}
+
+void AVDECC_Controller::OnRegistrationTimer(wxTimerEvent& WXUNUSED(event))
+{
+    std::vector<uint64_t> due;
+    m_config_cache.take_due_registrations(notification_coalescer::now_ms(), due);
+
+    for(size_t i = 0; i < due.size(); i++)
+    {
+        register_unsolicited(due[i]);
+    }
+
+    // an END_STATION_CONNECTED lost to a full callback queue would otherwise hide an entity for good
+    size_t end_station_count = 0;
+    for(size_t i = 0; i < m_interfaces.size(); i++)
+    {
+        end_station_count += m_interfaces[i]->get_controller()->get_end_station_count();
+    }
+    if(end_station_count != m_discovered_count)
+    {
+        m_discovered_count = end_station_count;
+        publish_known_entities();
+    }
+}
+
+int AVDECC_Controller::register_unsolicited(uint64_t entity_id)
+{
+    for(size_t i = 0; i < m_interfaces.size(); i++)
+    {
+        avdecc_lib::end_station *end_station;
+        if(m_interfaces[i]->find_end_station(entity_id, &end_station, NULL))
+        {
+            return end_station->send_register_unsolicited_cmd((void *)(intptr_t)get_next_notification_id());
+        }
+    }
+    return -1;
+}
+
+void AVDECC_Controller::ApplyConfigurationChange(const notification_record &record)
+{
+    // the entity was re-read when this was flushed, and the list has picked it up
+    const entity_record *entity = details_list->get_entity_by_id(record.entity_id);
+    if(!entity || !entity->enumerated)
+        return;
+
+    switch(record.cmd_type)
+    {
+        case avdecc_lib::AEM_CMD_SET_SAMPLING_RATE:
+            if(record.desc_index == 0)
+                m_config_cache.set_sample_rate(record.entity_id, entity->sample_rate);
+            break;
+        case avdecc_lib::AEM_CMD_SET_STREAM_FORMAT:
+        case avdecc_lib::AEM_CMD_SET_NAME:
+        {
+            if(record.cmd_type == avdecc_lib::AEM_CMD_SET_NAME && record.desc_type == avdecc_lib::AEM_DESC_ENTITY)
+            {
+                m_config_cache.set_entity_name(record.entity_id, string_pool::get(entity->name));
+                break;
+            }
+            if(record.desc_type != avdecc_lib::AEM_DESC_STREAM_INPUT && record.desc_type != avdecc_lib::AEM_DESC_STREAM_OUTPUT)
+                break;
+
+            bool input = record.desc_type == avdecc_lib::AEM_DESC_STREAM_INPUT;
+            const entity_stream *stream = entity->find_stream(input, record.desc_index);
+            if(!stream)
+                break;
+            if(record.cmd_type == avdecc_lib::AEM_CMD_SET_NAME)
+                m_config_cache.set_stream_name(record.entity_id, input, record.desc_index, string_pool::get(stream->name));
+            else
+                m_config_cache.set_stream_channel_count(record.entity_id, input, record.desc_index,
+                                                        channel_count_from_format(string_pool::get(stream->format).utf8_str()));
+            break;
+        }
+    }
+}
+
+void AVDECC_Controller::OnFilterText(wxCommandEvent& event)
+{
+    details_list->set_filter(event.GetString());
+}
+
+void AVDECC_Controller::OnNotificationTimer(wxTimerEvent& WXUNUSED(event))
+{
+    m_notification_batch.clear();
+    bool notified = coalesced_notifications.flush(m_notification_batch);
+    refresh_notified_entities();
+
+    uint64_t entity_generation = m_entity_generation;
+    CreateEndStationList();
+    if(m_entity_generation != entity_generation)
+    {
+        UpdateConnectionStreams();
+        if(monitor_page->is_enabled())
+            RefreshCounterTargets();
+    }
+
+    if(notified)
+    {
+        ProcessNotifications(m_notification_batch);
+    }
+    event_log.drain();
+    log_page->refresh_records();
+
+    m_listener_poller.tick(notification_coalescer::now_ms(), [this](const acmp_command &command)
+    {
+        m_acmp_queue->enqueue(command);
+    });
+    ProcessAcmpResults();
+
+    if(monitor_page->is_enabled())
+    {
+        m_counter_monitor.tick(notification_coalescer::now_ms(), [this](const counter_target &target)
+        {
+            return send_counter_read(target);
+        });
+    }
+    ProcessCounterResults();
+    ProcessFirmwareUpload();
+    ProcessRollout();
+}
+
+void AVDECC_Controller::ProcessNotifications(const std::vector<notification_record> &records)
+{
+    TRACE_SPAN_ARG("gui", "ProcessNotifications", records.size());
+
+    for(size_t i = 0; i < records.size(); i++)
+    {
+        const notification_record &record = records[i];
+        log_notification(record);
+        bool failed = record.notification_type == avdecc_lib::COMMAND_TIMEOUT || record.notification_type == send_failed_notification ||
+                      (record.notification_type == avdecc_lib::RESPONSE_RECEIVED && record.cmd_status != avdecc_lib::AEM_STATUS_SUCCESS);
+        bool command = record.notification_type == avdecc_lib::COMMAND_TIMEOUT ||
+                       record.notification_type == avdecc_lib::RESPONSE_RECEIVED ||
+                       record.notification_type == avdecc_lib::UNSOLICITED_RESPONSE_RECEIVED;
+        event_log.add_notification(record, command, failed ? avdecc_lib::LOGGING_LEVEL_WARNING : avdecc_lib::LOGGING_LEVEL_INFO,
+                                   notification_coalescer::now_ms());
+
+        if(record.notification_type == avdecc_lib::END_STATION_CONNECTED)
+        {
+            m_config_cache.track(record.entity_id, notification_coalescer::now_ms());
+            m_firmware_rollout.entity_connected(record.entity_id, notification_coalescer::now_ms());
+        }
+        else if(record.notification_type == avdecc_lib::END_STATION_DISCONNECTED)
+        {
+            m_listener_poller.forget(record.entity_id);
+            m_connections.remove_entity(record.entity_id);
+            connection_page->refresh_all();
+            for(std::unordered_map<stream_endpoint, listener_state, stream_endpoint_hash>::iterator it = m_listener_info.begin();
+                it != m_listener_info.end();)
+            {
+                if(it->first.entity_id == record.entity_id)
+                    it = m_listener_info.erase(it);
+                else
+                    ++it;
+            }
+            m_config_cache.remove(record.entity_id);
+            m_counter_history.remove_entity(record.entity_id);
+            m_firmware_rollout.entity_disconnected(record.entity_id);
+        }
+        else if((record.notification_type == avdecc_lib::RESPONSE_RECEIVED ||
+                 record.notification_type == avdecc_lib::COMMAND_TIMEOUT) &&
+                record.cmd_type == avdecc_lib::AEM_CMD_REGISTER_UNSOLICITED_NOTIFICATION)
+        {
+            if(record.notification_type == avdecc_lib::RESPONSE_RECEIVED && record.cmd_status == avdecc_lib::AEM_STATUS_SUCCESS)
+                m_config_cache.registration_succeeded(record.entity_id, notification_coalescer::now_ms());
+            else if(record.notification_type == avdecc_lib::RESPONSE_RECEIVED &&
+                    (record.cmd_status == avdecc_lib::AEM_STATUS_NOT_IMPLEMENTED ||
+                     record.cmd_status == avdecc_lib::AEM_STATUS_NOT_SUPPORTED))
+                m_config_cache.registration_unsupported(record.entity_id);
+            else
+                m_config_cache.registration_failed(record.entity_id);
+        }
+        else if((record.notification_type == avdecc_lib::RESPONSE_RECEIVED ||
+                 record.notification_type == avdecc_lib::UNSOLICITED_RESPONSE_RECEIVED) &&
+                record.cmd_status == avdecc_lib::AEM_STATUS_SUCCESS)
+        {
+            ApplyConfigurationChange(record);
+        }
+    }
+}
+
+void AVDECC_Controller::CreateEndStationListFormat()
+{
+    wxNotebook *notebook = new wxNotebook(this, wxID_ANY, wxDefaultPosition, wxSize(700,200), wxGROW);
+    wxPanel * window1 = new wxPanel(notebook, wxID_ANY, wxDefaultPosition, wxSize(700, 200), wxGROW);
     
     notebook->AddPage(window1, wxT("End Stations"), true, 0);
-    details_list = new wxListCtrl(window1, wxID_ANY, wxDefaultPosition,
-                                  wxSize(700,200), wxLC_REPORT);
+    filter_text = new wxTextCtrl(window1, EndStationFilter, wxEmptyString, wxDefaultPosition, wxSize(700,25));
+    filter_text->SetHint(wxT("Filter by name, entity ID, MAC or firmware version"));
+    details_list = new end_station_list(window1, wxID_ANY, wxDefaultPosition, wxSize(700,200));
+
+    wxSizer *list_sizer = new wxBoxSizer(wxVERTICAL);
+    list_sizer->Add(filter_text, 0, wxGROW);
+    list_sizer->Add(details_list, 1, wxGROW);
+    window1->SetSizer(list_sizer);
     
     wxListItem col0;
     col0.SetId(0);
@@ -512,104 +1718,653 @@ void AVDECC_Controller::CreateEndStationListFormat()
     col4.SetText( _("MAC") );
     col4.SetWidth(150);
     details_list->InsertColumn(4, col4);
+
+    wxListItem col5;
+    col5.SetId(5);
+    col5.SetText( _("Interface") );
+    col5.SetWidth(150);
+    details_list->InsertColumn(5, col5);
     
+    connection_page = new connection_matrix_panel(notebook, &m_connections);
+    connection_page->set_handlers([this]() { RefreshConnectionMatrix(); },
+                                  [this](const stream_endpoint &talker, const stream_endpoint &listener, bool connected)
+                                  {
+                                      ToggleConnection(talker, listener, connected);
+                                  });
+    connection_page->set_listener_formatter([this](const stream_endpoint &listener) { return format_listener_info(listener); });
+    notebook->AddPage(connection_page, wxT("Connections"), false);
+
+    monitor_page = new counter_monitor_panel(notebook, &m_counter_monitor, counter_budget_per_second);
+    monitor_page->set_handlers([this](bool enabled)
+                               {
+                                   if(enabled)
+                                       RefreshCounterTargets();
+                                   else
+                                       m_counter_monitor.set_targets(std::vector<counter_target>(), notification_coalescer::now_ms());
+                                   monitor_page->refresh_targets();
+                               },
+                               [this](int commands_per_second) { m_counter_monitor.set_budget(commands_per_second); });
+    monitor_page->set_formatters([this](const counter_target &target) { return format_counter_target(target); },
+                                 [this](const counter_target &target, const counter_sample &sample)
+                                 {
+                                     return format_counter_sample(target, sample);
+                                 },
+                                 [this](const counter_target &target) { return format_counter_trend(target); });
+    notebook->AddPage(monitor_page, wxT("Monitor"), false);
+
+    rollout_page = new rollout_panel(notebook, &m_firmware_rollout);
+    rollout_page->set_handlers([this]() { StartRollout(); },
+                               [this]()
+                               {
+                                   m_firmware_rollout.abort();
+                                   rollout_page->refresh_devices();
+                               });
+    rollout_page->set_formatter([this](uint64_t entity_id)
+                                {
+                                    const entity_record *record = details_list->get_entity_by_id(entity_id);
+                                    return record ? string_pool::get(record->name) : wxString();
+                                });
+    notebook->AddPage(rollout_page, wxT("Rollout"), false);
+
+    log_page = new log_panel(notebook, &event_log, avdecc_lib::LOGGING_LEVEL_VERBOSE + 1);
+    log_page->set_formatters([this](const log_record &record, long column) { return format_log_cell(record, column); },
+                             [](uint8_t level) { return wxString(avdecc_lib::utility::logging_level_value_to_name(level)); },
+                             [](uint16_t cmd_type)
+                             {
+                                 if(cmd_type < avdecc_lib::CMD_LOOKUP)
+                                     return wxString(avdecc_lib::utility::aem_cmd_value_to_name(cmd_type));
+                                 return wxString(avdecc_lib::utility::acmp_cmd_value_to_name(cmd_type - avdecc_lib::CMD_LOOKUP));
+                             },
+                             [](uint32_t cmd_status)
+                             {
+                                 return wxString::Format("%s (%u)", avdecc_lib::utility::aem_cmd_status_value_to_name(cmd_status),
+                                                         cmd_status);
+                             });
+    notebook->AddPage(log_page, wxT("Log"), false);
+
     wxSizer *sizer2 = new wxBoxSizer(wxVERTICAL);
     sizer2->Add(notebook, 1, wxGROW);
     
     SetSizer(sizer2);
 }
 
-uint32_t AVDECC_Controller::get_next_notification_id()
+/*
+ * Reads every listener's state now instead of waiting for the poller to
+ * come round to it.
+ */
+void AVDECC_Controller::RefreshConnectionMatrix()
+{
+    TRACE_SPAN("gui", "RefreshConnectionMatrix");
+
+    UpdateConnectionStreams();
+
+    const std::vector<matrix_stream> &listeners = connection_page->get_table()->get_listeners();
+    for(size_t i = 0; i < listeners.size(); i++)
+    {
+        acmp_command command;
+        command.type = ACMP_GET_RX_STATE;
+        command.talker = stream_endpoint();
+        command.listener = listeners[i].endpoint;
+        m_acmp_queue->enqueue(command);
+    }
+}
+
+/*
+ * Lists the talker and listener streams of every connected entity and hands
+ * the listeners to the poller. Called whenever the entity table changes.
+ */
+void AVDECC_Controller::UpdateConnectionStreams()
+{
+    TRACE_SPAN("gui", "UpdateConnectionStreams");
+
+    std::vector<matrix_stream> talkers;
+    std::vector<matrix_stream> listeners;
+
+    for(size_t slot = 0; slot < details_list->get_entity_count(); slot++)
+    {
+        const entity_record &record = details_list->get_entity(slot);
+        // a departed entity keeps its row in the list, but its streams are gone
+        if(record.connection_status != 'C')
+            continue;
+
+        for(size_t i = 0; i < record.streams.size(); i++)
+        {
+            matrix_stream stream;
+            stream.endpoint.entity_id = record.entity_id;
+            stream.endpoint.stream_index = record.streams[i].stream_index;
+            stream.entity_name = record.name;
+            stream.stream_name = record.streams[i].name;
+            if(record.streams[i].input)
+                listeners.push_back(stream);
+            else
+                talkers.push_back(stream);
+        }
+    }
+
+    connection_page->set_streams(talkers, listeners);
+
+    std::vector<stream_endpoint> listener_endpoints;
+    for(size_t i = 0; i < listeners.size(); i++)
+    {
+        listener_endpoints.push_back(listeners[i].endpoint);
+    }
+    m_listener_poller.set_listeners(listener_endpoints);
+
+    connection_page->set_status(wxString::Format(wxT("%u talker streams, %u listener streams"),
+                                                 (unsigned int)talkers.size(), (unsigned int)listeners.size()));
+}
+
+void AVDECC_Controller::ToggleConnection(const stream_endpoint &talker, const stream_endpoint &listener, bool connected)
 {
-    return (uint32_t)notification_id++;
+    acmp_command command;
+    command.type = connected ? ACMP_DISCONNECT_RX : ACMP_CONNECT_RX;
+    command.talker = talker;
+    command.listener = listener;
+    m_acmp_queue->enqueue(command);
 }
 
-int AVDECC_Controller::cmd_set_sampling_rate(uint32_t new_sampling_rate)
+int AVDECC_Controller::send_acmp_command(const acmp_command &command, void *cmd_notification_id)
 {
-    avdecc_lib::end_station *end_station = controller_obj->get_end_station_by_index(current_end_station_index);
-    avdecc_lib::entity_descriptor *entity;
+    avdecc_lib::end_station *end_station;
     avdecc_lib::configuration_descriptor *configuration;
-    get_current_entity_and_descriptor(end_station, &entity, &configuration);
+    if(get_entity_configuration(command.listener.entity_id, &end_station, &configuration))
+        return -1;
 
-    intptr_t cmd_notification_id = get_next_notification_id();
-    sys->set_wait_for_next_cmd((void *)cmd_notification_id);
-    avdecc_lib::audio_unit_descriptor *audio_unit_desc_ref = configuration->get_audio_unit_desc_by_index(0);
-    audio_unit_desc_ref->send_set_sampling_rate_cmd((void *)cmd_notification_id, new_sampling_rate);
-    int status = sys->get_last_resp_status();
-    
-    if(status == avdecc_lib::AEM_STATUS_SUCCESS)
+    avdecc_lib::stream_input_descriptor *stream_input_desc_ref = configuration->get_stream_input_desc_by_index(command.listener.stream_index);
+    if(!stream_input_desc_ref)
+        return -1;
+
+    TRACE_SPAN_ARG("command", "send_acmp_command", (uint64_t)(intptr_t)cmd_notification_id);
+
+    switch(command.type)
     {
-        avdecc_lib::audio_unit_descriptor_response *audio_unit_resp_ref = audio_unit_desc_ref->get_audio_unit_response();
-        std::cout << "Sampling rate: " << std::dec << audio_unit_resp_ref->current_sampling_rate();
-        delete audio_unit_resp_ref;
+        case ACMP_CONNECT_RX:
+            return stream_input_desc_ref->send_connect_rx_cmd(cmd_notification_id, command.talker.entity_id,
+                                                              command.talker.stream_index, 0);
+        case ACMP_DISCONNECT_RX:
+            return stream_input_desc_ref->send_disconnect_rx_cmd(cmd_notification_id, command.talker.entity_id,
+                                                                 command.talker.stream_index);
+        case ACMP_GET_RX_STATE:
+            return stream_input_desc_ref->send_get_rx_state_cmd(cmd_notification_id);
+        case AEM_GET_STREAM_INFO:
+            return stream_input_desc_ref->send_get_stream_info_cmd(cmd_notification_id);
     }
+    return -1;
+}
 
-    return 0;
+bool AVDECC_Controller::read_listener_state(acmp_result &result)
+{
+    const acmp_command &command = result.command;
+
+    if(command.type == ACMP_CONNECT_RX || command.type == ACMP_DISCONNECT_RX)
+    {
+        m_listener_poller.invalidate(command.listener);
+        return true;
+    }
+
+    // failed polls are retried on the next cycle without bothering the GUI
+    if(result.notification_type != avdecc_lib::RESPONSE_RECEIVED)
+        return false;
+    if(command.type == ACMP_GET_RX_STATE && result.status != avdecc_lib::ACMP_STATUS_SUCCESS)
+        return false;
+    if(command.type == AEM_GET_STREAM_INFO && result.status != avdecc_lib::AEM_STATUS_SUCCESS)
+        return false;
+
+    avdecc_lib::end_station *end_station;
+    avdecc_lib::configuration_descriptor *configuration;
+    if(get_entity_configuration(command.listener.entity_id, &end_station, &configuration))
+        return false;
+
+    avdecc_lib::stream_input_descriptor *stream_input_desc_ref = configuration->get_stream_input_desc_by_index(command.listener.stream_index);
+    if(!stream_input_desc_ref)
+        return false;
+
+    if(command.type == ACMP_GET_RX_STATE)
+    {
+        avdecc_lib::stream_input_get_rx_state_response *rx_state_resp = stream_input_desc_ref->get_stream_input_get_rx_state_response();
+        result.state.connection_count = rx_state_resp->get_rx_state_connection_count();
+        result.state.connected = result.state.connection_count > 0;
+        if(result.state.connected)
+        {
+            result.state.talker.entity_id = rx_state_resp->get_rx_state_talker_entity_id();
+            result.state.talker.stream_index = rx_state_resp->get_rx_state_talker_unique_id();
+        }
+        delete rx_state_resp;
+    }
+    else
+    {
+        avdecc_lib::stream_input_get_stream_info_response *stream_info_resp = stream_input_desc_ref->get_stream_input_get_stream_info_response();
+        result.state.stream_info_flags = stream_info_resp->get_stream_info_flags();
+        result.state.stream_format = stream_info_resp->get_stream_info_stream_format();
+        result.state.stream_id = stream_info_resp->get_stream_info_stream_id();
+        delete stream_info_resp;
+    }
+
+    return m_listener_poller.update_snapshot(command, result.state);
+}
+
+void AVDECC_Controller::ProcessAcmpResults()
+{
+    m_acmp_results.clear();
+    if(!m_acmp_queue->take_results(m_acmp_results))
+    {
+        m_acmp_queue->pump();
+        return;
+    }
+
+    TRACE_SPAN_ARG("gui", "ProcessAcmpResults", m_acmp_results.size());
+
+    bool many_changed = m_acmp_results.size() > 64;
+
+    for(size_t i = 0; i < m_acmp_results.size(); i++)
+    {
+        const acmp_result &result = m_acmp_results[i];
+        const acmp_command &command = result.command;
+
+        if(result.notification_type != avdecc_lib::RESPONSE_RECEIVED || result.status != avdecc_lib::ACMP_STATUS_SUCCESS)
+        {
+            console_log::line("Stream command %s failed for listener 0x%" PRIx64 ":%u",
+                              acmp_command_name(command.type),
+                              command.listener.entity_id, command.listener.stream_index);
+            continue;
+        }
+
+        bool changed = false;
+        switch(command.type)
+        {
+            case ACMP_CONNECT_RX:
+                changed = m_connections.connect(command.talker, command.listener);
+                break;
+            case ACMP_DISCONNECT_RX:
+                changed = m_connections.disconnect(command.listener);
+                break;
+            case ACMP_GET_RX_STATE:
+                if(result.state.connected)
+                    changed = m_connections.connect(result.state.talker, command.listener);
+                else
+                    changed = m_connections.disconnect(command.listener);
+                break;
+            case AEM_GET_STREAM_INFO:
+                // only stream info that differs from the last poll gets this far
+                m_listener_info[command.listener] = result.state;
+                changed = true;
+                break;
+        }
+
+        if(changed && !many_changed)
+        {
+            connection_page->refresh_listener(command.listener);
+        }
+    }
+
+    if(many_changed)
+    {
+        connection_page->refresh_all();
+    }
+
+    m_acmp_queue->pump();
+    connection_page->set_status(wxString::Format(wxT("%u connections, %u commands queued, %u in flight"),
+                                                 (unsigned int)m_connections.size(),
+                                                 (unsigned int)m_acmp_queue->get_queued_count(),
+                                                 (unsigned int)m_acmp_queue->get_in_flight_count()));
 }
 
-int AVDECC_Controller::cmd_set_stream_format(wxString desc_name, uint16_t desc_index, unsigned int stream_format_index)
+void AVDECC_Controller::RefreshCounterTargets()
 {
-    std::string stream_format;
-    uint64_t stream_format_value = avdecc_lib::utility::ieee1722_format_index_to_value(stream_format_index);
+    TRACE_SPAN("gui", "RefreshCounterTargets");
+
+    std::vector<counter_target> targets;
+
+    for(size_t slot = 0; slot < details_list->get_entity_count(); slot++)
+    {
+        const entity_record &record = details_list->get_entity(slot);
+        if(!record.enumerated || record.connection_status != 'C')
+            continue;
+
+        counter_target target;
+        target.entity_id = record.entity_id;
+
+        target.desc_type = avdecc_lib::AEM_DESC_AVB_INTERFACE;
+        for(uint16_t i = 0; i < record.avb_interface_count; i++)
+        {
+            target.desc_index = i;
+            targets.push_back(target);
+        }
+        target.desc_type = avdecc_lib::AEM_DESC_STREAM_INPUT;
+        for(size_t i = 0; i < record.streams.size(); i++)
+        {
+            if(!record.streams[i].input)
+                continue;
+            target.desc_index = record.streams[i].stream_index;
+            targets.push_back(target);
+        }
+        target.desc_type = avdecc_lib::AEM_DESC_CLOCK_DOMAIN;
+        for(uint16_t i = 0; i < record.clock_domain_count; i++)
+        {
+            target.desc_index = i;
+            targets.push_back(target);
+        }
+    }
+
+    m_counter_monitor.set_targets(targets, notification_coalescer::now_ms());
+    monitor_page->refresh_targets();
+}
 
-    uint16_t desc_type_value = avdecc_lib::utility::aem_desc_name_to_value(desc_name.c_str());
+int AVDECC_Controller::send_counter_read(const counter_target &target)
+{
     avdecc_lib::end_station *end_station;
-    avdecc_lib::entity_descriptor *entity;
     avdecc_lib::configuration_descriptor *configuration;
-    if (get_current_end_station_entity_and_descriptor(&end_station, &entity, &configuration))
-        return 0;
-    
-    if(desc_type_value == avdecc_lib::AEM_DESC_STREAM_INPUT)
+    if(get_entity_configuration(target.entity_id, &end_station, &configuration))
+        return -1;
+
+    void *cmd_notification_id = (void *)(intptr_t)get_next_notification_id();
+    TRACE_SPAN_ARG("command", "GET_COUNTERS", (uint64_t)(intptr_t)cmd_notification_id);
+    pending_commands.add(cmd_notification_id, [this, target](const notification_record &record)
+    {
+        read_counters(target, record);
+    });
+
+    int status = -1;
+    if(target.desc_type == avdecc_lib::AEM_DESC_AVB_INTERFACE)
+    {
+        avdecc_lib::avb_interface_descriptor *avb_interface_desc_ref = configuration->get_avb_interface_desc_by_index(target.desc_index);
+        if(avb_interface_desc_ref)
+            status = avb_interface_desc_ref->send_get_counters_cmd(cmd_notification_id);
+    }
+    else if(target.desc_type == avdecc_lib::AEM_DESC_STREAM_INPUT)
+    {
+        avdecc_lib::stream_input_descriptor *stream_input_desc_ref = configuration->get_stream_input_desc_by_index(target.desc_index);
+        if(stream_input_desc_ref)
+            status = stream_input_desc_ref->send_get_counters_cmd(cmd_notification_id);
+    }
+    else if(target.desc_type == avdecc_lib::AEM_DESC_CLOCK_DOMAIN)
+    {
+        avdecc_lib::clock_domain_descriptor *clock_domain_desc_ref = configuration->get_clock_domain_desc_by_index(target.desc_index);
+        if(clock_domain_desc_ref)
+            status = clock_domain_desc_ref->send_get_counters_cmd(cmd_notification_id);
+    }
+
+    if(status != 0)
+        pending_commands.cancel(cmd_notification_id);
+    return status;
+}
+
+/*
+ * Runs on the callback thread; the sample is handed to the GUI thread by
+ * ProcessCounterResults.
+ */
+void AVDECC_Controller::read_counters(const counter_target &target, const notification_record &record)
+{
+    avdecc_lib::end_station *end_station;
+    avdecc_lib::configuration_descriptor *configuration;
+    if(record.notification_type != avdecc_lib::RESPONSE_RECEIVED || record.cmd_status != avdecc_lib::AEM_STATUS_SUCCESS ||
+       get_entity_configuration(target.entity_id, &end_station, &configuration))
+    {
+        std::lock_guard<std::mutex> guard(m_counter_lock);
+        m_counter_failures.push_back(target);
+        return;
+    }
+
+    counter_sample sample = counter_sample();
+    sample.target = target;
+
+    // the descriptor can be gone if the entity was re-enumerated while the read was out
+    bool found = false;
+    if(target.desc_type == avdecc_lib::AEM_DESC_AVB_INTERFACE)
     {
-        intptr_t cmd_notification_id = get_next_notification_id();
-        sys->set_wait_for_next_cmd((void *)cmd_notification_id);
-        avdecc_lib::stream_input_descriptor *stream_input_desc_ref = configuration->get_stream_input_desc_by_index(desc_index);
-        stream_input_desc_ref->send_set_stream_format_cmd((void *)cmd_notification_id, stream_format_value);
-        int status = sys->get_last_resp_status();
-        
-        if(status == avdecc_lib::AEM_STATUS_SUCCESS)
+        avdecc_lib::avb_interface_descriptor *avb_interface_desc_ref = configuration->get_avb_interface_desc_by_index(target.desc_index);
+        if(avb_interface_desc_ref)
         {
-            avdecc_lib::stream_input_descriptor_response *stream_input_resp_ref = stream_input_desc_ref->get_stream_input_response();
-            stream_format = stream_input_resp_ref->current_format();
-            if(stream_format == "UNKNOWN")
-            {
-                atomic_cout << "Stream format: 0x" << std::hex << stream_input_resp_ref->current_format() << std::endl;
-            }
-            else
+            found = true;
+            avdecc_lib::avb_interface_counters_response *counters_resp = avb_interface_desc_ref->get_avb_interface_counters_response();
+            for(int name = 0; name < (int)(sizeof(avb_interface_counter_names) / sizeof(avb_interface_counter_names[0])); name++)
             {
-                atomic_cout << "Stream format: " << stream_format << std::endl;
+                if(counters_resp->get_counter_valid(name))
+                {
+                    sample.valid |= 1u << name;
+                    sample.values[name] = counters_resp->get_counter_by_name(name);
+                }
             }
-            delete stream_input_resp_ref;
+            delete counters_resp;
         }
     }
-    else if(desc_type_value == avdecc_lib::AEM_DESC_STREAM_OUTPUT)
+    else if(target.desc_type == avdecc_lib::AEM_DESC_STREAM_INPUT)
     {
-        intptr_t cmd_notification_id = get_next_notification_id();
-        sys->set_wait_for_next_cmd((void *)cmd_notification_id);
-        avdecc_lib::stream_output_descriptor *stream_output_desc_ref = configuration->get_stream_output_desc_by_index(desc_index);
-        stream_output_desc_ref->send_set_stream_format_cmd((void *)cmd_notification_id, stream_format_value);
-        int status = sys->get_last_resp_status();
-        
-        if(status == avdecc_lib::AEM_STATUS_SUCCESS)
+        avdecc_lib::stream_input_descriptor *stream_input_desc_ref = configuration->get_stream_input_desc_by_index(target.desc_index);
+        if(stream_input_desc_ref)
         {
-            avdecc_lib::stream_output_descriptor_response *stream_output_resp_ref = stream_output_desc_ref->get_stream_output_response();
-            stream_format = stream_output_resp_ref->current_format();
-            if(stream_format == "UNKNOWN")
+            found = true;
+            avdecc_lib::stream_input_counters_response *counters_resp = stream_input_desc_ref->get_stream_input_counters_response();
+            for(int name = 0; name < (int)(sizeof(stream_input_counter_names) / sizeof(stream_input_counter_names[0])); name++)
             {
-                atomic_cout << "Stream format: 0x" << std::hex << stream_output_resp_ref->current_format() << std::endl;
+                if(counters_resp->get_counter_valid(name))
+                {
+                    sample.valid |= 1u << name;
+                    sample.values[name] = counters_resp->get_counter_by_name(name);
+                }
             }
-            else
+            delete counters_resp;
+        }
+    }
+    else if(target.desc_type == avdecc_lib::AEM_DESC_CLOCK_DOMAIN)
+    {
+        avdecc_lib::clock_domain_descriptor *clock_domain_desc_ref = configuration->get_clock_domain_desc_by_index(target.desc_index);
+        if(clock_domain_desc_ref)
+        {
+            found = true;
+            avdecc_lib::clock_domain_counters_response *counters_resp = clock_domain_desc_ref->get_clock_domain_counters_response();
+            for(int name = 0; name < (int)(sizeof(clock_domain_counter_names) / sizeof(clock_domain_counter_names[0])); name++)
             {
-                atomic_cout << "Stream format: " << stream_format << std::endl;
+                if(counters_resp->get_counter_valid(name))
+                {
+                    sample.valid |= 1u << name;
+                    sample.values[name] = counters_resp->get_counter_by_name(name);
+                }
             }
-            delete stream_output_resp_ref;
+            delete counters_resp;
         }
     }
+
+    std::lock_guard<std::mutex> guard(m_counter_lock);
+    if(found)
+        m_counter_samples.push_back(sample);
     else
+        m_counter_failures.push_back(target);
+}
+
+void AVDECC_Controller::ProcessCounterResults()
+{
+    std::vector<counter_sample> samples;
+    std::vector<counter_target> failures;
     {
-        atomic_cout << "cmd_set_stream_format error" << std::endl;
+        std::lock_guard<std::mutex> guard(m_counter_lock);
+        samples.swap(m_counter_samples);
+        failures.swap(m_counter_failures);
     }
-    
-    return 0;
+    if(samples.empty() && failures.empty())
+        return;
+
+    TRACE_SPAN_ARG("gui", "ProcessCounterResults", samples.size());
+
+    uint64_t now_ms = notification_coalescer::now_ms();
+    for(size_t i = 0; i < samples.size(); i++)
+    {
+        bool changed;
+        size_t index = m_counter_monitor.report(samples[i], now_ms, changed);
+        if(index == counter_monitor::npos)
+            continue;
+        m_counter_history.append(samples[i], now_ms);
+        if(changed)
+            monitor_page->refresh_target(index);
+    }
+    for(size_t i = 0; i < failures.size(); i++)
+    {
+        m_counter_monitor.report_failure(failures[i], now_ms);
+    }
+
+    monitor_page->set_status(wxString::Format(wxT("%u targets, %d commands/s budget, %u series (%u KB history)"),
+                                              (unsigned int)m_counter_monitor.get_target_count(),
+                                              (int)m_counter_monitor.get_budget(),
+                                              (unsigned int)m_counter_history.get_series_count(),
+                                              (unsigned int)(m_counter_history.get_memory_bytes() / 1024)));
+}
+
+wxString AVDECC_Controller::format_counter_target(const counter_target &target) const
+{
+    return wxString::Format("%s %u", avdecc_lib::utility::aem_desc_value_to_name(target.desc_type), target.desc_index);
+}
+
+wxString AVDECC_Controller::format_counter_sample(const counter_target &target, const counter_sample &sample) const
+{
+    const char **names = NULL;
+    size_t count = 0;
+    if(target.desc_type == avdecc_lib::AEM_DESC_AVB_INTERFACE)
+    {
+        names = avb_interface_counter_names;
+        count = sizeof(avb_interface_counter_names) / sizeof(avb_interface_counter_names[0]);
+    }
+    else if(target.desc_type == avdecc_lib::AEM_DESC_STREAM_INPUT)
+    {
+        names = stream_input_counter_names;
+        count = sizeof(stream_input_counter_names) / sizeof(stream_input_counter_names[0]);
+    }
+    else if(target.desc_type == avdecc_lib::AEM_DESC_CLOCK_DOMAIN)
+    {
+        names = clock_domain_counter_names;
+        count = sizeof(clock_domain_counter_names) / sizeof(clock_domain_counter_names[0]);
+    }
+
+    wxString text;
+    for(size_t i = 0; i < count; i++)
+    {
+        if(sample.valid & (1u << i))
+            text += wxString::Format("%s=%u ", names[i], sample.values[i]);
+    }
+    return text;
+}
+
+/*
+ * Sparkline of how much the target's busiest counter moved in each step
+ * of the trend window.
+ */
+wxString AVDECC_Controller::format_counter_trend(const counter_target &target) const
+{
+    static const wxString bars[] = {wxString::FromUTF8("\xe2\x96\x81"), wxString::FromUTF8("\xe2\x96\x82"),
+                                    wxString::FromUTF8("\xe2\x96\x83"), wxString::FromUTF8("\xe2\x96\x84"),
+                                    wxString::FromUTF8("\xe2\x96\x85"), wxString::FromUTF8("\xe2\x96\x86"),
+                                    wxString::FromUTF8("\xe2\x96\x87"), wxString::FromUTF8("\xe2\x96\x88")};
+
+    uint64_t now_ms = notification_coalescer::now_ms();
+    uint64_t step_ms = counter_trend_window_ms / counter_trend_points;
+    std::vector<uint64_t> steps;
+    uint64_t busiest = 0;
+
+    for(uint8_t counter = 0; counter < counter_sample::max_counters; counter++)
+    {
+        counter_history::series_id id;
+        if(!m_counter_history.find_series(target, counter, id))
+            continue;
+
+        std::vector<counter_history::point> points;
+        m_counter_history.query(id, now_ms - counter_trend_window_ms, now_ms, 0, points);
+        if(points.size() < 2)
+            continue;
+
+        std::vector<uint64_t> counter_steps(counter_trend_points, 0);
+        for(size_t i = 1; i < points.size(); i++)
+        {
+            size_t step = (size_t)((points[i].time_ms - (now_ms - counter_trend_window_ms)) / step_ms);
+            if(step < counter_trend_points && points[i].value > points[i - 1].value)
+                counter_steps[step] += points[i].value - points[i - 1].value;
+        }
+
+        uint64_t total = points.back().value - points.front().value;
+        if(total > busiest)
+        {
+            busiest = total;
+            steps.swap(counter_steps);
+        }
+    }
+
+    if(steps.empty())
+        return wxEmptyString;
+
+    uint64_t peak = *std::max_element(steps.begin(), steps.end());
+    wxString text;
+    for(size_t i = 0; i < steps.size(); i++)
+    {
+        text += bars[peak ? steps[i] * 7 / peak : 0];
+    }
+    return text;
+}
+
+/*
+ * Stream info from the last GET_STREAM_INFO poll, shown after the listener's
+ * row label.
+ */
+wxString AVDECC_Controller::format_listener_info(const stream_endpoint &listener) const
+{
+    std::unordered_map<stream_endpoint, listener_state, stream_endpoint_hash>::const_iterator it = m_listener_info.find(listener);
+    if(it == m_listener_info.end())
+        return wxString();
+
+    const listener_state &state = it->second;
+    return wxString::Format("[%u ch, stream 0x%llx, flags 0x%x]", stream_format_channel_count(state.stream_format),
+                            (unsigned long long)state.stream_id, state.stream_info_flags);
+}
+
+wxString AVDECC_Controller::format_log_cell(const log_record &record, long column) const
+{
+    bool notification = record.kind == log_store::KIND_NOTIFICATION;
+    bool aem = record.cmd_type < avdecc_lib::CMD_LOOKUP;
+    bool command = record.command;
+
+    switch(column)
+    {
+        case 0:
+            return wxString::Format("%.3f", (record.time_ms - process_start_ms) / 1000.0);
+        case 1:
+            return avdecc_lib::utility::logging_level_value_to_name(record.level);
+        case 2:
+            return notification ? wxString::Format("0x%llx", (unsigned long long)record.entity_id) : wxString();
+        case 3:
+            if(!notification)
+                return wxT("LOG");
+            if(record.notification_type == send_failed_notification)
+                return wxT("SEND_FAILED");
+            return avdecc_lib::utility::notification_value_to_name(record.notification_type);
+        case 4:
+            if(!command)
+                return wxString();
+            if(aem)
+                return avdecc_lib::utility::aem_cmd_value_to_name(record.cmd_type);
+            return avdecc_lib::utility::acmp_cmd_value_to_name(record.cmd_type - avdecc_lib::CMD_LOOKUP);
+        case 5:
+            if(!command || !aem)
+                return wxString();
+            return wxString::Format("%s %u", avdecc_lib::utility::aem_desc_value_to_name(record.desc_type), record.desc_index);
+        case 6:
+            if(!command)
+                return wxString();
+            if(aem)
+                return avdecc_lib::utility::aem_cmd_status_value_to_name(record.cmd_status);
+            return avdecc_lib::utility::acmp_cmd_status_value_to_name(record.cmd_status);
+        case 7:
+        {
+            if(notification)
+                return record.repeat_count > 1 ? wxString::Format("x%u", record.repeat_count) : wxString();
+            std::string text;
+            if(!event_log.get_text(record, text))
+                return wxT("(overwritten)");
+            return wxString::FromUTF8(text.c_str());
+        }
+    }
+    return wxString();
+}
+
+uint32_t AVDECC_Controller::get_next_notification_id()
+{
+    // commands are sent from the GUI thread and from continuations on the callback threads
+    return (uint32_t)notification_id.fetch_add(1);
 }
 
@@ -0,0 +1,180 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * avdecc_interface.cpp
+ *
+ */
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+#include "end_station.h"
+#include "controller.h"
+#include "system.h"
+#include "net_interface.h"
+#include "avdecc_interface.h"
+
+avdecc_interface::avdecc_interface(uint32_t interface_num)
+{
+    m_interface_num = interface_num;
+    m_name = wxString::Format("if%u", interface_num);
+    m_netif = NULL;
+    m_controller = NULL;
+    m_sys = NULL;
+}
+
+avdecc_interface::~avdecc_interface()
+{
+    close();
+}
+
+int avdecc_interface::open(avdecc_notification_callback notification_cb, avdecc_log_callback log_cb, int32_t log_level)
+{
+    m_netif = avdecc_lib::create_net_interface();
+    if(m_interface_num == 0 || m_interface_num > m_netif->devs_count())
+    {
+        m_netif->destroy();
+        m_netif = NULL;
+        return -1;
+    }
+
+    const char *desc = m_netif->get_dev_desc_by_index(m_interface_num - 1);
+    if(desc && desc[0] != '\0')
+    {
+        m_name = wxString::Format("%u: %s", m_interface_num, desc);
+    }
+
+    if(m_netif->select_interface_by_num(m_interface_num) < 0)
+    {
+        m_netif->destroy();
+        m_netif = NULL;
+        return -1;
+    }
+
+    m_controller = avdecc_lib::create_controller(m_netif, notification_cb, log_cb, log_level);
+    m_sys = avdecc_lib::create_system(avdecc_lib::system::LAYER2_MULTITHREADED_CALLBACK, m_netif, m_controller);
+    m_sys->process_start();
+    return 0;
+}
+
+void avdecc_interface::close()
+{
+    if(m_sys)
+    {
+        m_sys->process_close();
+        m_sys->destroy();
+        m_sys = NULL;
+    }
+    if(m_controller)
+    {
+        m_controller->destroy();
+        m_controller = NULL;
+    }
+    if(m_netif)
+    {
+        m_netif->destroy();
+        m_netif = NULL;
+    }
+}
+
+bool avdecc_interface::is_open() const
+{
+    return m_sys != NULL;
+}
+
+uint32_t avdecc_interface::get_interface_num() const
+{
+    return m_interface_num;
+}
+
+const wxString & avdecc_interface::get_name() const
+{
+    return m_name;
+}
+
+avdecc_lib::controller * avdecc_interface::get_controller() const
+{
+    return m_controller;
+}
+
+avdecc_lib::system * avdecc_interface::get_system() const
+{
+    return m_sys;
+}
+
+bool avdecc_interface::find_end_station(uint64_t entity_id, avdecc_lib::end_station **end_station,
+                                        uint32_t *end_station_index) const
+{
+    if(!m_controller)
+        return false;
+
+    uint32_t index;
+    if(!m_controller->is_end_station_found_by_entity_id(entity_id, index))
+        return false;
+
+    if(end_station)
+        *end_station = m_controller->get_end_station_by_index(index);
+    if(end_station_index)
+        *end_station_index = index;
+    return true;
+}
+
+std::vector<uint32_t> avdecc_interface::parse_interface_list(const char *list)
+{
+    std::vector<uint32_t> nums;
+
+    if(!list || list[0] == '\0')
+    {
+        nums.push_back(1);
+        return nums;
+    }
+
+    if(strcmp(list, "all") == 0)
+    {
+        avdecc_lib::net_interface *netif = avdecc_lib::create_net_interface();
+        for(uint32_t i = 1; i <= netif->devs_count(); i++)
+            nums.push_back(i);
+        netif->destroy();
+        return nums;
+    }
+
+    const char *p = list;
+    while(*p)
+    {
+        char *end;
+        unsigned long num = strtoul(p, &end, 10);
+        if(end == p)
+        {
+            p++;
+            continue;
+        }
+        if(num > 0 && std::find(nums.begin(), nums.end(), (uint32_t)num) == nums.end())
+            nums.push_back((uint32_t)num);
+        p = end;
+    }
+
+    if(nums.empty())
+        nums.push_back(1);
+    return nums;
+}
@@ -0,0 +1,176 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * command_future.cpp
+ *
+ */
+
+#include "command_future.h"
+#include "trace_log.h"
+
+command_future::command_future() : m_state(new state())
+{
+    m_state->done = false;
+    m_state->succeeded = false;
+    m_state->record = notification_record();
+}
+
+command_future command_future::ready(bool succeeded, const notification_record &record)
+{
+    command_future future;
+    future.resolve(succeeded, record);
+    return future;
+}
+
+command_future command_future::when_all(const std::vector<command_future> &futures)
+{
+    struct join
+    {
+        std::mutex lock;
+        size_t remaining;
+        bool succeeded;
+        notification_record record;
+    };
+
+    command_future result;
+    if(futures.empty())
+    {
+        result.resolve(true, notification_record());
+        return result;
+    }
+
+    std::shared_ptr<join> pending(new join());
+    pending->remaining = futures.size();
+    pending->succeeded = true;
+    pending->record = notification_record();
+
+    for(size_t i = 0; i < futures.size(); i++)
+    {
+        futures[i].on_complete([result, pending](bool succeeded, const notification_record &record)
+        {
+            bool last;
+            {
+                std::lock_guard<std::mutex> guard(pending->lock);
+                if(pending->succeeded)
+                {
+                    pending->succeeded = succeeded;
+                    pending->record = record;
+                }
+                last = --pending->remaining == 0;
+            }
+            if(last)
+                result.resolve(pending->succeeded, pending->record);
+        });
+    }
+    return result;
+}
+
+bool command_future::is_ready() const
+{
+    std::lock_guard<std::mutex> guard(m_state->lock);
+    return m_state->done;
+}
+
+command_future command_future::then(const continuation &next) const
+{
+    command_future result;
+    on_complete([next, result](bool succeeded, const notification_record &record)
+    {
+        if(!succeeded)
+        {
+            result.resolve(false, record);
+            return;
+        }
+        next(record).on_complete([result](bool next_succeeded, const notification_record &next_record)
+        {
+            result.resolve(next_succeeded, next_record);
+        });
+    });
+    return result;
+}
+
+void command_future::on_complete(const callback &done) const
+{
+    {
+        std::lock_guard<std::mutex> guard(m_state->lock);
+        if(!m_state->done)
+        {
+            m_state->callbacks.push_back(done);
+            return;
+        }
+    }
+    done(m_state->succeeded, m_state->record);
+}
+
+void command_future::resolve(bool succeeded, const notification_record &record) const
+{
+    std::vector<callback> callbacks;
+    {
+        std::lock_guard<std::mutex> guard(m_state->lock);
+        if(m_state->done)
+            return;
+        m_state->done = true;
+        m_state->succeeded = succeeded;
+        m_state->record = record;
+        callbacks.swap(m_state->callbacks);
+    }
+
+    // the result no longer changes, so callbacks run without the lock
+    for(size_t i = 0; i < callbacks.size(); i++)
+    {
+        callbacks[i](succeeded, record);
+    }
+}
+
+command_executor::command_executor(pending_command_table &pending, const id_allocator &next_id, const result_check &succeeded)
+: m_pending(pending), m_next_id(next_id), m_succeeded(succeeded)
+{
+}
+
+command_executor::~command_executor() {}
+
+command_future command_executor::send(const sender &send)
+{
+    command_future future;
+    void *notification_id = m_next_id();
+    TRACE_SPAN_ARG("command", "command_executor.send", (uint64_t)(intptr_t)notification_id);
+    result_check succeeded = m_succeeded;
+    m_pending.add(notification_id, [future, succeeded](const notification_record &record)
+    {
+        trace_log::record_instant("command", "command_executor.complete", (uint64_t)(intptr_t)record.notification_id);
+        future.resolve(succeeded(record), record);
+    });
+
+    // a command that never left has no response coming; fail it here unless it already completed
+    if(send(notification_id) != 0 && m_pending.cancel(notification_id))
+    {
+        notification_record record = notification_record();
+        record.notification_type = send_failed_notification;
+        record.notification_id = notification_id;
+        record.cmd_status = send_failed_status;
+        trace_log::record_instant("command", "command_executor.send_failed", (uint64_t)(intptr_t)notification_id);
+        future.resolve(false, record);
+    }
+    return future;
+}
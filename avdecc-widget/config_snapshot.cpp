@@ -0,0 +1,174 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * config_snapshot.cpp
+ *
+ */
+
+#include "config_snapshot.h"
+
+config_snapshot::config_snapshot() {}
+
+bool config_snapshot::shares_streams(bool input, const config_snapshot &other) const
+{
+    return input ? m_inputs == other.m_inputs : m_outputs == other.m_outputs;
+}
+
+bool config_snapshot::shares_mappings(bool input, const config_snapshot &other) const
+{
+    return input ? m_input_mappings == other.m_input_mappings : m_output_mappings == other.m_output_mappings;
+}
+
+config_builder::config_builder(const end_station_configuration &entity)
+{
+    m_entity.reset(new end_station_configuration(entity));
+    m_inputs.reset(new config_snapshot::stream_list());
+    m_outputs.reset(new config_snapshot::stream_list());
+    m_input_mappings.reset(new audio_mapping_set());
+    m_output_mappings.reset(new audio_mapping_set());
+}
+
+config_builder::config_builder(const config_snapshot &base) : m_base(base) {}
+
+config_builder::config_builder(config_builder &&other)
+: m_base(std::move(other.m_base)), m_entity(std::move(other.m_entity)),
+  m_inputs(std::move(other.m_inputs)), m_outputs(std::move(other.m_outputs)),
+  m_input_mappings(std::move(other.m_input_mappings)), m_output_mappings(std::move(other.m_output_mappings))
+{
+}
+
+config_builder & config_builder::operator=(config_builder &&other)
+{
+    m_base = std::move(other.m_base);
+    m_entity = std::move(other.m_entity);
+    m_inputs = std::move(other.m_inputs);
+    m_outputs = std::move(other.m_outputs);
+    m_input_mappings = std::move(other.m_input_mappings);
+    m_output_mappings = std::move(other.m_output_mappings);
+    return *this;
+}
+
+config_builder::~config_builder() {}
+
+end_station_configuration & config_builder::edit_entity()
+{
+    if(!m_entity)
+        m_entity.reset(new end_station_configuration(*m_base.m_entity));
+    return *m_entity;
+}
+
+config_snapshot::stream_list & config_builder::edit_streams(bool input)
+{
+    std::unique_ptr<config_snapshot::stream_list> &streams = input ? m_inputs : m_outputs;
+    if(!streams)
+        streams.reset(new config_snapshot::stream_list(m_base.streams(input)));
+    return *streams;
+}
+
+const config_snapshot::stream_list & config_builder::current_streams(bool input) const
+{
+    const std::unique_ptr<config_snapshot::stream_list> &streams = input ? m_inputs : m_outputs;
+    return streams ? *streams : m_base.streams(input);
+}
+
+audio_mapping_set & config_builder::edit_mappings(bool input)
+{
+    std::unique_ptr<audio_mapping_set> &mappings = input ? m_input_mappings : m_output_mappings;
+    if(!mappings)
+        mappings.reset(new audio_mapping_set(m_base.mappings(input)));
+    return *mappings;
+}
+
+void config_builder::set_model(const std::shared_ptr<const entity_model> &model)
+{
+    m_base.m_model = model;
+}
+
+void config_builder::set_sample_rate(uint32_t sample_rate)
+{
+    if(m_entity || m_base.entity().get_sample_rate() != sample_rate)
+        edit_entity().set_sample_rate(sample_rate);
+}
+
+void config_builder::set_entity_name(const wxString &name)
+{
+    if(m_entity || m_base.entity().get_entity_name() != name)
+        edit_entity().set_entity_name(name);
+}
+
+void config_builder::add_stream(bool input, const stream_configuration_details &details)
+{
+    edit_streams(input).push_back(details);
+}
+
+bool config_builder::set_stream_name(bool input, size_t stream_index, const wxString &name)
+{
+    const config_snapshot::stream_list &current = current_streams(input);
+    if(stream_index >= current.size())
+        return false;
+
+    string_pool::handle handle = string_pool::intern(name);
+    if(current[stream_index].stream_name != handle)
+        edit_streams(input)[stream_index].stream_name = handle;
+    return true;
+}
+
+bool config_builder::set_stream_channel_count(bool input, size_t stream_index, unsigned int channel_count)
+{
+    const config_snapshot::stream_list &current = current_streams(input);
+    if(stream_index >= current.size())
+        return false;
+
+    if(current[stream_index].channel_count != channel_count)
+        edit_streams(input)[stream_index].channel_count = channel_count;
+    return true;
+}
+
+void config_builder::set_mappings(bool input, const audio_mapping_set &mappings)
+{
+    const std::unique_ptr<audio_mapping_set> &edited = input ? m_input_mappings : m_output_mappings;
+    if(edited || m_base.mappings(input) != mappings)
+        edit_mappings(input) = mappings;
+}
+
+/*
+ * Publishes the edits as a new snapshot. Parts that were never edited are
+ * shared with the base; the builder is empty afterwards.
+ */
+config_snapshot config_builder::build()
+{
+    config_snapshot snapshot(m_base);
+    if(m_entity)
+        snapshot.m_entity.reset(m_entity.release());
+    if(m_inputs)
+        snapshot.m_inputs.reset(m_inputs.release());
+    if(m_outputs)
+        snapshot.m_outputs.reset(m_outputs.release());
+    if(m_input_mappings)
+        snapshot.m_input_mappings.reset(m_input_mappings.release());
+    if(m_output_mappings)
+        snapshot.m_output_mappings.reset(m_output_mappings.release());
+    m_base = config_snapshot();
+    return snapshot;
+}
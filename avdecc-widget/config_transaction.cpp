@@ -0,0 +1,250 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * config_transaction.cpp
+ *
+ */
+
+#include <algorithm>
+#include "config_transaction.h"
+#include "notification_coalescer.h"
+
+config_transaction::config_transaction(command_executor &commands)
+: m_commands(commands)
+{
+    m_phase = 0;
+    m_outstanding = 0;
+    m_rolling_back = false;
+    m_read_failed = false;
+    m_failed_status = 0;
+    m_started_ms = 0;
+}
+
+config_transaction::~config_transaction() {}
+
+void config_transaction::add_step(unsigned int phase, const std::string &name, const sender &apply, const sender &revert)
+{
+    step s;
+    s.phase = phase;
+    s.name = name;
+    s.apply = apply;
+    s.revert = revert;
+    s.state = STEP_PENDING;
+    m_steps.push_back(s);
+
+    if(std::find(m_phases.begin(), m_phases.end(), phase) == m_phases.end())
+    {
+        m_phases.push_back(phase);
+        std::sort(m_phases.begin(), m_phases.end());
+    }
+}
+
+void config_transaction::add_read(const std::string &name, const sender &send, const reader &read)
+{
+    read_step r;
+    r.name = name;
+    r.send = send;
+    r.read = read;
+    m_reads.push_back(r);
+}
+
+size_t config_transaction::get_step_count() const
+{
+    return m_steps.size();
+}
+
+void config_transaction::run(const completion &on_done)
+{
+    m_on_done = on_done;
+    m_started_ms = notification_coalescer::now_ms();
+    m_phase = 0;
+    m_rolling_back = false;
+    m_read_failed = false;
+    if(m_reads.empty())
+    {
+        start_phase();
+        return;
+    }
+
+    m_outstanding = m_reads.size();
+    std::shared_ptr<config_transaction> self = shared_from_this();
+    for(size_t i = 0; i < m_reads.size(); i++)
+    {
+        m_commands.send(m_reads[i].send).on_complete([self, i](bool ok, const notification_record &record)
+        {
+            self->on_read(i, ok, record);
+        });
+    }
+}
+
+/*
+ * A failed read leaves nothing to roll back to, so the transaction ends
+ * before its first phase, reporting TRANSACTION_READ_FAILED with the read
+ * as the failed step.
+ */
+void config_transaction::on_read(size_t index, bool ok, const notification_record &record)
+{
+    bool failed;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if(ok)
+        {
+            m_reads[index].read(record);
+        }
+        else if(m_failed_step.empty())
+        {
+            m_failed_step = m_reads[index].name;
+            m_failed_status = record.cmd_status;
+        }
+
+        if(--m_outstanding > 0)
+            return;
+        failed = !m_failed_step.empty();
+        m_read_failed = failed;
+    }
+
+    if(failed)
+        finish();
+    else
+        start_phase();
+}
+
+/*
+ * Sends every step of the current phase, forwards while applying and
+ * backwards while rolling back. Phases with nothing to send are skipped.
+ */
+void config_transaction::start_phase()
+{
+    std::vector<size_t> indices;
+    bool reverting;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        while(m_phase < m_phases.size())
+        {
+            unsigned int phase = m_rolling_back ? m_phases[m_phases.size() - 1 - m_phase] : m_phases[m_phase];
+            for(size_t i = 0; i < m_steps.size(); i++)
+            {
+                step &s = m_steps[i];
+                if(s.phase != phase)
+                    continue;
+                if((!m_rolling_back && s.state == STEP_PENDING) || (m_rolling_back && s.state == STEP_APPLIED))
+                {
+                    s.state = m_rolling_back ? STEP_REVERTING : STEP_SENT;
+                    indices.push_back(i);
+                }
+            }
+            if(!indices.empty())
+                break;
+            m_phase++;
+        }
+        reverting = m_rolling_back;
+        m_outstanding = indices.size();
+    }
+
+    if(indices.empty())
+        finish();
+    else
+        send_steps(indices, reverting);
+}
+
+void config_transaction::send_steps(const std::vector<size_t> &indices, bool reverting)
+{
+    std::shared_ptr<config_transaction> self = shared_from_this();
+    for(size_t i = 0; i < indices.size(); i++)
+    {
+        size_t index = indices[i];
+        const sender &send = reverting ? m_steps[index].revert : m_steps[index].apply;
+        m_commands.send(send).on_complete([self, index, reverting](bool ok, const notification_record &record)
+        {
+            self->on_complete(index, reverting, ok, record);
+        });
+    }
+}
+
+void config_transaction::on_complete(size_t index, bool reverting, bool ok, const notification_record &record)
+{
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        step &s = m_steps[index];
+        if(reverting)
+        {
+            s.state = ok ? STEP_REVERTED : STEP_REVERT_FAILED;
+        }
+        else
+        {
+            s.state = ok ? STEP_APPLIED : STEP_FAILED;
+            if(!ok && m_failed_step.empty())
+            {
+                m_failed_step = s.name;
+                m_failed_status = record.cmd_status;
+            }
+        }
+
+        if(--m_outstanding > 0)
+            return;
+
+        // the phase is complete; a failure turns the transaction around at this phase
+        if(!m_rolling_back && !m_failed_step.empty())
+        {
+            m_rolling_back = true;
+            m_phase = m_phases.size() - 1 - m_phase;
+        }
+        else
+        {
+            m_phase++;
+        }
+    }
+    start_phase();
+}
+
+void config_transaction::finish()
+{
+    transaction_report report = transaction_report();
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        report.step_count = m_steps.size();
+        report.failed_step = m_failed_step;
+        report.failed_status = m_failed_status;
+        for(size_t i = 0; i < m_steps.size(); i++)
+        {
+            if(m_steps[i].state == STEP_REVERTED)
+                report.reverted_count++;
+            else if(m_steps[i].state == STEP_REVERT_FAILED)
+                report.rollback_failures.push_back(m_steps[i].name);
+        }
+        report.elapsed_ms = notification_coalescer::now_ms() - m_started_ms;
+    }
+
+    if(m_read_failed)
+        report.outcome = TRANSACTION_READ_FAILED;
+    else if(!m_rolling_back)
+        report.outcome = TRANSACTION_COMMITTED;
+    else if(report.rollback_failures.empty())
+        report.outcome = TRANSACTION_ROLLED_BACK;
+    else
+        report.outcome = TRANSACTION_ROLLBACK_FAILED;
+
+    if(m_on_done)
+        m_on_done(report);
+}
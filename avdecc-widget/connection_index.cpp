@@ -0,0 +1,118 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * connection_index.cpp
+ *
+ */
+
+#include <algorithm>
+#include "connection_index.h"
+
+connection_index::connection_index() {}
+
+connection_index::~connection_index() {}
+
+bool connection_index::connect(const stream_endpoint &talker, const stream_endpoint &listener)
+{
+    stream_endpoint current;
+    if(get_talker(listener, current))
+    {
+        if(current == talker)
+            return false;
+        disconnect(listener);
+    }
+
+    m_talker_of[listener] = talker;
+    m_listeners_of[talker].push_back(listener);
+    return true;
+}
+
+bool connection_index::disconnect(const stream_endpoint &listener)
+{
+    std::unordered_map<stream_endpoint, stream_endpoint, stream_endpoint_hash>::iterator it = m_talker_of.find(listener);
+    if(it == m_talker_of.end())
+        return false;
+
+    std::unordered_map<stream_endpoint, std::vector<stream_endpoint>, stream_endpoint_hash>::iterator l = m_listeners_of.find(it->second);
+    if(l != m_listeners_of.end())
+    {
+        std::vector<stream_endpoint> &listeners = l->second;
+        listeners.erase(std::remove(listeners.begin(), listeners.end(), listener), listeners.end());
+        if(listeners.empty())
+            m_listeners_of.erase(l);
+    }
+
+    m_talker_of.erase(it);
+    return true;
+}
+
+void connection_index::remove_entity(uint64_t entity_id)
+{
+    std::vector<stream_endpoint> listeners;
+    for(std::unordered_map<stream_endpoint, stream_endpoint, stream_endpoint_hash>::const_iterator it = m_talker_of.begin();
+        it != m_talker_of.end(); ++it)
+    {
+        if(it->first.entity_id == entity_id || it->second.entity_id == entity_id)
+            listeners.push_back(it->first);
+    }
+
+    for(size_t i = 0; i < listeners.size(); i++)
+        disconnect(listeners[i]);
+}
+
+void connection_index::clear()
+{
+    m_talker_of.clear();
+    m_listeners_of.clear();
+}
+
+bool connection_index::get_talker(const stream_endpoint &listener, stream_endpoint &talker) const
+{
+    std::unordered_map<stream_endpoint, stream_endpoint, stream_endpoint_hash>::const_iterator it = m_talker_of.find(listener);
+    if(it == m_talker_of.end())
+        return false;
+
+    talker = it->second;
+    return true;
+}
+
+bool connection_index::is_connected(const stream_endpoint &talker, const stream_endpoint &listener) const
+{
+    stream_endpoint current;
+    return get_talker(listener, current) && current == talker;
+}
+
+const std::vector<stream_endpoint> * connection_index::get_listeners(const stream_endpoint &talker) const
+{
+    std::unordered_map<stream_endpoint, std::vector<stream_endpoint>, stream_endpoint_hash>::const_iterator it = m_listeners_of.find(talker);
+    if(it == m_listeners_of.end())
+        return NULL;
+
+    return &it->second;
+}
+
+size_t connection_index::size() const
+{
+    return m_talker_of.size();
+}
@@ -0,0 +1,276 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * connection_matrix.cpp
+ *
+ */
+
+#include "wx/sizer.h"
+#include "connection_matrix.h"
+
+connection_matrix_table::connection_matrix_table(const connection_index *index)
+{
+    m_index = index;
+}
+
+connection_matrix_table::~connection_matrix_table() {}
+
+void connection_matrix_table::set_listener_formatter(const listener_formatter &format_listener)
+{
+    m_format_listener = format_listener;
+}
+
+void connection_matrix_table::set_streams(const std::vector<matrix_stream> &talkers, const std::vector<matrix_stream> &listeners)
+{
+    int old_rows = (int)m_listeners.size();
+    int old_cols = (int)m_talkers.size();
+
+    m_talkers = talkers;
+    m_listeners = listeners;
+
+    m_talker_cols.clear();
+    for(size_t i = 0; i < m_talkers.size(); i++)
+        m_talker_cols[m_talkers[i].endpoint] = (int)i;
+
+    m_listener_rows.clear();
+    for(size_t i = 0; i < m_listeners.size(); i++)
+        m_listener_rows[m_listeners[i].endpoint] = (int)i;
+
+    notify_resize(old_rows, old_cols);
+}
+
+void connection_matrix_table::notify_resize(int old_rows, int old_cols)
+{
+    wxGrid *grid = GetView();
+    if(!grid)
+        return;
+
+    int rows = (int)m_listeners.size();
+    int cols = (int)m_talkers.size();
+
+    grid->BeginBatch();
+    if(rows < old_rows)
+    {
+        wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_DELETED, rows, old_rows - rows);
+        grid->ProcessTableMessage(msg);
+    }
+    else if(rows > old_rows)
+    {
+        wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_ROWS_APPENDED, rows - old_rows);
+        grid->ProcessTableMessage(msg);
+    }
+
+    if(cols < old_cols)
+    {
+        wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_COLS_DELETED, cols, old_cols - cols);
+        grid->ProcessTableMessage(msg);
+    }
+    else if(cols > old_cols)
+    {
+        wxGridTableMessage msg(this, wxGRIDTABLE_NOTIFY_COLS_APPENDED, cols - old_cols);
+        grid->ProcessTableMessage(msg);
+    }
+    grid->EndBatch();
+}
+
+const matrix_stream * connection_matrix_table::get_talker(int col) const
+{
+    if(col < 0 || (size_t)col >= m_talkers.size())
+        return NULL;
+    return &m_talkers[col];
+}
+
+const matrix_stream * connection_matrix_table::get_listener(int row) const
+{
+    if(row < 0 || (size_t)row >= m_listeners.size())
+        return NULL;
+    return &m_listeners[row];
+}
+
+int connection_matrix_table::find_listener_row(const stream_endpoint &listener) const
+{
+    std::unordered_map<stream_endpoint, int, stream_endpoint_hash>::const_iterator it = m_listener_rows.find(listener);
+    return it == m_listener_rows.end() ? -1 : it->second;
+}
+
+int connection_matrix_table::find_talker_col(const stream_endpoint &talker) const
+{
+    std::unordered_map<stream_endpoint, int, stream_endpoint_hash>::const_iterator it = m_talker_cols.find(talker);
+    return it == m_talker_cols.end() ? -1 : it->second;
+}
+
+const std::vector<matrix_stream> & connection_matrix_table::get_listeners() const
+{
+    return m_listeners;
+}
+
+int connection_matrix_table::GetNumberRows()
+{
+    return (int)m_listeners.size();
+}
+
+int connection_matrix_table::GetNumberCols()
+{
+    return (int)m_talkers.size();
+}
+
+bool connection_matrix_table::IsEmptyCell(int row, int col)
+{
+    const matrix_stream *listener = get_listener(row);
+    const matrix_stream *talker = get_talker(col);
+    return !listener || !talker || !m_index->is_connected(talker->endpoint, listener->endpoint);
+}
+
+wxString connection_matrix_table::GetValue(int row, int col)
+{
+    return IsEmptyCell(row, col) ? wxString() : wxString(wxT("X"));
+}
+
+void connection_matrix_table::SetValue(int WXUNUSED(row), int WXUNUSED(col), const wxString &WXUNUSED(value))
+{
+    // cells change only through ACMP responses
+}
+
+wxString connection_matrix_table::GetRowLabelValue(int row)
+{
+    const matrix_stream *listener = get_listener(row);
+    if(!listener)
+        return wxString();
+    if(!m_format_listener)
+        return get_label(*listener);
+
+    wxString info = m_format_listener(listener->endpoint);
+    return info.empty() ? get_label(*listener) : get_label(*listener) + wxT("  ") + info;
+}
+
+wxString connection_matrix_table::GetColLabelValue(int col)
+{
+    const matrix_stream *talker = get_talker(col);
+    return talker ? get_label(*talker) : wxString();
+}
+
+wxString connection_matrix_table::get_label(const matrix_stream &stream)
+{
+    return string_pool::get(stream.entity_name) + wxT(": ") + string_pool::get(stream.stream_name);
+}
+
+connection_matrix_panel::connection_matrix_panel(wxWindow *parent, const connection_index *index)
+: wxPanel(parent, wxID_ANY)
+{
+    wxButton *refresh_button = new wxButton(this, wxID_REFRESH, wxT("Refresh"));
+    m_status = new wxStaticText(this, wxID_ANY, wxEmptyString);
+
+    m_grid = new wxGrid(this, wxID_ANY, wxDefaultPosition, wxDefaultSize);
+    m_table = new connection_matrix_table(index);
+    m_grid->SetTable(m_table, true);
+    m_grid->EnableEditing(false);
+    m_grid->SetDefaultColSize(24);
+    m_grid->SetDefaultRowSize(20);
+    m_grid->SetRowLabelSize(360);
+    m_grid->SetColLabelSize(150);
+    m_grid->SetColLabelTextOrientation(wxVERTICAL);
+    m_grid->SetDefaultCellAlignment(wxALIGN_CENTRE, wxALIGN_CENTRE);
+
+    wxBoxSizer *header_sizer = new wxBoxSizer(wxHORIZONTAL);
+    header_sizer->Add(refresh_button);
+    header_sizer->Add(m_status, 1, wxALIGN_CENTER_VERTICAL | wxLEFT, 10);
+
+    wxBoxSizer *sizer = new wxBoxSizer(wxVERTICAL);
+    sizer->Add(header_sizer, 0, wxGROW);
+    sizer->Add(m_grid, 1, wxGROW);
+    SetSizer(sizer);
+
+    refresh_button->Bind(wxEVT_BUTTON, &connection_matrix_panel::OnRefreshButton, this);
+    m_grid->Bind(wxEVT_GRID_CELL_LEFT_DCLICK, &connection_matrix_panel::OnCellDClick, this);
+}
+
+connection_matrix_panel::~connection_matrix_panel() {}
+
+void connection_matrix_panel::set_handlers(const refresh_handler &on_refresh, const toggle_handler &on_toggle)
+{
+    m_on_refresh = on_refresh;
+    m_on_toggle = on_toggle;
+}
+
+void connection_matrix_panel::set_listener_formatter(const connection_matrix_table::listener_formatter &format_listener)
+{
+    m_table->set_listener_formatter(format_listener);
+}
+
+void connection_matrix_panel::set_streams(const std::vector<matrix_stream> &talkers, const std::vector<matrix_stream> &listeners)
+{
+    m_table->set_streams(talkers, listeners);
+    m_grid->ForceRefresh();
+}
+
+void connection_matrix_panel::refresh_listener(const stream_endpoint &listener)
+{
+    int row = m_table->find_listener_row(listener);
+    if(row < 0)
+        return;
+
+    // the row label shows the listener's stream info
+    int top, bottom;
+    m_grid->CalcScrolledPosition(0, m_grid->GetRowTop(row), NULL, &top);
+    m_grid->CalcScrolledPosition(0, m_grid->GetRowBottom(row), NULL, &bottom);
+    m_grid->GetGridRowLabelWindow()->RefreshRect(wxRect(0, top, m_grid->GetRowLabelSize(), bottom - top));
+    if(m_table->GetNumberCols() == 0)
+        return;
+
+    wxRect rect = m_grid->BlockToDeviceRect(wxGridCellCoords(row, 0),
+                                            wxGridCellCoords(row, m_table->GetNumberCols() - 1));
+    m_grid->GetGridWindow()->RefreshRect(rect);
+}
+
+void connection_matrix_panel::refresh_all()
+{
+    m_grid->ForceRefresh();
+}
+
+void connection_matrix_panel::set_status(const wxString &status)
+{
+    m_status->SetLabel(status);
+}
+
+connection_matrix_table * connection_matrix_panel::get_table() const
+{
+    return m_table;
+}
+
+void connection_matrix_panel::OnRefreshButton(wxCommandEvent& WXUNUSED(event))
+{
+    if(m_on_refresh)
+        m_on_refresh();
+}
+
+void connection_matrix_panel::OnCellDClick(wxGridEvent& event)
+{
+    const matrix_stream *talker = m_table->get_talker(event.GetCol());
+    const matrix_stream *listener = m_table->get_listener(event.GetRow());
+
+    if(talker && listener && m_on_toggle)
+    {
+        m_on_toggle(talker->endpoint, listener->endpoint, !m_table->IsEmptyCell(event.GetRow(), event.GetCol()));
+    }
+}
@@ -0,0 +1,225 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * console_log.cpp
+ *
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "console_log.h"
+
+namespace
+{
+    /*
+     * Bounded multi-producer ring with per-slot sequence numbers. A producer
+     * owns a slot once its position CAS succeeds and publishes it by storing
+     * pos + 1; the writer hands it back by storing pos + ring_slots.
+     */
+    struct log_slot
+    {
+        std::atomic<size_t> sequence;
+        size_t length;
+        char text[console_log::max_line_length];
+    };
+
+    log_slot ring[console_log::ring_slots];
+    std::atomic<size_t> enqueue_pos(0);
+    size_t dequeue_pos = 0;
+
+    std::atomic<bool> writer_running(false);
+    std::atomic<bool> writer_stop(false);
+    std::thread writer_thread;
+
+    /*
+     * The writer sleeps on wake_cond when the ring is empty. Producers only
+     * take wake_lock when writer_sleeping is set, so a busy writer costs
+     * them nothing; producers_active lets stop() wait out a producer that
+     * saw the writer running just before it stopped.
+     */
+    std::mutex wake_lock;
+    std::condition_variable wake_cond;
+    std::atomic<bool> writer_sleeping(false);
+    std::atomic<unsigned int> producers_active(0);
+
+    thread_local char format_buffer[console_log::max_line_length];
+
+    void direct_write(const char *text, size_t length)
+    {
+        fwrite(text, 1, length, stdout);
+        fflush(stdout);
+    }
+
+    bool try_enqueue(const char *text, size_t length)
+    {
+        size_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        for(;;)
+        {
+            log_slot &slot = ring[pos % console_log::ring_slots];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+            if(diff == 0)
+            {
+                if(enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    memcpy(slot.text, text, length);
+                    slot.length = length;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if(diff < 0)
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool has_line()
+    {
+        return ring[dequeue_pos % console_log::ring_slots].sequence.load(std::memory_order_acquire) == dequeue_pos + 1;
+    }
+
+    void wake_writer()
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if(writer_sleeping.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> guard(wake_lock);
+            wake_cond.notify_one();
+        }
+    }
+
+    bool drain()
+    {
+        bool wrote = false;
+        for(;;)
+        {
+            log_slot &slot = ring[dequeue_pos % console_log::ring_slots];
+            if(slot.sequence.load(std::memory_order_acquire) != dequeue_pos + 1)
+                break;
+
+            fwrite(slot.text, 1, slot.length, stdout);
+            slot.sequence.store(dequeue_pos + console_log::ring_slots, std::memory_order_release);
+            dequeue_pos++;
+            wrote = true;
+        }
+        if(wrote)
+            fflush(stdout);
+        return wrote;
+    }
+
+    void writer_main()
+    {
+        while(!writer_stop.load(std::memory_order_acquire))
+        {
+            if(drain())
+                continue;
+
+            std::unique_lock<std::mutex> guard(wake_lock);
+            writer_sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            wake_cond.wait(guard, []() { return has_line() || writer_stop.load(std::memory_order_acquire); });
+            writer_sleeping.store(false, std::memory_order_relaxed);
+        }
+        drain();
+    }
+}
+
+void console_log::start()
+{
+    if(writer_running.load(std::memory_order_acquire))
+        return;
+
+    for(size_t i = 0; i < ring_slots; i++)
+        ring[i].sequence.store(i, std::memory_order_relaxed);
+    enqueue_pos.store(0, std::memory_order_relaxed);
+    dequeue_pos = 0;
+
+    writer_stop.store(false, std::memory_order_relaxed);
+    writer_thread = std::thread(writer_main);
+    writer_running.store(true, std::memory_order_release);
+}
+
+void console_log::stop()
+{
+    if(!writer_running.load(std::memory_order_acquire))
+        return;
+
+    writer_running.store(false, std::memory_order_seq_cst);
+    {
+        std::lock_guard<std::mutex> guard(wake_lock);
+        writer_stop.store(true, std::memory_order_release);
+        wake_cond.notify_one();
+    }
+    writer_thread.join();
+
+    // a producer that saw the writer running may still be queueing its line
+    while(producers_active.load(std::memory_order_seq_cst))
+        std::this_thread::yield();
+    drain();
+}
+
+void console_log::line(const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(format_buffer, sizeof(format_buffer) - 1, fmt, args);
+    va_end(args);
+
+    if(n < 0)
+        return;
+
+    size_t length = (size_t)n < sizeof(format_buffer) - 1 ? (size_t)n : sizeof(format_buffer) - 2;
+    format_buffer[length++] = '\n';
+    write_line(format_buffer, length);
+}
+
+void console_log::write_line(const char *text, size_t length)
+{
+    if(length > max_line_length)
+        length = max_line_length;
+
+    // Lines that cannot be queued (writer not started, ring full) are written
+    // directly; stdio still keeps each fwrite whole.
+    producers_active.fetch_add(1, std::memory_order_seq_cst);
+    bool queued = writer_running.load(std::memory_order_seq_cst) && try_enqueue(text, length);
+    producers_active.fetch_sub(1, std::memory_order_release);
+
+    if(queued)
+        wake_writer();
+    else
+        direct_write(text, length);
+}
@@ -0,0 +1,426 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * counter_history.cpp
+ *
+ */
+
+#include "counter_history.h"
+
+static const uint64_t tier_resolution_ms[counter_history::tier_count] = {1000, 10000, 60000};
+static const uint64_t tier_retention_ms[counter_history::tier_count] = {5 * 60000, 60 * 60000, 24 * 60 * 60000};
+static const size_t max_block_bytes = 2048;
+static const size_t block_growth_bytes = 16; // blocks grow in small steps rather than doubling
+static const size_t min_trim_points = 8; // stale points worth re-encoding the oldest block for
+
+static void put_varint(std::vector<uint8_t> &bytes, uint64_t value)
+{
+    while(value >= 0x80)
+    {
+        bytes.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    bytes.push_back((uint8_t)value);
+}
+
+static size_t varint_size(uint64_t value)
+{
+    size_t size = 1;
+    for(; value >= 0x80; value >>= 7)
+        size++;
+    return size;
+}
+
+static uint64_t get_varint(const std::vector<uint8_t> &bytes, size_t &pos)
+{
+    uint64_t value = 0;
+    for(unsigned int shift = 0; pos < bytes.size(); shift += 7)
+    {
+        uint8_t byte = bytes[pos++];
+        value |= (uint64_t)(byte & 0x7f) << shift;
+        if(!(byte & 0x80))
+            break;
+    }
+    return value;
+}
+
+static uint64_t zigzag(int64_t value)
+{
+    return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t unzigzag(uint64_t value)
+{
+    return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+/*
+ * The low bit of a token flags a bucket gap other than the previous one,
+ * which then follows; a counter polled at a steady interval only stores
+ * its gap once per block.
+ */
+static void put_token(std::vector<uint8_t> &bytes, int64_t delta_of_delta, uint64_t gap, uint64_t last_gap)
+{
+    uint64_t token = (zigzag(delta_of_delta) << 1) | (gap != last_gap);
+    size_t size = varint_size(token) + (gap != last_gap ? varint_size(gap) : 0);
+    if(bytes.capacity() < bytes.size() + size)
+        bytes.reserve(bytes.size() + size + block_growth_bytes);
+
+    put_varint(bytes, token);
+    if(gap != last_gap)
+        put_varint(bytes, gap);
+}
+
+counter_history::counter_history() {}
+
+counter_history::~counter_history() {}
+
+counter_history::series_id counter_history::get_series(const counter_target &target, uint8_t counter)
+{
+    std::pair<counter_target, uint8_t> key(target, counter);
+    std::unordered_map<std::pair<counter_target, uint8_t>, series_id, series_key_hash>::iterator it = m_index.find(key);
+    if(it != m_index.end())
+        return it->second;
+
+    series_id id;
+    if(!m_free.empty())
+    {
+        id = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        id = (series_id)m_series.size();
+        m_series.push_back(series());
+    }
+
+    series &s = m_series[id];
+    s = series();
+    s.target = target;
+    s.counter = counter;
+    s.active = true;
+    m_index[key] = id;
+    return id;
+}
+
+bool counter_history::find_series(const counter_target &target, uint8_t counter, series_id &id) const
+{
+    std::unordered_map<std::pair<counter_target, uint8_t>, series_id, series_key_hash>::const_iterator it =
+        m_index.find(std::pair<counter_target, uint8_t>(target, counter));
+    if(it == m_index.end())
+        return false;
+
+    id = it->second;
+    return true;
+}
+
+void counter_history::commit(tier &t, size_t tier_index, uint64_t bucket, uint64_t value)
+{
+    if(t.has_point && value == t.last_value)
+        return;
+
+    if(!t.has_point || t.blocks.empty() || t.blocks.back().bytes.size() >= max_block_bytes)
+    {
+        if(!t.blocks.empty())
+            t.blocks.back().bytes.shrink_to_fit();
+
+        block b;
+        b.first_bucket = bucket;
+        put_varint(b.bytes, value);
+        t.blocks.push_back(b);
+        t.last_delta = 0;
+        t.last_gap = 1;
+    }
+    else
+    {
+        int64_t delta = (int64_t)(value - t.last_value);
+        uint64_t gap = bucket - t.last_bucket;
+        put_token(t.blocks.back().bytes, delta - t.last_delta, gap, t.last_gap);
+        t.last_delta = delta;
+        t.last_gap = gap;
+    }
+
+    t.last_bucket = bucket;
+    t.last_value = value;
+    t.has_point = true;
+
+    // drop whole blocks once the next one starts at or before the retention window
+    uint64_t retention_buckets = tier_retention_ms[tier_index] / tier_resolution_ms[tier_index];
+    if(bucket < retention_buckets)
+        return;
+    uint64_t cutoff_bucket = bucket - retention_buckets;
+    while(t.blocks.size() > 1 && t.blocks[1].first_bucket <= cutoff_bucket)
+    {
+        t.blocks.erase(t.blocks.begin());
+    }
+    trim(t, cutoff_bucket);
+}
+
+/*
+ * Re-encodes the oldest block from the last point at or before
+ * cutoff_bucket on, once enough points before it have gone stale. If the
+ * block is also the one being appended to, the encoder continues from the
+ * delta and gap the rewritten block ends with.
+ */
+void counter_history::trim(tier &t, uint64_t cutoff_bucket)
+{
+    block &b = t.blocks.front();
+    if(b.first_bucket >= cutoff_bucket)
+        return;
+
+    std::vector<point> points;
+    size_t pos = 0;
+    uint64_t bucket = b.first_bucket;
+    uint64_t value = get_varint(b.bytes, pos);
+    int64_t delta = 0;
+    uint64_t gap = 1;
+    size_t stale = 0;
+    while(true)
+    {
+        if(bucket <= cutoff_bucket)
+        {
+            stale++;
+            points.clear();
+        }
+        point p;
+        p.time_ms = bucket;
+        p.value = value;
+        points.push_back(p);
+
+        if(pos >= b.bytes.size())
+            break;
+        uint64_t token = get_varint(b.bytes, pos);
+        if(token & 1)
+            gap = get_varint(b.bytes, pos);
+        bucket += gap;
+        delta += unzigzag(token >> 1);
+        value += delta;
+    }
+    if(stale <= min_trim_points)
+        return;
+
+    block trimmed;
+    trimmed.first_bucket = points[0].time_ms;
+    put_varint(trimmed.bytes, points[0].value);
+    delta = 0;
+    gap = 1;
+    for(size_t i = 1; i < points.size(); i++)
+    {
+        int64_t next_delta = (int64_t)(points[i].value - points[i - 1].value);
+        uint64_t next_gap = points[i].time_ms - points[i - 1].time_ms;
+        put_token(trimmed.bytes, next_delta - delta, next_gap, gap);
+        delta = next_delta;
+        gap = next_gap;
+    }
+
+    if(t.blocks.size() == 1)
+    {
+        t.last_delta = delta;
+        t.last_gap = gap;
+    }
+    else
+        trimmed.bytes.shrink_to_fit();
+    b.first_bucket = trimmed.first_bucket;
+    b.bytes.swap(trimmed.bytes);
+}
+
+void counter_history::append(series_id id, uint64_t time_ms, uint64_t value)
+{
+    if(id >= m_series.size() || !m_series[id].active)
+        return;
+
+    for(size_t i = 0; i < tier_count; i++)
+    {
+        tier &t = m_series[id].tiers[i];
+        uint64_t bucket = time_ms / tier_resolution_ms[i];
+
+        if(t.has_pending && bucket != t.pending_bucket)
+            commit(t, i, t.pending_bucket, t.pending_value);
+
+        t.pending_bucket = bucket;
+        t.pending_value = value;
+        t.has_pending = true;
+    }
+}
+
+void counter_history::append(const counter_sample &sample, uint64_t time_ms)
+{
+    for(uint8_t counter = 0; counter < counter_sample::max_counters; counter++)
+    {
+        if(sample.valid & (1u << counter))
+            append(get_series(sample.target, counter), time_ms, sample.values[counter]);
+    }
+}
+
+void counter_history::decode(const block &b, std::vector<point> &points, uint64_t resolution_ms,
+                             uint64_t from_bucket, uint64_t to_bucket, point &before, bool &has_before)
+{
+    size_t pos = 0;
+    uint64_t bucket = b.first_bucket;
+    uint64_t value = get_varint(b.bytes, pos);
+    int64_t delta = 0;
+    uint64_t gap = 1;
+
+    while(true)
+    {
+        if(bucket > to_bucket)
+            return;
+
+        if(bucket < from_bucket)
+        {
+            before.time_ms = from_bucket * resolution_ms;
+            before.value = value;
+            has_before = true;
+        }
+        else
+        {
+            if(has_before)
+            {
+                if(bucket > from_bucket)
+                    points.push_back(before);
+                has_before = false;
+            }
+            point p;
+            p.time_ms = bucket * resolution_ms;
+            p.value = value;
+            points.push_back(p);
+        }
+
+        if(pos >= b.bytes.size())
+            return;
+        uint64_t token = get_varint(b.bytes, pos);
+        if(token & 1)
+            gap = get_varint(b.bytes, pos);
+        bucket += gap;
+        delta += unzigzag(token >> 1);
+        value += delta;
+    }
+}
+
+size_t counter_history::query(series_id id, uint64_t from_ms, uint64_t to_ms, size_t max_points, std::vector<point> &points) const
+{
+    if(id >= m_series.size() || !m_series[id].active || to_ms < from_ms)
+        return 0;
+
+    const series &s = m_series[id];
+
+    size_t tier_index = tier_count - 1;
+    for(size_t i = 0; i < tier_count; i++)
+    {
+        const tier &t = s.tiers[i];
+        if(!t.blocks.empty() && t.blocks.front().first_bucket * tier_resolution_ms[i] <= from_ms)
+        {
+            tier_index = i;
+            break;
+        }
+    }
+
+    const tier &t = s.tiers[tier_index];
+    uint64_t resolution_ms = tier_resolution_ms[tier_index];
+    uint64_t from_bucket = from_ms / resolution_ms;
+    uint64_t to_bucket = to_ms / resolution_ms;
+
+    std::vector<point> decoded;
+    point before = point();
+    bool has_before = false;
+
+    for(size_t i = 0; i < t.blocks.size(); i++)
+    {
+        const block &b = t.blocks[i];
+        if(b.first_bucket > to_bucket)
+            break;
+        if(i + 1 < t.blocks.size() && t.blocks[i + 1].first_bucket <= from_bucket)
+            continue;
+        decode(b, decoded, resolution_ms, from_bucket, to_bucket, before, has_before);
+    }
+
+    if(t.has_pending && t.pending_bucket >= from_bucket && t.pending_bucket <= to_bucket &&
+       (!t.has_point || t.pending_value != t.last_value || t.pending_bucket != t.last_bucket))
+    {
+        if(has_before)
+        {
+            decoded.push_back(before);
+            has_before = false;
+        }
+        point p;
+        p.time_ms = t.pending_bucket * resolution_ms;
+        p.value = t.pending_value;
+        decoded.push_back(p);
+    }
+    if(has_before)
+        decoded.push_back(before);
+
+    if(max_points == 0 || decoded.size() <= max_points)
+    {
+        points.insert(points.end(), decoded.begin(), decoded.end());
+        return decoded.size();
+    }
+
+    // evenly spaced subset, always keeping the newest point
+    for(size_t i = 0; i < max_points; i++)
+    {
+        points.push_back(decoded[(i + 1) * decoded.size() / max_points - 1]);
+    }
+    return max_points;
+}
+
+void counter_history::remove_entity(uint64_t entity_id)
+{
+    for(std::unordered_map<std::pair<counter_target, uint8_t>, series_id, series_key_hash>::iterator it = m_index.begin(); it != m_index.end();)
+    {
+        if(it->first.first.entity_id == entity_id)
+        {
+            m_series[it->second] = series();
+            m_free.push_back(it->second);
+            it = m_index.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+size_t counter_history::get_series_count() const
+{
+    return m_index.size();
+}
+
+size_t counter_history::get_memory_bytes() const
+{
+    // the index is estimated as one node of key, ID and two pointers per series
+    size_t bytes = m_series.size() * sizeof(series) + m_index.bucket_count() * sizeof(void *) +
+                   m_index.size() * (sizeof(std::pair<counter_target, uint8_t>) + sizeof(series_id) + 2 * sizeof(void *));
+    for(size_t i = 0; i < m_series.size(); i++)
+    {
+        for(size_t j = 0; j < tier_count; j++)
+        {
+            const tier &t = m_series[i].tiers[j];
+            bytes += t.blocks.capacity() * sizeof(block);
+            for(size_t k = 0; k < t.blocks.size(); k++)
+                bytes += t.blocks[k].bytes.capacity();
+        }
+    }
+    return bytes;
+}
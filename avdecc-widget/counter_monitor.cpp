@@ -0,0 +1,195 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * counter_monitor.cpp
+ *
+ */
+
+#include <cstring>
+#include "counter_monitor.h"
+
+counter_monitor::counter_monitor(double commands_per_second)
+{
+    m_rate = commands_per_second > 0 ? commands_per_second : 1;
+    m_tokens = 0;
+    m_last_refill_ms = 0;
+}
+
+counter_monitor::~counter_monitor() {}
+
+void counter_monitor::set_budget(double commands_per_second)
+{
+    m_rate = commands_per_second > 0 ? commands_per_second : 1;
+}
+
+double counter_monitor::get_budget() const
+{
+    return m_rate;
+}
+
+void counter_monitor::set_targets(const std::vector<counter_target> &targets, uint64_t now_ms)
+{
+    std::vector<target_state> old_targets;
+    old_targets.swap(m_targets);
+    std::unordered_map<counter_target, size_t, counter_target_hash> old_index;
+    old_index.swap(m_index);
+    m_due = std::priority_queue<due_entry, std::vector<due_entry>, std::greater<due_entry> >();
+
+    for(size_t i = 0; i < targets.size(); i++)
+    {
+        if(m_index.count(targets[i]))
+            continue;
+
+        std::unordered_map<counter_target, size_t, counter_target_hash>::iterator it = old_index.find(targets[i]);
+        if(it != old_index.end())
+        {
+            m_targets.push_back(old_targets[it->second]);
+        }
+        else
+        {
+            target_state state;
+            state.target = targets[i];
+            state.interval_ms = min_interval_ms;
+            state.next_poll_ms = now_ms + (uint64_t)min_interval_ms * i / targets.size();
+            state.in_flight = false;
+            state.has_sample = false;
+            memset(&state.last, 0, sizeof(state.last));
+            m_targets.push_back(state);
+        }
+
+        size_t index = m_targets.size() - 1;
+        m_index[targets[i]] = index;
+        if(!m_targets[index].in_flight)
+            m_due.push(due_entry(m_targets[index].next_poll_ms, index));
+    }
+}
+
+void counter_monitor::refill(uint64_t now_ms)
+{
+    if(m_last_refill_ms == 0 || now_ms < m_last_refill_ms)
+        m_last_refill_ms = now_ms;
+
+    // allow at most one second of burst
+    m_tokens += m_rate * (now_ms - m_last_refill_ms) / 1000.0;
+    if(m_tokens > m_rate)
+        m_tokens = m_rate;
+    m_last_refill_ms = now_ms;
+}
+
+size_t counter_monitor::tick(uint64_t now_ms, const sender &send)
+{
+    refill(now_ms);
+
+    size_t sent = 0;
+    while(!m_due.empty() && m_due.top().first <= now_ms && m_tokens >= 1)
+    {
+        due_entry entry = m_due.top();
+        m_due.pop();
+
+        target_state &state = m_targets[entry.second];
+        if(state.in_flight || state.next_poll_ms != entry.first)
+            continue;
+
+        m_tokens -= 1;
+        if(send(state.target) == 0)
+        {
+            state.in_flight = true;
+            sent++;
+        }
+        else
+        {
+            report_failure(state.target, now_ms);
+        }
+    }
+    return sent;
+}
+
+void counter_monitor::schedule(size_t index, uint64_t now_ms)
+{
+    target_state &state = m_targets[index];
+    state.in_flight = false;
+    state.next_poll_ms = now_ms + state.interval_ms;
+    m_due.push(due_entry(state.next_poll_ms, index));
+}
+
+size_t counter_monitor::report(const counter_sample &sample, uint64_t now_ms, bool &changed)
+{
+    changed = false;
+    size_t index = find_target(sample.target);
+    if(index == npos)
+        return npos;
+
+    target_state &state = m_targets[index];
+    changed = !state.has_sample || state.last.valid != sample.valid ||
+              memcmp(state.last.values, sample.values, sizeof(sample.values)) != 0;
+
+    if(changed)
+        state.interval_ms = state.interval_ms / 2 < min_interval_ms ? min_interval_ms : state.interval_ms / 2;
+    else
+        state.interval_ms = state.interval_ms * 2 > max_interval_ms ? max_interval_ms : state.interval_ms * 2;
+
+    state.last = sample;
+    state.has_sample = true;
+    schedule(index, now_ms);
+    return index;
+}
+
+size_t counter_monitor::report_failure(const counter_target &target, uint64_t now_ms)
+{
+    size_t index = find_target(target);
+    if(index == npos)
+        return npos;
+
+    target_state &state = m_targets[index];
+    state.interval_ms = state.interval_ms * 2 > max_interval_ms ? max_interval_ms : state.interval_ms * 2;
+    schedule(index, now_ms);
+    return index;
+}
+
+size_t counter_monitor::get_target_count() const
+{
+    return m_targets.size();
+}
+
+const counter_target & counter_monitor::get_target(size_t index) const
+{
+    return m_targets.at(index).target;
+}
+
+uint32_t counter_monitor::get_interval_ms(size_t index) const
+{
+    return m_targets.at(index).interval_ms;
+}
+
+const counter_sample * counter_monitor::get_last_sample(size_t index) const
+{
+    const target_state &state = m_targets.at(index);
+    return state.has_sample ? &state.last : NULL;
+}
+
+size_t counter_monitor::find_target(const counter_target &target) const
+{
+    std::unordered_map<counter_target, size_t, counter_target_hash>::const_iterator it = m_index.find(target);
+    return it == m_index.end() ? npos : it->second;
+}
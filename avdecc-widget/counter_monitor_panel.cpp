@@ -0,0 +1,153 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * counter_monitor_panel.cpp
+ *
+ */
+
+#include "wx/sizer.h"
+#include "counter_monitor_panel.h"
+
+counter_list::counter_list(wxWindow *parent, const counter_monitor *monitor)
+: wxListCtrl(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VIRTUAL | wxLC_HRULES)
+{
+    m_monitor = monitor;
+
+    InsertColumn(0, wxT("Entity ID"), wxLIST_FORMAT_LEFT, 150);
+    InsertColumn(1, wxT("Descriptor"), wxLIST_FORMAT_LEFT, 130);
+    InsertColumn(2, wxT("Interval"), wxLIST_FORMAT_RIGHT, 60);
+    InsertColumn(3, wxT("Trend"), wxLIST_FORMAT_LEFT, 150);
+    InsertColumn(4, wxT("Counters"), wxLIST_FORMAT_LEFT, 600);
+}
+
+counter_list::~counter_list() {}
+
+void counter_list::set_formatters(const target_formatter &format_target, const sample_formatter &format_sample,
+                                  const trend_formatter &format_trend)
+{
+    m_format_target = format_target;
+    m_format_sample = format_sample;
+    m_format_trend = format_trend;
+}
+
+wxString counter_list::OnGetItemText(long item, long column) const
+{
+    if(item < 0 || (size_t)item >= m_monitor->get_target_count())
+        return wxEmptyString;
+
+    const counter_target &target = m_monitor->get_target(item);
+    switch(column)
+    {
+        case 0:
+            return wxString::Format("0x%llx", (unsigned long long)target.entity_id);
+        case 1:
+            return m_format_target ? m_format_target(target) : wxString::Format("%u:%u", target.desc_type, target.desc_index);
+        case 2:
+            return wxString::Format("%u s", m_monitor->get_interval_ms(item) / 1000);
+        case 3:
+            return m_format_trend ? m_format_trend(target) : wxString();
+        case 4:
+        {
+            const counter_sample *sample = m_monitor->get_last_sample(item);
+            if(!sample || !m_format_sample)
+                return wxEmptyString;
+            return m_format_sample(target, *sample);
+        }
+    }
+    return wxEmptyString;
+}
+
+counter_monitor_panel::counter_monitor_panel(wxWindow *parent, const counter_monitor *monitor, int commands_per_second)
+: wxPanel(parent, wxID_ANY)
+{
+    m_monitor = monitor;
+    m_enable = new wxCheckBox(this, wxID_ANY, wxT("Monitor counters"));
+    m_budget = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(80, -1),
+                              wxSP_ARROW_KEYS, 1, 1000, commands_per_second);
+    m_status = new wxStaticText(this, wxID_ANY, wxEmptyString);
+    m_list = new counter_list(this, monitor);
+
+    wxBoxSizer *header_sizer = new wxBoxSizer(wxHORIZONTAL);
+    header_sizer->Add(m_enable, 0, wxALIGN_CENTER_VERTICAL);
+    header_sizer->Add(new wxStaticText(this, wxID_ANY, wxT("Budget (commands/s):")), 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 10);
+    header_sizer->Add(m_budget, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 5);
+    header_sizer->Add(m_status, 1, wxALIGN_CENTER_VERTICAL | wxLEFT, 10);
+
+    wxBoxSizer *sizer = new wxBoxSizer(wxVERTICAL);
+    sizer->Add(header_sizer, 0, wxGROW);
+    sizer->Add(m_list, 1, wxGROW);
+    SetSizer(sizer);
+
+    m_enable->Bind(wxEVT_CHECKBOX, &counter_monitor_panel::OnEnable, this);
+    m_budget->Bind(wxEVT_SPINCTRL, &counter_monitor_panel::OnBudget, this);
+}
+
+counter_monitor_panel::~counter_monitor_panel() {}
+
+void counter_monitor_panel::set_handlers(const enable_handler &on_enable, const budget_handler &on_budget)
+{
+    m_on_enable = on_enable;
+    m_on_budget = on_budget;
+}
+
+void counter_monitor_panel::set_formatters(const counter_list::target_formatter &format_target,
+                                           const counter_list::sample_formatter &format_sample,
+                                           const counter_list::trend_formatter &format_trend)
+{
+    m_list->set_formatters(format_target, format_sample, format_trend);
+}
+
+bool counter_monitor_panel::is_enabled() const
+{
+    return m_enable->GetValue();
+}
+
+void counter_monitor_panel::refresh_targets()
+{
+    m_list->SetItemCount(m_monitor->get_target_count());
+    m_list->Refresh();
+}
+
+void counter_monitor_panel::refresh_target(size_t index)
+{
+    if(index < m_monitor->get_target_count())
+        m_list->RefreshItem(index);
+}
+
+void counter_monitor_panel::set_status(const wxString &status)
+{
+    m_status->SetLabel(status);
+}
+
+void counter_monitor_panel::OnEnable(wxCommandEvent& event)
+{
+    if(m_on_enable)
+        m_on_enable(event.IsChecked());
+}
+
+void counter_monitor_panel::OnBudget(wxSpinEvent& event)
+{
+    if(m_on_budget)
+        m_on_budget(event.GetPosition());
+}
@@ -29,45 +29,55 @@
 #include "end_station_configuration.h"
 
 
-end_station_configuration::end_station_configuration(wxString entity_name, wxString id_entity, wxString name_default,
-                                                     wxString mac_add, wxString firmware_ver, uint32_t sampling_rate)
+end_station_configuration::end_station_configuration(const wxString &entity_name, uint64_t id_entity, const wxString &name_default,
+                                                     uint64_t mac_add, const wxString &firmware_ver, uint32_t sampling_rate)
 {
-    name = entity_name;
+    name = string_pool::intern(entity_name);
     entity_id = id_entity;
-    default_name = name_default;
+    default_name = string_pool::intern(name_default);
     mac = mac_add;
-    fw_ver = firmware_ver;
+    fw_ver = string_pool::intern(firmware_ver);
     sample_rate = sampling_rate;
 }
 
 end_station_configuration::~end_station_configuration() {}
 
-wxString end_station_configuration::get_entity_id()
+wxString end_station_configuration::get_entity_id() const
+{
+    return wxString::Format("0x%llx", (unsigned long long)entity_id);
+}
+
+uint64_t end_station_configuration::get_entity_id_value() const
 {
     return entity_id;
 }
 
-wxString end_station_configuration::get_entity_name()
+const wxString & end_station_configuration::get_entity_name() const
 {
-    return name;
+    return string_pool::get(name);
 }
 
-wxString end_station_configuration::get_default_name()
+const wxString & end_station_configuration::get_default_name() const
 {
-    return default_name;
+    return string_pool::get(default_name);
 }
 
-wxString end_station_configuration::get_mac()
+wxString end_station_configuration::get_mac() const
+{
+    return wxString::Format("%llx", (unsigned long long)mac);
+}
+
+uint64_t end_station_configuration::get_mac_value() const
 {
     return mac;
 }
 
-wxString end_station_configuration::get_fw_ver()
+const wxString & end_station_configuration::get_fw_ver() const
 {
-    return fw_ver;
+    return string_pool::get(fw_ver);
 }
 
-uint32_t end_station_configuration::get_sample_rate()
+uint32_t end_station_configuration::get_sample_rate() const
 {
     return sample_rate;
 }
@@ -77,3 +87,8 @@ int end_station_configuration::set_sample_rate(uint32_t sampling_rate)
     sample_rate = sampling_rate;
     return 0;
 }
+
+void end_station_configuration::set_entity_name(const wxString &entity_name)
+{
+    name = string_pool::intern(entity_name);
+}
@@ -26,62 +26,75 @@
  *
  */
 
+#include <climits>
 #include "end_station_details.h"
 
-wxBEGIN_EVENT_TABLE(end_station_details, wxFrame)
-    EVT_GRID_CELL_CHANGED(end_station_details::OnGridCellChange)
-wxEND_EVENT_TABLE()
-
-
-end_station_details::end_station_details(wxWindow *parent, end_station_configuration *config, stream_configuration *stream_config)
+end_station_details::end_station_details(wxWindow *parent, const config_snapshot &config)
+: m_initial(config), m_live_base(config), m_live_in_flight(false), m_live_dirty(false), m_live_sent(false),
+  m_closing(false), m_alive(new bool(true))
 {
     EndStation_Details_Dialog = new wxDialog(parent, wxID_ANY, wxT("End Station Configuration"),
                                             wxDefaultPosition,
                                             wxSize(500, 700));
     
-    m_entity_name = config->get_entity_name();
-    m_default_name = config->get_default_name();
-    m_entity_id = config->get_entity_id();
-    m_mac = config->get_mac();
-    m_fw_ver = config->get_fw_ver();
-    m_sampling_rate = config->get_sample_rate();
+    const end_station_configuration &entity = config.entity();
+    m_sampling_rate = entity.get_sample_rate();
     
     
-    CreateEndStationDetailsPanel(m_entity_name, m_default_name,
-                                 m_sampling_rate, m_entity_id,
-                                 m_mac, m_fw_ver);
+    CreateEndStationDetailsPanel(entity.get_entity_name(), entity.get_default_name(),
+                                 m_sampling_rate, entity.get_entity_id(),
+                                 entity.get_mac(), entity.get_fw_ver());
     
-    m_stream_input_count = stream_config->get_stream_input_count();
-    m_stream_output_count = stream_config->get_stream_output_count();
+    TRACE_SPAN("gui", "end_station_details.populate_grid");
+
+    m_stream_input_count = config.get_stream_input_count();
+    m_stream_output_count = config.get_stream_output_count();
     
     CreateAndSizeGrid(m_stream_input_count, m_stream_output_count);
     
     for(unsigned int i = 0; i < m_stream_input_count; i++)
     {
-        struct stream_configuration_details m_stream_details;
-        
-        stream_config->get_stream_input_details_by_index(i, m_stream_details);
-        SetInputChannelName(i, m_stream_details.stream_name);
+        const stream_configuration_details &m_stream_details = config.streams(true)[i];
+        SetInputChannelName(i, m_stream_details.get_stream_name());
         SetInputChannelCount(i, m_stream_details.channel_count, m_stream_input_count);
     }
     
     for(unsigned int i = 0; i < m_stream_output_count; i++)
     {
-        struct stream_configuration_details m_stream_details;
-        
-        stream_config->get_stream_output_details_by_index(i, m_stream_details);
-        SetOutputChannelName(i, m_stream_details.stream_name);
+        const stream_configuration_details &m_stream_details = config.streams(false)[i];
+        SetOutputChannelName(i, m_stream_details.get_stream_name());
         SetOutputChannelCount(i, m_stream_details.channel_count, m_stream_output_count);
     }
+
+    SetChannelMappings(input_stream_grid, m_stream_input_count, config.mappings(true));
+    SetChannelMappings(output_stream_grid, m_stream_output_count, config.mappings(false));
+
+    // the dialog is its own top-level window, so its events never reach this frame
+    input_stream_grid->Bind(wxEVT_GRID_CELL_CHANGED, &end_station_details::OnGridCellChange, this);
+    output_stream_grid->Bind(wxEVT_GRID_CELL_CHANGED, &end_station_details::OnGridCellChange, this);
+    sampling_rate->Bind(wxEVT_CHOICE, &end_station_details::OnSamplingRateChange, this);
+    live_checkbox->Bind(wxEVT_CHECKBOX, &end_station_details::OnLiveToggle, this);
+    m_live_timer.SetOwner(EndStation_Details_Dialog);
+    EndStation_Details_Dialog->Bind(wxEVT_TIMER, &end_station_details::OnLiveTimer, this);
     
     EndStation_Details_Dialog->Show();
 }
 
-end_station_details::~end_station_details(){}
+end_station_details::~end_station_details()
+{
+    *m_alive = false;
+    m_live_timer.Stop();
+}
+
+void end_station_details::SetLiveApply(const live_sender &send)
+{
+    m_live_send = send;
+    live_checkbox->Enable(true);
+}
 
-void end_station_details::CreateEndStationDetailsPanel(wxString Entity_Name, wxString Default_Name,
-                                                       uint32_t Sampling_Rate, wxString Entity_ID,
-                                                       wxString Mac, wxString fw_version)
+void end_station_details::CreateEndStationDetailsPanel(const wxString &Entity_Name, const wxString &Default_Name,
+                                                       uint32_t Sampling_Rate, const wxString &Entity_ID,
+                                                       const wxString &Mac, const wxString &fw_version)
 {
     wxBoxSizer* Sizer1  = new wxBoxSizer(wxHORIZONTAL);
     Sizer1->Add(new wxStaticText(EndStation_Details_Dialog, wxID_ANY, "End Station Name: ", wxDefaultPosition, wxSize(125,25)));
@@ -173,12 +186,12 @@ void end_station_details::SetChannelChoice(unsigned int stream_input_count, unsi
     }
 }
 
-void end_station_details::SetInputChannelName(unsigned int stream_index, wxString name)
+void end_station_details::SetInputChannelName(unsigned int stream_index, const wxString &name)
 {
     input_stream_grid->SetCellValue(stream_index, 0, name);
 }
 
-void end_station_details::SetOutputChannelName(unsigned int stream_index, wxString name)
+void end_station_details::SetOutputChannelName(unsigned int stream_index, const wxString &name)
 {
     output_stream_grid->SetCellValue(stream_index, 0, name);
 }
@@ -257,6 +270,77 @@ void end_station_details::SetOutputChannelCount(unsigned int stream_index, unsig
     }
 }
 
+/*
+ * Channel columns 2-9 show the cluster (1-based) each stream channel is
+ * mapped to, followed by ".channel" (1-based) when it is mapped to a channel
+ * other than the first of a multichannel cluster; an empty cell is unmapped.
+ */
+void end_station_details::SetChannelMappings(wxGrid *grid, unsigned int stream_count, const audio_mapping_set &mappings)
+{
+    for(size_t i = 0; i < mappings.size(); i++)
+    {
+        audio_mapping map = mappings.at(i);
+        if(map.stream_index >= stream_count || map.stream_channel >= 8)
+            continue;
+
+        // a stream channel fanned out to several clusters shows the first
+        if(grid->GetCellValue(map.stream_index, 2 + map.stream_channel).IsEmpty())
+        {
+            wxString cell = wxString::Format("%u", map.cluster_offset + 1);
+            if(map.cluster_channel != 0)
+                cell += wxString::Format(".%u", map.cluster_channel + 1);
+            grid->SetCellValue(map.stream_index, 2 + map.stream_channel, cell);
+        }
+    }
+}
+
+void end_station_details::GetChannelMappings(wxGrid *grid, unsigned int stream_count, const audio_mapping_set &initial,
+                                             audio_mapping_set &mappings)
+{
+    mappings = initial;
+
+    for(unsigned int i = 0; i < stream_count; i++)
+    {
+        // channels above a lowered channel count are gone, and so are their mappings
+        unsigned int channel_count = wxAtoi(grid->GetCellValue(i, 1));
+        if(channel_count == 0)
+            channel_count = UINT_MAX;
+        for(size_t m = 0; m < initial.size(); m++)
+        {
+            audio_mapping map = initial.at(m);
+            if(map.stream_index == i && map.stream_channel >= channel_count)
+                mappings.remove(map);
+        }
+
+        for(unsigned int channel = 0; channel < 8 && channel < channel_count; channel++)
+        {
+            std::vector<audio_mapping> current;
+            initial.get_stream_channel(i, channel, current);
+            wxString cell = grid->GetCellValue(i, 2 + channel);
+            long cluster = wxAtol(cell.BeforeFirst('.'));
+            long cluster_channel = cell.Find('.') == wxNOT_FOUND ? 1 : wxAtol(cell.AfterFirst('.'));
+            if(cluster_channel <= 0)
+                cluster_channel = 1;
+
+            if(cluster <= 0)
+            {
+                mappings.remove_stream_channel(i, channel);
+            }
+            else if(current.empty() || current[0].cluster_offset != cluster - 1 ||
+                    current[0].cluster_channel != cluster_channel - 1)
+            {
+                audio_mapping map;
+                map.stream_index = i;
+                map.stream_channel = channel;
+                map.cluster_offset = (uint16_t)(cluster - 1);
+                map.cluster_channel = (uint16_t)(cluster_channel - 1);
+                mappings.remove_stream_channel(i, channel);
+                mappings.add(map);
+            }
+        }
+    }
+}
+
 void end_station_details::CreateInputStreamGridHeader()
 {
     input_stream_header_sizer = new wxBoxSizer(wxHORIZONTAL);
@@ -313,6 +397,9 @@ void end_station_details::CreateAndSizeGrid(unsigned int stream_input_count, uns
 {
     apply_button = new wxButton(EndStation_Details_Dialog, wxID_OK, wxT("Apply"));
     cancel_button = new wxButton(EndStation_Details_Dialog, wxID_CANCEL, wxT("Cancel"));
+    live_checkbox = new wxCheckBox(EndStation_Details_Dialog, wxID_ANY, wxT("Live"));
+    live_checkbox->SetToolTip(wxT("Send edits to the end station as they are made"));
+    live_checkbox->Enable(false);
 
     input_stream_grid = new wxGrid(EndStation_Details_Dialog, wxID_ANY, wxDefaultPosition, wxDefaultSize);
     output_stream_grid = new wxGrid(EndStation_Details_Dialog, wxID_ANY, wxDefaultPosition, wxDefaultSize);
@@ -354,6 +441,7 @@ void end_station_details::CreateAndSizeGrid(unsigned int stream_input_count, uns
     
     button_sizer->Add(apply_button);
     button_sizer->Add(cancel_button);
+    button_sizer->Add(live_checkbox, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 10);
     sizer->Add(button_sizer);
 
     EndStation_Details_Dialog->SetSizer(sizer, true);
@@ -362,47 +450,160 @@ void end_station_details::CreateAndSizeGrid(unsigned int stream_input_count, uns
     output_stream_grid->SetColSize(0, 130);
 }
 
-void end_station_details::OnOK()
+/*
+ * Builds a snapshot from what the dialog currently shows. Only the parts
+ * the operator changed are copied; the rest is shared with the initial
+ * snapshot.
+ */
+config_snapshot end_station_details::ReadGrid()
 {
     int n = sampling_rate->GetSelection(); //return index
-    m_sampling_rate = atoi(sampling_rate->GetString(n)); //return dialog sampling_rate
-    
-    m_end_station_config = new end_station_configuration(m_entity_name, m_entity_id, m_default_name,
-                                                         m_mac, m_fw_ver, m_sampling_rate);
+    uint32_t rate = atoi(sampling_rate->GetString(n)); //return dialog sampling_rate
     
-    m_stream_config = new stream_configuration(m_stream_input_count, m_stream_output_count);
+    config_builder builder(m_initial);
+    builder.set_sample_rate(rate);
     
     for(int i = 0; i < m_stream_input_count; i++)
     {
-        struct stream_configuration_details input_stream_details;
-        
-        input_stream_details.stream_name = input_stream_grid->GetCellValue(i, 0);
-        input_stream_details.channel_count = wxAtoi(input_stream_grid->GetCellValue(i, 1));
-        
-        m_stream_config->input_stream_config.push_back(input_stream_details);
+        builder.set_stream_name(true, i, input_stream_grid->GetCellValue(i, 0));
+        builder.set_stream_channel_count(true, i, wxAtoi(input_stream_grid->GetCellValue(i, 1)));
     }
     
     for(int i = 0; i < m_stream_output_count; i++)
     {
-        struct stream_configuration_details output_stream_details;
-        
-        output_stream_details.stream_name = output_stream_grid->GetCellValue(i, 0);
-        output_stream_details.channel_count = wxAtoi(output_stream_grid->GetCellValue(i, 1));
-        
-        m_stream_config->output_stream_config.push_back(output_stream_details);
+        builder.set_stream_name(false, i, output_stream_grid->GetCellValue(i, 0));
+        builder.set_stream_channel_count(false, i, wxAtoi(output_stream_grid->GetCellValue(i, 1)));
     }
+
+    audio_mapping_set input_mappings;
+    audio_mapping_set output_mappings;
+    GetChannelMappings(input_stream_grid, m_stream_input_count, m_initial.mappings(true), input_mappings);
+    GetChannelMappings(output_stream_grid, m_stream_output_count, m_initial.mappings(false), output_mappings);
+    builder.set_mappings(true, input_mappings);
+    builder.set_mappings(false, output_mappings);
+
+    return builder.build();
+}
+
+void end_station_details::OnOK()
+{
+    m_live_timer.Stop();
+    m_result = ReadGrid();
+    m_sampling_rate = m_result.entity().get_sample_rate();
+}
+
+void end_station_details::ApplyAndDestroy()
+{
+    m_closing = true;
+    if(!m_live_in_flight)
+        SendFinalApply();
 }
 
 void end_station_details::OnCancel()
 {
-    Destroy();
+    m_live_timer.Stop();
+    if(!m_live_sent)
+    {
+        *m_alive = false;
+        Destroy();
+        return;
+    }
+
+    // the final send takes the device from what live mode committed back to where it started
+    m_result = m_initial;
+    ApplyAndDestroy();
 }
 
 int end_station_details::ShowModal()
 {
     return EndStation_Details_Dialog->ShowModal();
 }
+
 void end_station_details::OnGridCellChange(wxGridEvent &event)
 {
-    std::cout << "grid changed" << std::endl;
+    ScheduleLiveApply();
+    event.Skip();
+}
+
+void end_station_details::OnSamplingRateChange(wxCommandEvent &event)
+{
+    ScheduleLiveApply();
+    event.Skip();
+}
+
+void end_station_details::OnLiveToggle(wxCommandEvent &event)
+{
+    // edits made before live mode was switched on go out straight away
+    if(event.IsChecked())
+        ScheduleLiveApply();
+    else
+        m_live_timer.Stop();
+}
+
+void end_station_details::ScheduleLiveApply()
+{
+    if(!m_live_send || !live_checkbox->IsChecked())
+        return;
+
+    // every edit pushes the send back, so a burst of edits collapses into one
+    m_live_timer.StartOnce(live_apply_delay_ms);
+}
+
+void end_station_details::OnLiveTimer(wxTimerEvent &WXUNUSED(event))
+{
+    SendLiveApply();
+}
+
+void end_station_details::SendLiveApply()
+{
+    if(m_closing)
+        return;
+    if(m_live_in_flight)
+    {
+        m_live_dirty = true;
+        return;
+    }
+
+    config_snapshot from = m_live_base;
+    config_snapshot to = ReadGrid();
+    m_live_base = to;
+    m_live_in_flight = true;
+    m_live_dirty = false;
+    m_live_sent = true;
+
+    std::shared_ptr<bool> alive = m_alive;
+    m_live_send(from, to, [this, alive, from](bool committed)
+    {
+        if(!*alive)
+            return;
+
+        // a rolled back change is sent again with the next edit, or now if edits are waiting
+        m_live_in_flight = false;
+        if(!committed)
+            m_live_base = from;
+        if(m_closing)
+            SendFinalApply();
+        else if(m_live_dirty)
+            SendLiveApply();
+    });
+}
+
+/*
+ * m_live_base is what the device last committed, so a live apply that was
+ * rolled back is sent again here.
+ */
+void end_station_details::SendFinalApply()
+{
+    if(!m_live_send)
+    {
+        Destroy();
+        return;
+    }
+
+    std::shared_ptr<bool> alive = m_alive;
+    m_live_send(m_live_base, m_result, [this, alive](bool)
+    {
+        if(*alive)
+            Destroy();
+    });
 }
@@ -0,0 +1,375 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * end_station_list.cpp
+ *
+ */
+
+#include <algorithm>
+#include <ctype.h>
+#include "end_station_list.h"
+#include "trace_log.h"
+
+wxBEGIN_EVENT_TABLE(end_station_list, wxListCtrl)
+    EVT_LIST_COL_CLICK(wxID_ANY, end_station_list::OnColumnClick)
+wxEND_EVENT_TABLE()
+
+end_station_list::end_station_list(wxWindow *parent, wxWindowID id, const wxPoint &pos, const wxSize &size)
+: wxListCtrl(parent, id, pos, size, wxLC_REPORT | wxLC_VIRTUAL)
+{
+    m_sort_column = -1; // discovery order
+    m_sort_ascending = true;
+    m_rows_stale = true;
+    m_dirty_first = -1;
+    m_dirty_last = -1;
+}
+
+end_station_list::~end_station_list() {}
+
+void end_station_list::update_entity(const entity_record &record)
+{
+    uint32_t slot;
+    long old_row = -1;
+    std::unordered_map<uint64_t, uint32_t>::const_iterator it = m_slots.find(record.entity_id);
+
+    if(it == m_slots.end())
+    {
+        // a new slot can land anywhere in the rows, so they are rebuilt
+        m_rows_stale = true;
+        slot = (uint32_t)m_entities.size();
+        m_slots.insert(std::make_pair(record.entity_id, slot));
+        m_entities.push_back(record);
+        m_entities[slot].name_key = natural_sort_key(string_pool::get(record.name));
+        m_entities[slot].fw_ver_key = natural_sort_key(string_pool::get(record.fw_ver));
+        insert_into_order(slot);
+    }
+    else
+    {
+        slot = it->second;
+        const entity_record &current = m_entities[slot];
+        if(current.same_state(record))
+        {
+            return;
+        }
+
+        // the row is found with the keys it was placed by, before they change
+        if(!m_rows_stale)
+            old_row = remove_from_rows(slot);
+        remove_from_order(slot);
+        std::string name_key = current.name == record.name ? current.name_key : natural_sort_key(string_pool::get(record.name));
+        std::string fw_ver_key = current.fw_ver == record.fw_ver ? current.fw_ver_key : natural_sort_key(string_pool::get(record.fw_ver));
+        m_entities[slot] = record;
+        m_entities[slot].name_key.swap(name_key);
+        m_entities[slot].fw_ver_key.swap(fw_ver_key);
+        insert_into_order(slot);
+    }
+
+    std::vector<std::string> fields;
+    fields.push_back((const char *)string_pool::get(record.name).utf8_str());
+    fields.push_back((const char *)wxString::Format("0x%llx", (unsigned long long)record.entity_id).utf8_str());
+    fields.push_back((const char *)wxString::Format("%llx", (unsigned long long)record.mac).utf8_str());
+    fields.push_back((const char *)string_pool::get(record.fw_ver).utf8_str());
+    m_search_index.update(slot, fields);
+
+    if(m_rows_stale)
+        return;
+
+    long new_row = m_search_index.matches(slot, m_filter) ? insert_into_rows(slot) : -1;
+    if(old_row < 0 && new_row < 0)
+        return;
+
+    // rows between the old and the new place shift by one; a row that leaves or joins shifts all after it
+    long end = (long)m_rows.size();
+    if(old_row < 0 || new_row < 0)
+        mark_rows_dirty(std::max(old_row, new_row), end);
+    else
+        mark_rows_dirty(std::min(old_row, new_row), std::max(old_row, new_row));
+}
+
+std::string end_station_list::natural_sort_key(const wxString &text)
+{
+    // Lower-case the text and zero-pad digit runs so that a plain byte
+    // compare orders "1.10" after "1.9" and "Unit 10" after "Unit 2".
+    const size_t digit_width = 20;
+    std::string utf8((const char *)text.utf8_str());
+    std::string key;
+    key.reserve(utf8.size() + 8);
+
+    for(size_t i = 0; i < utf8.size();)
+    {
+        if(isdigit((unsigned char)utf8[i]))
+        {
+            size_t start = i;
+            while(i < utf8.size() && isdigit((unsigned char)utf8[i]))
+                i++;
+            while(start < i - 1 && utf8[start] == '0')
+                start++;
+            if(i - start < digit_width)
+                key.append(digit_width - (i - start), '0');
+            key.append(utf8, start, i - start);
+        }
+        else
+        {
+            key += (char)tolower((unsigned char)utf8[i]);
+            i++;
+        }
+    }
+    return key;
+}
+
+bool end_station_list::slot_less(uint32_t a, uint32_t b) const
+{
+    const entity_record &ra = m_entities[a];
+    const entity_record &rb = m_entities[b];
+    int cmp = 0;
+
+    switch(m_sort_column)
+    {
+        case 0:
+            cmp = (ra.connection_status > rb.connection_status) - (ra.connection_status < rb.connection_status);
+            break;
+        case 1:
+            cmp = ra.name_key.compare(rb.name_key);
+            break;
+        case 2:
+            cmp = (ra.entity_id > rb.entity_id) - (ra.entity_id < rb.entity_id);
+            break;
+        case 3:
+            cmp = ra.fw_ver_key.compare(rb.fw_ver_key);
+            break;
+        case 4:
+            cmp = (ra.mac > rb.mac) - (ra.mac < rb.mac);
+            break;
+        case 5:
+            cmp = (ra.interface_index > rb.interface_index) - (ra.interface_index < rb.interface_index);
+            break;
+        default:
+            break;
+    }
+
+    if(cmp != 0)
+        return m_sort_ascending ? cmp < 0 : cmp > 0;
+
+    // slots are allocated in discovery order, which keeps equal keys stable
+    return a < b;
+}
+
+void end_station_list::remove_from_order(uint32_t slot)
+{
+    slot_order order = {this};
+    std::vector<uint32_t>::iterator it = std::lower_bound(m_order.begin(), m_order.end(), slot, order);
+    if(it != m_order.end() && *it == slot)
+        m_order.erase(it);
+}
+
+void end_station_list::insert_into_order(uint32_t slot)
+{
+    slot_order order = {this};
+    m_order.insert(std::upper_bound(m_order.begin(), m_order.end(), slot, order), slot);
+}
+
+long end_station_list::remove_from_rows(uint32_t slot)
+{
+    slot_order order = {this};
+    std::vector<uint32_t>::iterator it = std::lower_bound(m_rows.begin(), m_rows.end(), slot, order);
+    if(it == m_rows.end() || *it != slot)
+        return -1;
+
+    long row = (long)(it - m_rows.begin());
+    m_rows.erase(it);
+    return row;
+}
+
+long end_station_list::insert_into_rows(uint32_t slot)
+{
+    slot_order order = {this};
+    std::vector<uint32_t>::iterator it = std::upper_bound(m_rows.begin(), m_rows.end(), slot, order);
+    long row = (long)(it - m_rows.begin());
+    m_rows.insert(it, slot);
+    return row;
+}
+
+void end_station_list::mark_rows_dirty(long first, long last)
+{
+    if(m_dirty_first < 0 || first < m_dirty_first)
+        m_dirty_first = first;
+    if(last > m_dirty_last)
+        m_dirty_last = last;
+}
+
+void end_station_list::sort_by_column(int column, bool ascending)
+{
+    TRACE_SPAN("gui", "end_station_list.sort_by_column");
+
+    m_sort_column = column;
+    m_sort_ascending = ascending;
+
+    slot_order order = {this};
+    std::sort(m_order.begin(), m_order.end(), order);
+    m_rows_stale = true;
+    update_column_headers();
+    refresh_rows();
+}
+
+void end_station_list::OnColumnClick(wxListEvent& event)
+{
+    int column = event.GetColumn();
+    if(column < 0)
+        return;
+
+    if(column == m_sort_column)
+        sort_by_column(column, !m_sort_ascending);
+    else
+        sort_by_column(column, true);
+}
+
+void end_station_list::update_column_headers()
+{
+    if(m_column_titles.empty())
+    {
+        for(int i = 0; i < GetColumnCount(); i++)
+        {
+            wxListItem item;
+            item.SetMask(wxLIST_MASK_TEXT);
+            GetColumn(i, item);
+            m_column_titles.push_back(item.GetText());
+        }
+    }
+
+    for(int i = 0; i < (int)m_column_titles.size(); i++)
+    {
+        wxListItem item;
+        item.SetMask(wxLIST_MASK_TEXT);
+        if(i == m_sort_column)
+            item.SetText(m_column_titles[i] + (m_sort_ascending ? wxT(" \u25B2") : wxT(" \u25BC")));
+        else
+            item.SetText(m_column_titles[i]);
+        SetColumn(i, item);
+    }
+}
+
+void end_station_list::set_filter(const wxString &filter)
+{
+    std::string utf8((const char *)filter.utf8_str());
+    if(utf8 == m_filter)
+        return;
+
+    m_filter.swap(utf8);
+    m_rows_stale = true;
+    refresh_rows();
+}
+
+void end_station_list::refresh_rows()
+{
+    TRACE_SPAN("gui", "end_station_list.refresh_rows");
+
+    if(!m_rows_stale)
+    {
+        if(m_dirty_first < 0)
+            return;
+
+        long count = (long)m_rows.size();
+        if(GetItemCount() != count)
+            SetItemCount(count);
+        if(m_dirty_first < count)
+            RefreshItems(m_dirty_first, std::min(m_dirty_last, count - 1));
+        m_dirty_first = -1;
+        m_dirty_last = -1;
+        return;
+    }
+
+    m_search_index.query(m_filter, m_matches);
+
+    m_match_flags.assign(m_entities.size(), 0);
+    for(size_t i = 0; i < m_matches.size(); i++)
+        m_match_flags[m_matches[i]] = 1;
+
+    m_rows.clear();
+    for(size_t i = 0; i < m_order.size(); i++)
+    {
+        if(m_match_flags[m_order[i]])
+            m_rows.push_back(m_order[i]);
+    }
+    SetItemCount((long)m_rows.size());
+    Refresh();
+    m_rows_stale = false;
+    m_dirty_first = -1;
+    m_dirty_last = -1;
+}
+
+size_t end_station_list::get_entity_count() const
+{
+    return m_entities.size();
+}
+
+const entity_record & end_station_list::get_entity(size_t slot) const
+{
+    return m_entities.at(slot);
+}
+
+const entity_record * end_station_list::get_entity_by_row(long row) const
+{
+    if(row < 0 || (size_t)row >= m_rows.size())
+        return NULL;
+
+    return &m_entities[m_rows[row]];
+}
+
+const entity_record * end_station_list::get_entity_by_id(uint64_t entity_id) const
+{
+    std::unordered_map<uint64_t, uint32_t>::const_iterator it = m_slots.find(entity_id);
+    if(it == m_slots.end())
+        return NULL;
+
+    return &m_entities[it->second];
+}
+
+wxString end_station_list::OnGetItemText(long item, long column) const
+{
+    const entity_record *record = get_entity_by_row(item);
+    if(!record)
+        return wxEmptyString;
+    return format_cell(*record, column);
+}
+
+wxString end_station_list::format_cell(const entity_record &record, long column)
+{
+    switch(column)
+    {
+        case 0:
+            return wxString(record.connection_status);
+        case 1:
+            return string_pool::get(record.name);
+        case 2:
+            return wxString::Format("0x%llx", (unsigned long long)record.entity_id);
+        case 3:
+            return string_pool::get(record.fw_ver);
+        case 4:
+            return wxString::Format("%llx", (unsigned long long)record.mac);
+        case 5:
+            return string_pool::get(record.interface_name);
+        default:
+            return wxEmptyString;
+    }
+}
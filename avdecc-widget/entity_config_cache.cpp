@@ -0,0 +1,197 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * entity_config_cache.cpp
+ *
+ */
+
+#include "entity_config_cache.h"
+
+entity_config_cache::entity_config_cache() {}
+
+entity_config_cache::~entity_config_cache() {}
+
+void entity_config_cache::track(uint64_t entity_id, uint64_t now_ms)
+{
+    std::unordered_map<uint64_t, entry>::iterator it = m_entries.find(entity_id);
+    if(it != m_entries.end())
+        return;
+
+    entry e;
+    e.next_registration_ms = now_ms ? now_ms : 1;
+    e.registered = false;
+    m_entries.insert(std::make_pair(entity_id, e));
+}
+
+void entity_config_cache::remove(uint64_t entity_id)
+{
+    m_entries.erase(entity_id);
+}
+
+void entity_config_cache::clear()
+{
+    m_entries.clear();
+}
+
+void entity_config_cache::take_due_registrations(uint64_t now_ms, std::vector<uint64_t> &entity_ids)
+{
+    for(std::unordered_map<uint64_t, entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it)
+    {
+        entry &e = it->second;
+        if(e.next_registration_ms && e.next_registration_ms <= now_ms)
+        {
+            entity_ids.push_back(it->first);
+            e.next_registration_ms = now_ms + registration_retry_ms;
+        }
+    }
+}
+
+void entity_config_cache::registration_succeeded(uint64_t entity_id, uint64_t now_ms)
+{
+    std::unordered_map<uint64_t, entry>::iterator it = m_entries.find(entity_id);
+    if(it == m_entries.end())
+        return;
+
+    it->second.registered = true;
+    it->second.next_registration_ms = now_ms + registration_renew_ms;
+}
+
+void entity_config_cache::registration_unsupported(uint64_t entity_id)
+{
+    std::unordered_map<uint64_t, entry>::iterator it = m_entries.find(entity_id);
+    if(it == m_entries.end())
+        return;
+
+    it->second.registered = false;
+    it->second.next_registration_ms = 0;
+}
+
+/*
+ * Changes made while the registration was lapsed were never reported, so
+ * the cached configuration is dropped until it is read again.
+ */
+void entity_config_cache::registration_failed(uint64_t entity_id)
+{
+    std::unordered_map<uint64_t, entry>::iterator it = m_entries.find(entity_id);
+    if(it == m_entries.end())
+        return;
+
+    it->second.registered = false;
+    it->second.snapshot = config_snapshot();
+}
+
+bool entity_config_cache::is_registered(uint64_t entity_id) const
+{
+    std::unordered_map<uint64_t, entry>::const_iterator it = m_entries.find(entity_id);
+    return it != m_entries.end() && it->second.registered;
+}
+
+const config_snapshot * entity_config_cache::find(uint64_t entity_id) const
+{
+    std::unordered_map<uint64_t, entry>::const_iterator it = m_entries.find(entity_id);
+    if(it == m_entries.end() || !it->second.snapshot.is_valid())
+        return NULL;
+    return &it->second.snapshot;
+}
+
+void entity_config_cache::store(uint64_t entity_id, const config_snapshot &snapshot)
+{
+    std::unordered_map<uint64_t, entry>::iterator it = m_entries.find(entity_id);
+    if(it == m_entries.end())
+    {
+        track(entity_id, 0);
+        it = m_entries.find(entity_id);
+    }
+    it->second.snapshot = snapshot;
+}
+
+bool entity_config_cache::set_sample_rate(uint64_t entity_id, uint32_t sample_rate)
+{
+    entry *e = find_cached(entity_id);
+    if(!e)
+        return false;
+
+    config_builder builder(e->snapshot);
+    builder.set_sample_rate(sample_rate);
+    e->snapshot = builder.build();
+    return true;
+}
+
+bool entity_config_cache::set_entity_name(uint64_t entity_id, const wxString &name)
+{
+    entry *e = find_cached(entity_id);
+    if(!e)
+        return false;
+
+    config_builder builder(e->snapshot);
+    builder.set_entity_name(name);
+    e->snapshot = builder.build();
+    return true;
+}
+
+bool entity_config_cache::set_stream_name(uint64_t entity_id, bool input, uint16_t stream_index, const wxString &name)
+{
+    entry *e = find_cached(entity_id);
+    if(!e)
+        return false;
+
+    config_builder builder(e->snapshot);
+    if(!builder.set_stream_name(input, stream_index, name))
+        return false;
+    e->snapshot = builder.build();
+    return true;
+}
+
+bool entity_config_cache::set_stream_channel_count(uint64_t entity_id, bool input, uint16_t stream_index, unsigned int channel_count)
+{
+    entry *e = find_cached(entity_id);
+    if(!e)
+        return false;
+
+    config_builder builder(e->snapshot);
+    if(!builder.set_stream_channel_count(input, stream_index, channel_count))
+        return false;
+    e->snapshot = builder.build();
+    return true;
+}
+
+bool entity_config_cache::set_audio_mappings(uint64_t entity_id, bool input, const audio_mapping_set &mappings)
+{
+    entry *e = find_cached(entity_id);
+    if(!e)
+        return false;
+
+    config_builder builder(e->snapshot);
+    builder.set_mappings(input, mappings);
+    e->snapshot = builder.build();
+    return true;
+}
+
+entity_config_cache::entry * entity_config_cache::find_cached(uint64_t entity_id)
+{
+    std::unordered_map<uint64_t, entry>::iterator it = m_entries.find(entity_id);
+    if(it == m_entries.end() || !it->second.snapshot.is_valid())
+        return NULL;
+    return &it->second;
+}
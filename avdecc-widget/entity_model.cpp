@@ -0,0 +1,103 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * entity_model.cpp
+ *
+ */
+
+#include <algorithm>
+#include "entity_model.h"
+
+bool stream_model::supports(uint64_t format_value) const
+{
+    return std::find(formats.begin(), formats.end(), format_value) != formats.end();
+}
+
+entity_model::entity_model(uint64_t model_id) : m_model_id(model_id)
+{
+    std::fill(m_strings, m_strings + strings_count, 0);
+}
+
+entity_model::~entity_model() {}
+
+const wxString & entity_model::get_string(size_t index) const
+{
+    return string_pool::get(index < strings_count ? m_strings[index] : 0);
+}
+
+const stream_model * entity_model::find_stream(bool input, size_t stream_index) const
+{
+    const std::vector<stream_model> &list = input ? m_inputs : m_outputs;
+    return stream_index < list.size() ? &list[stream_index] : NULL;
+}
+
+void entity_model::set_string(size_t index, const wxString &str)
+{
+    if(index < strings_count)
+        m_strings[index] = string_pool::intern(str);
+}
+
+void entity_model::add_stream(bool input, const stream_model &stream)
+{
+    (input ? m_inputs : m_outputs).push_back(stream);
+}
+
+entity_model_registry::entity_model_registry() : m_shared_count(0) {}
+
+entity_model_registry::~entity_model_registry() {}
+
+std::shared_ptr<const entity_model> entity_model_registry::find(uint64_t model_id) const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    std::unordered_map<uint64_t, std::shared_ptr<const entity_model>>::const_iterator it = m_models.find(model_id);
+    if(it == m_models.end())
+        return std::shared_ptr<const entity_model>();
+
+    m_shared_count++;
+    return it->second;
+}
+
+std::shared_ptr<const entity_model> entity_model_registry::insert(const std::shared_ptr<const entity_model> &model)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+
+    // entity_model_id 0 means the entity does not identify its model
+    if(model->get_model_id() == 0)
+        return model;
+
+    return m_models.insert(std::make_pair(model->get_model_id(), model)).first->second;
+}
+
+size_t entity_model_registry::size() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_models.size();
+}
+
+uint64_t entity_model_registry::get_shared_count() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_shared_count;
+}
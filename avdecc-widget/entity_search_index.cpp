@@ -0,0 +1,221 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * entity_search_index.cpp
+ *
+ */
+
+#include <algorithm>
+#include <ctype.h>
+#include "entity_search_index.h"
+
+namespace
+{
+    const char field_separator = '\x1f';
+}
+
+entity_search_index::entity_search_index()
+{
+    m_count = 0;
+    m_version = 1;
+    m_last_version = 0;
+}
+
+entity_search_index::~entity_search_index() {}
+
+uint32_t entity_search_index::trigram_at(const std::string &text, size_t pos)
+{
+    return ((uint32_t)(uint8_t)text[pos] << 16) | ((uint32_t)(uint8_t)text[pos + 1] << 8) | (uint8_t)text[pos + 2];
+}
+
+std::string entity_search_index::to_lower(const std::string &text)
+{
+    std::string lower(text);
+    for(size_t i = 0; i < lower.size(); i++)
+        lower[i] = (char)tolower((unsigned char)lower[i]);
+    return lower;
+}
+
+void entity_search_index::update(uint32_t slot, const std::vector<std::string> &fields)
+{
+    std::string text;
+    for(size_t i = 0; i < fields.size(); i++)
+    {
+        if(i)
+            text += field_separator;
+        text += to_lower(fields[i]);
+    }
+
+    if(slot >= m_text.size())
+    {
+        m_text.resize(slot + 1);
+        m_present.resize(slot + 1, false);
+    }
+
+    if(m_present[slot])
+    {
+        if(m_text[slot] == text)
+            return;
+        remove_postings(slot, m_text[slot]);
+    }
+    else
+    {
+        m_present[slot] = true;
+        m_count++;
+    }
+
+    m_text[slot] = text;
+    add_postings(slot, text);
+    m_version++;
+}
+
+void entity_search_index::remove(uint32_t slot)
+{
+    if(slot >= m_text.size() || !m_present[slot])
+        return;
+
+    remove_postings(slot, m_text[slot]);
+    m_text[slot].clear();
+    m_present[slot] = false;
+    m_count--;
+    m_version++;
+}
+
+void entity_search_index::clear()
+{
+    m_text.clear();
+    m_present.clear();
+    m_postings.clear();
+    m_count = 0;
+    m_version++;
+}
+
+bool entity_search_index::matches(uint32_t slot, const std::string &query) const
+{
+    if(slot >= m_present.size() || !m_present[slot])
+        return false;
+    return m_text[slot].find(to_lower(query)) != std::string::npos;
+}
+
+size_t entity_search_index::size() const
+{
+    return m_count;
+}
+
+void entity_search_index::add_postings(uint32_t slot, const std::string &text)
+{
+    for(size_t i = 0; i + 3 <= text.size(); i++)
+    {
+        std::vector<uint32_t> &list = m_postings[trigram_at(text, i)];
+        std::vector<uint32_t>::iterator it = std::lower_bound(list.begin(), list.end(), slot);
+        if(it == list.end() || *it != slot)
+            list.insert(it, slot);
+    }
+}
+
+void entity_search_index::remove_postings(uint32_t slot, const std::string &text)
+{
+    for(size_t i = 0; i + 3 <= text.size(); i++)
+    {
+        std::unordered_map<uint32_t, std::vector<uint32_t> >::iterator p = m_postings.find(trigram_at(text, i));
+        if(p == m_postings.end())
+            continue;
+
+        std::vector<uint32_t> &list = p->second;
+        std::vector<uint32_t>::iterator it = std::lower_bound(list.begin(), list.end(), slot);
+        if(it != list.end() && *it == slot)
+            list.erase(it);
+        if(list.empty())
+            m_postings.erase(p);
+    }
+}
+
+void entity_search_index::verify(const std::string &query, const std::vector<uint32_t> &candidates,
+                                 std::vector<uint32_t> &matches) const
+{
+    for(size_t i = 0; i < candidates.size(); i++)
+    {
+        uint32_t slot = candidates[i];
+        if(m_present[slot] && m_text[slot].find(query) != std::string::npos)
+            matches.push_back(slot);
+    }
+}
+
+void entity_search_index::query(const std::string &query, std::vector<uint32_t> &matches)
+{
+    matches.clear();
+    std::string q = to_lower(query);
+
+    if(q.empty())
+    {
+        for(uint32_t slot = 0; slot < m_present.size(); slot++)
+        {
+            if(m_present[slot])
+                matches.push_back(slot);
+        }
+        return;
+    }
+
+    const std::vector<uint32_t> *candidates = NULL;
+    std::vector<uint32_t> all_slots;
+
+    // typing more characters only narrows the previous result
+    if(m_last_version == m_version && !m_last_query.empty() && q.find(m_last_query) != std::string::npos)
+    {
+        candidates = &m_last_matches;
+    }
+
+    if(q.size() >= 3)
+    {
+        for(size_t i = 0; i + 3 <= q.size(); i++)
+        {
+            std::unordered_map<uint32_t, std::vector<uint32_t> >::const_iterator p = m_postings.find(trigram_at(q, i));
+            if(p == m_postings.end())
+            {
+                m_last_query = q;
+                m_last_matches.clear();
+                m_last_version = m_version;
+                return;
+            }
+            if(!candidates || p->second.size() < candidates->size())
+                candidates = &p->second;
+        }
+    }
+
+    if(!candidates)
+    {
+        for(uint32_t slot = 0; slot < m_present.size(); slot++)
+        {
+            if(m_present[slot])
+                all_slots.push_back(slot);
+        }
+        candidates = &all_slots;
+    }
+
+    verify(q, *candidates, matches);
+
+    m_last_query = q;
+    m_last_matches = matches;
+    m_last_version = m_version;
+}
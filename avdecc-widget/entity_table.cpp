@@ -0,0 +1,161 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * entity_table.cpp
+ *
+ */
+
+#include "entity_table.h"
+
+bool entity_stream::operator==(const entity_stream &other) const
+{
+    return input == other.input && stream_index == other.stream_index && name == other.name && format == other.format;
+}
+
+bool entity_record::same_state(const entity_record &other) const
+{
+    return entity_id == other.entity_id && name == other.name && fw_ver == other.fw_ver && mac == other.mac &&
+           entity_model_id == other.entity_model_id && interface_name == other.interface_name &&
+           connection_status == other.connection_status &&
+           interface_index == other.interface_index &&
+           end_station_index == other.end_station_index &&
+           enumerated == other.enumerated && sample_rate == other.sample_rate &&
+           avb_interface_count == other.avb_interface_count && clock_domain_count == other.clock_domain_count &&
+           streams == other.streams;
+}
+
+const entity_stream * entity_record::find_stream(bool input, uint16_t stream_index) const
+{
+    for(size_t i = 0; i < streams.size(); i++)
+    {
+        if(streams[i].input == input && streams[i].stream_index == stream_index)
+            return &streams[i];
+    }
+    return NULL;
+}
+
+entity_table::version::version() : m_generation(0), m_size(0) {}
+
+entity_table::entity_table()
+{
+    std::atomic_store(&m_current, std::shared_ptr<const version>(new version()));
+}
+
+entity_table::~entity_table() {}
+
+void entity_table::set_reader(const reader &read)
+{
+    std::lock_guard<std::mutex> guard(m_writer_lock);
+    m_read = read;
+}
+
+std::shared_ptr<const entity_table::version> entity_table::current() const
+{
+    return std::atomic_load(&m_current);
+}
+
+void entity_table::refresh(uint32_t interface_index, uint64_t entity_id)
+{
+    refresh(interface_index, std::vector<uint64_t>(1, entity_id));
+}
+
+void entity_table::refresh(uint32_t interface_index, const std::vector<uint64_t> &entity_ids)
+{
+    std::lock_guard<std::mutex> guard(m_writer_lock);
+    if(!m_read)
+        return;
+
+    // only writers store to m_current, and they hold m_writer_lock
+    std::shared_ptr<const version> previous = std::atomic_load(&m_current);
+    std::shared_ptr<version> next(new version(*previous));
+    next->m_generation = previous->m_generation + 1;
+
+    bool changed = false;
+    for(size_t i = 0; i < entity_ids.size(); i++)
+    {
+        std::unordered_map<uint64_t, size_t>::const_iterator it = m_slots.find(entity_ids[i]);
+        if(it != m_slots.end() && next->at(it->second).interface_index != interface_index)
+            continue;
+
+        entity_record record = entity_record();
+        if(m_read(interface_index, entity_ids[i], record))
+            changed |= apply(*next, record);
+    }
+
+    if(changed)
+        std::atomic_store(&m_current, std::shared_ptr<const version>(next));
+}
+
+/*
+ * Writes one record into the next version, cloning its chunk the first
+ * time the chunk is touched in this generation. Slots never move, so an
+ * entity that disconnects keeps its row with the new connection status.
+ */
+bool entity_table::apply(version &next, const entity_record &record)
+{
+    std::unordered_map<uint64_t, size_t>::iterator it = m_slots.find(record.entity_id);
+    size_t slot = it == m_slots.end() ? next.m_size : it->second;
+    size_t index = slot / chunk_size;
+
+    if(it != m_slots.end() && next.m_chunks[index]->records[slot % chunk_size].same_state(record))
+        return false;
+
+    if(index == next.m_chunks.size())
+    {
+        next.m_chunks.push_back(std::shared_ptr<const chunk>());
+    }
+
+    std::shared_ptr<const chunk> &target = next.m_chunks[index];
+    if(!target || target->generation != next.m_generation)
+    {
+        std::shared_ptr<chunk> copy(target ? new chunk(*target) : new chunk());
+        copy->generation = next.m_generation;
+        target = copy;
+    }
+
+    // chunks cloned in this generation are not published yet, so they are still writable
+    chunk &writable = const_cast<chunk &>(*target);
+    if(it == m_slots.end())
+    {
+        m_slots.insert(std::make_pair(record.entity_id, slot));
+        writable.records.push_back(record);
+        next.m_size++;
+    }
+    else
+    {
+        writable.records[slot % chunk_size] = record;
+    }
+    return true;
+}
+
+void entity_table::clear()
+{
+    std::lock_guard<std::mutex> guard(m_writer_lock);
+
+    std::shared_ptr<const version> previous = std::atomic_load(&m_current);
+    std::shared_ptr<version> next(new version());
+    next->m_generation = previous->m_generation + 1;
+    m_slots.clear();
+    std::atomic_store(&m_current, std::shared_ptr<const version>(next));
+}
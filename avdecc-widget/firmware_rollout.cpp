@@ -0,0 +1,418 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * firmware_rollout.cpp
+ *
+ */
+
+#include <algorithm>
+#include <cassert>
+#include "firmware_rollout.h"
+
+rollout_options::rollout_options()
+{
+    parallelism = 8;
+    first_wave_size = 1;
+    wave_size = 32;
+    max_failures = 0;
+    max_attempts = 3;
+    reboot_timeout_ms = 120000;
+    verify_timeout_ms = 30000;
+    verify_retry_ms = 5000;
+    retry_delay_ms = 5000;
+}
+
+firmware_rollout::firmware_rollout()
+{
+    m_stage_counts.resize(ROLLOUT_SKIPPED + 1);
+    m_wave = 0;
+    m_wave_count = 0;
+    m_active_uploads = 0;
+    m_running = false;
+    m_started_ms = 0;
+}
+
+firmware_rollout::~firmware_rollout()
+{
+    abort();
+}
+
+void firmware_rollout::start(const std::vector<uint64_t> &targets, const std::string &target_version,
+                             const rollout_options &options, uint64_t now_ms)
+{
+    abort();
+
+    m_devices.clear();
+    m_index.clear();
+    m_changed.clear();
+    m_stage_counts.assign(ROLLOUT_SKIPPED + 1, 0);
+    m_target_version = target_version;
+    m_options = options;
+    if(m_options.parallelism == 0)
+        m_options.parallelism = 1;
+    if(m_options.wave_size == 0)
+        m_options.wave_size = (unsigned int)targets.size();
+    if(m_options.max_attempts == 0)
+        m_options.max_attempts = 1;
+
+    // the first wave is a canary; the rest are sized by wave_size
+    unsigned int wave = 0;
+    size_t wave_fill = 0;
+    size_t wave_limit = m_options.first_wave_size ? m_options.first_wave_size : m_options.wave_size;
+    for(size_t i = 0; i < targets.size(); i++)
+    {
+        if(m_index.count(targets[i]))
+            continue;
+
+        if(wave_fill == wave_limit)
+        {
+            wave++;
+            wave_fill = 0;
+            wave_limit = m_options.wave_size;
+        }
+        wave_fill++;
+
+        rollout_device device = rollout_device();
+        device.entity_id = targets[i];
+        device.wave = wave;
+        device.stage = ROLLOUT_PENDING;
+        device.stage_ms = now_ms;
+        m_index[device.entity_id] = m_devices.size();
+        m_devices.push_back(device);
+    }
+
+    m_stage_counts[ROLLOUT_PENDING] = m_devices.size();
+    m_wave = 0;
+    m_wave_count = m_devices.empty() ? 0 : wave + 1;
+    m_active_uploads = 0;
+    m_running = !m_devices.empty();
+    m_started_ms = now_ms;
+}
+
+void firmware_rollout::abort()
+{
+    for(size_t i = 0; i < m_devices.size(); i++)
+    {
+        rollout_device &device = m_devices[i];
+        if(device.upload)
+        {
+            device.upload->cancel();
+            device.upload.reset();
+        }
+        if(device.stage == ROLLOUT_PENDING || device.stage == ROLLOUT_UPLOADING)
+            set_stage(device, ROLLOUT_SKIPPED, device.stage_ms);
+        // the image is on the device, but nothing will confirm it now
+        else if(device.stage == ROLLOUT_REBOOTING || device.stage == ROLLOUT_VERIFYING)
+            fail(device, "rollout aborted before the new version was confirmed", device.stage_ms);
+    }
+    m_active_uploads = 0;
+    m_running = false;
+}
+
+void firmware_rollout::set_stage(rollout_device &device, rollout_stage stage, uint64_t now_ms)
+{
+    if(device.stage == ROLLOUT_UPLOADING)
+        m_active_uploads--;
+    if(stage == ROLLOUT_UPLOADING)
+        m_active_uploads++;
+
+    m_stage_counts[device.stage]--;
+    m_stage_counts[stage]++;
+    device.stage = stage;
+    device.stage_ms = now_ms;
+    m_changed.push_back(&device - &m_devices[0]);
+}
+
+void firmware_rollout::retry_later(rollout_device &device, uint64_t now_ms)
+{
+    unsigned int doublings = std::min(device.attempts, 8u) - 1;
+    device.retry_ms = now_ms + ((uint64_t)m_options.retry_delay_ms << doublings);
+}
+
+void firmware_rollout::fail(rollout_device &device, const std::string &error, uint64_t now_ms)
+{
+    device.error = error;
+    device.upload.reset();
+    set_stage(device, ROLLOUT_FAILED, now_ms);
+}
+
+bool firmware_rollout::wave_finished() const
+{
+    for(size_t i = 0; i < m_devices.size(); i++)
+    {
+        if(m_devices[i].wave == m_wave && m_devices[i].stage < ROLLOUT_DONE)
+            return false;
+    }
+    return true;
+}
+
+bool firmware_rollout::tick(uint64_t now_ms, const upload_starter &start_upload, const version_reader &read_version)
+{
+    if(!m_running)
+        return false;
+
+    bool changed = false;
+    for(size_t i = 0; i < m_devices.size(); i++)
+    {
+        rollout_device &device = m_devices[i];
+        switch(device.stage)
+        {
+        case ROLLOUT_UPLOADING:
+            switch(device.upload->get_state())
+            {
+            case firmware_upload::UPLOAD_RUNNING:
+                break;
+
+            case firmware_upload::UPLOAD_DONE:
+                device.upload.reset();
+                device.resume_offset = 0;
+                device.went_offline = false;
+                device.verify_pending = false;
+                set_stage(device, ROLLOUT_REBOOTING, now_ms);
+                break;
+
+            default:
+                device.resume_offset = device.upload->get_resume_offset();
+                if(device.attempts < m_options.max_attempts)
+                {
+                    device.error = device.upload->get_error();
+                    device.upload.reset();
+                    retry_later(device, now_ms);
+                    set_stage(device, ROLLOUT_PENDING, now_ms);
+                }
+                else
+                {
+                    fail(device, "upload failed: " + device.upload->get_error(), now_ms);
+                }
+                break;
+            }
+            changed = true;
+            break;
+
+        case ROLLOUT_REBOOTING:
+            // a device that applies the image without rebooting is verified once the wait is over
+            if(now_ms - device.stage_ms >= m_options.reboot_timeout_ms)
+            {
+                set_stage(device, ROLLOUT_VERIFYING, now_ms);
+                changed = true;
+            }
+            break;
+
+        case ROLLOUT_VERIFYING:
+            if(now_ms - device.stage_ms >= m_options.verify_timeout_ms)
+            {
+                fail(device, "firmware version could not be read back", now_ms);
+                changed = true;
+            }
+            else if(!device.verify_pending || now_ms - device.verify_sent_ms >= m_options.verify_retry_ms)
+            {
+                // an answer to an earlier read is still taken if it arrives first
+                device.verify_pending = true;
+                device.verify_sent_ms = now_ms;
+                read_version(device.entity_id);
+            }
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    if(m_stage_counts[ROLLOUT_FAILED] > m_options.max_failures)
+    {
+        // let devices already mid-update finish, but start nothing new
+        for(size_t i = 0; i < m_devices.size(); i++)
+        {
+            if(m_devices[i].stage == ROLLOUT_PENDING)
+                set_stage(m_devices[i], ROLLOUT_SKIPPED, now_ms);
+        }
+        if(m_stage_counts[ROLLOUT_UPLOADING] + m_stage_counts[ROLLOUT_REBOOTING] + m_stage_counts[ROLLOUT_VERIFYING] == 0)
+            m_running = false;
+        return true;
+    }
+
+    while(m_wave < m_wave_count && wave_finished())
+    {
+        m_wave++;
+        changed = true;
+    }
+    if(m_wave == m_wave_count)
+    {
+        m_running = false;
+        return true;
+    }
+
+    for(size_t i = 0; i < m_devices.size() && m_active_uploads < m_options.parallelism; i++)
+    {
+        rollout_device &device = m_devices[i];
+        if(device.wave != m_wave || device.stage != ROLLOUT_PENDING || now_ms < device.retry_ms)
+            continue;
+
+        device.attempts++;
+        device.upload = start_upload(device.entity_id, device.resume_offset, device.error);
+        if(device.upload)
+        {
+            device.error.clear();
+            set_stage(device, ROLLOUT_UPLOADING, now_ms);
+        }
+        else if(device.attempts >= m_options.max_attempts)
+        {
+            fail(device, device.error, now_ms);
+        }
+        else
+        {
+            retry_later(device, now_ms);
+            m_changed.push_back(i);
+        }
+        changed = true;
+    }
+
+    return changed;
+}
+
+void firmware_rollout::entity_disconnected(uint64_t entity_id)
+{
+    std::unordered_map<uint64_t, size_t>::const_iterator it = m_index.find(entity_id);
+    if(it != m_index.end() && m_devices[it->second].stage == ROLLOUT_REBOOTING)
+        m_devices[it->second].went_offline = true;
+}
+
+void firmware_rollout::entity_connected(uint64_t entity_id, uint64_t now_ms)
+{
+    std::unordered_map<uint64_t, size_t>::const_iterator it = m_index.find(entity_id);
+    if(it == m_index.end())
+        return;
+
+    rollout_device &device = m_devices[it->second];
+    if(device.stage == ROLLOUT_REBOOTING && device.went_offline)
+    {
+        device.verify_pending = false;
+        set_stage(device, ROLLOUT_VERIFYING, now_ms);
+    }
+}
+
+/*
+ * A failed read is tried again on a later tick until the verify timeout;
+ * answers for devices no longer verifying are dropped.
+ */
+void firmware_rollout::version_read(uint64_t entity_id, bool ok, const std::string &version, uint64_t now_ms)
+{
+    std::unordered_map<uint64_t, size_t>::const_iterator it = m_index.find(entity_id);
+    if(it == m_index.end())
+        return;
+
+    rollout_device &device = m_devices[it->second];
+    if(device.stage != ROLLOUT_VERIFYING)
+        return;
+
+    device.verify_pending = false;
+    if(!ok)
+        return;
+
+    device.version = version;
+    if(device.version == m_target_version)
+        set_stage(device, ROLLOUT_DONE, now_ms);
+    else
+        fail(device, "running " + device.version + " after the update", now_ms);
+}
+
+void firmware_rollout::take_changed(std::vector<size_t> &indices)
+{
+    indices.swap(m_changed);
+    m_changed.clear();
+    for(size_t i = 0; i < m_devices.size(); i++)
+    {
+        if(m_devices[i].stage == ROLLOUT_UPLOADING)
+            indices.push_back(i);
+    }
+}
+
+bool firmware_rollout::is_running() const
+{
+    return m_running;
+}
+
+size_t firmware_rollout::get_device_count() const
+{
+    return m_devices.size();
+}
+
+const rollout_device & firmware_rollout::get_device(size_t index) const
+{
+    assert(index < m_devices.size());
+    return m_devices[index];
+}
+
+size_t firmware_rollout::get_stage_count(rollout_stage stage) const
+{
+    return m_stage_counts[stage];
+}
+
+unsigned int firmware_rollout::get_current_wave() const
+{
+    return m_wave;
+}
+
+unsigned int firmware_rollout::get_wave_count() const
+{
+    return m_wave_count;
+}
+
+double firmware_rollout::get_throughput() const
+{
+    double total = 0;
+    for(size_t i = 0; i < m_devices.size(); i++)
+    {
+        if(m_devices[i].upload)
+            total += m_devices[i].upload->get_throughput();
+    }
+    return total;
+}
+
+uint64_t firmware_rollout::get_elapsed_ms(uint64_t now_ms) const
+{
+    return now_ms - m_started_ms;
+}
+
+const char * firmware_rollout::stage_name(rollout_stage stage)
+{
+    switch(stage)
+    {
+    case ROLLOUT_PENDING:
+        return "Pending";
+    case ROLLOUT_UPLOADING:
+        return "Uploading";
+    case ROLLOUT_REBOOTING:
+        return "Rebooting";
+    case ROLLOUT_VERIFYING:
+        return "Verifying";
+    case ROLLOUT_DONE:
+        return "Done";
+    case ROLLOUT_FAILED:
+        return "Failed";
+    case ROLLOUT_SKIPPED:
+        return "Skipped";
+    }
+    return "";
+}
@@ -0,0 +1,385 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * firmware_upload.cpp
+ *
+ */
+
+#include <algorithm>
+#include <vector>
+#include "firmware_upload.h"
+#include "trace_log.h"
+
+firmware_upload::firmware_upload(pending_command_table &pending, const id_allocator &next_id, const writer &write,
+                                 const result_check &succeeded)
+: m_pending(pending), m_next_id(next_id), m_write(write), m_succeeded(succeeded)
+{
+    m_state = UPLOAD_IDLE;
+    m_phase = PHASE_WRITE;
+    m_operation_id = NULL;
+    m_base_address = 0;
+    m_next_offset = 0;
+    m_contiguous = 0;
+    m_acked_bytes = 0;
+    m_started_bytes = 0;
+    m_window = initial_window;
+    m_chunk_bytes = max_chunk_bytes;
+}
+
+firmware_upload::~firmware_upload()
+{
+    cancel();
+}
+
+int firmware_upload::open(const std::string &path)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    if(m_state == UPLOAD_RUNNING)
+        return -1;
+    return m_file.open(path);
+}
+
+void firmware_upload::set_operations(const operation &begin, const operation &finish)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_begin = begin;
+    m_finish = finish;
+}
+
+bool firmware_upload::start(uint64_t base_address, uint64_t resume_offset)
+{
+    upload_phase phase;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if(!m_file.is_open() || m_state == UPLOAD_RUNNING || resume_offset > m_file.size())
+            return false;
+
+        m_state = UPLOAD_RUNNING;
+        m_base_address = base_address;
+        m_next_offset = resume_offset;
+        m_contiguous = resume_offset;
+        m_acked_bytes = resume_offset;
+        m_started_bytes = resume_offset;
+        m_window = initial_window;
+        m_chunk_bytes = max_chunk_bytes;
+        m_acked_ranges.clear();
+        m_retry.clear();
+        m_retries.clear();
+        m_error.clear();
+        m_operation_id = NULL;
+        m_started = std::chrono::steady_clock::now();
+
+        // an upload resumed at the end of the image still needs its finish
+        m_phase = m_begin ? PHASE_BEGIN : m_contiguous < m_file.size() ? PHASE_WRITE : PHASE_FINISH;
+        if(m_phase == PHASE_FINISH && !m_finish)
+        {
+            m_state = UPLOAD_DONE;
+            return true;
+        }
+        phase = m_phase;
+    }
+
+    if(phase == PHASE_WRITE)
+        pump();
+    else
+        send_operation(phase);
+    return true;
+}
+
+void firmware_upload::cancel()
+{
+    std::map<void *, chunk> in_flight;
+    void *operation_id;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if(m_state == UPLOAD_RUNNING)
+            m_state = UPLOAD_CANCELLED;
+        in_flight.swap(m_in_flight);
+        operation_id = m_operation_id;
+        m_operation_id = NULL;
+    }
+    cancel_all(in_flight);
+    if(operation_id)
+        m_pending.cancel(operation_id);
+}
+
+void firmware_upload::fail_locked(const std::string &error)
+{
+    if(m_state == UPLOAD_RUNNING)
+    {
+        m_state = UPLOAD_FAILED;
+        m_error = error;
+    }
+}
+
+void firmware_upload::send_operation(upload_phase phase)
+{
+    void *notification_id;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if(m_state != UPLOAD_RUNNING)
+            return;
+        notification_id = m_next_id();
+        m_operation_id = notification_id;
+    }
+
+    TRACE_SPAN_ARG("command", phase == PHASE_BEGIN ? "firmware_upload.begin" : "firmware_upload.finish",
+                   (uint64_t)(intptr_t)notification_id);
+    std::shared_ptr<firmware_upload> self = shared_from_this();
+    m_pending.add(notification_id, [self, phase](const notification_record &record)
+    {
+        trace_log::record_instant("command", "firmware_upload.operation_complete", (uint64_t)(intptr_t)record.notification_id);
+        self->on_operation(phase, record);
+    });
+
+    const operation &send = phase == PHASE_BEGIN ? m_begin : m_finish;
+    // a completion that already ran owns the entry, so only a cancelled one is failed here
+    if(send(notification_id) != 0 && m_pending.cancel(notification_id))
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if(m_operation_id == notification_id)
+            m_operation_id = NULL;
+        fail_locked(phase == PHASE_BEGIN ? "unable to send the upload start" : "unable to send the upload finish");
+    }
+}
+
+void firmware_upload::on_operation(upload_phase phase, const notification_record &record)
+{
+    upload_phase next;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if(record.notification_id != m_operation_id || m_state != UPLOAD_RUNNING)
+            return;
+        m_operation_id = NULL;
+
+        if(!m_succeeded(record))
+        {
+            fail_locked(phase == PHASE_BEGIN ? "end station refused to start a firmware upload" :
+                                               "end station did not confirm the upload");
+            return;
+        }
+        if(phase == PHASE_FINISH)
+        {
+            m_state = UPLOAD_DONE;
+            return;
+        }
+
+        if(m_contiguous < m_file.size())
+            m_phase = PHASE_WRITE;
+        else if(m_finish)
+            m_phase = PHASE_FINISH;
+        else
+        {
+            m_state = UPLOAD_DONE;
+            return;
+        }
+        next = m_phase;
+    }
+
+    if(next == PHASE_WRITE)
+        pump();
+    else
+        send_operation(next);
+}
+
+void firmware_upload::pump()
+{
+    std::vector<std::pair<void *, chunk> > sends;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        while(m_state == UPLOAD_RUNNING && m_phase == PHASE_WRITE && m_in_flight.size() < (size_t)m_window)
+        {
+            chunk c;
+            if(!m_retry.empty())
+            {
+                c = m_retry.front();
+                m_retry.pop_front();
+                if(c.length > m_chunk_bytes)
+                {
+                    chunk rest;
+                    rest.offset = c.offset + m_chunk_bytes;
+                    rest.length = c.length - m_chunk_bytes;
+                    m_retry.push_front(rest);
+                    c.length = m_chunk_bytes;
+                }
+            }
+            else if(m_next_offset < m_file.size())
+            {
+                c.offset = m_next_offset;
+                c.length = (size_t)std::min<uint64_t>(m_chunk_bytes, m_file.size() - m_next_offset);
+                m_next_offset += c.length;
+            }
+            else
+            {
+                break;
+            }
+
+            void *notification_id = m_next_id();
+            m_in_flight[notification_id] = c;
+            sends.push_back(std::make_pair(notification_id, c));
+        }
+    }
+
+    std::shared_ptr<firmware_upload> self = shared_from_this();
+    for(size_t i = 0; i < sends.size(); i++)
+    {
+        const chunk c = sends[i].second;
+        TRACE_SPAN_ARG("command", "firmware_upload.write", (uint64_t)(intptr_t)sends[i].first);
+        m_pending.add(sends[i].first, [self, c](const notification_record &record)
+        {
+            trace_log::record_instant("command", "firmware_upload.write_complete", (uint64_t)(intptr_t)record.notification_id);
+            self->on_complete(c, record);
+        });
+
+        if(m_write(sends[i].first, m_base_address + c.offset, m_file.data() + c.offset, c.length) != 0)
+        {
+            // the interface refused the frame; stop here and keep the resume point
+            std::map<void *, chunk> in_flight;
+            {
+                std::lock_guard<std::mutex> guard(m_lock);
+                fail_locked("unable to send a write");
+                in_flight.swap(m_in_flight);
+            }
+            cancel_all(in_flight);
+            return;
+        }
+    }
+}
+
+void firmware_upload::cancel_all(const std::map<void *, chunk> &in_flight)
+{
+    for(std::map<void *, chunk>::const_iterator it = in_flight.begin(); it != in_flight.end(); ++it)
+    {
+        m_pending.cancel(it->first);
+    }
+}
+
+void firmware_upload::ack_locked(const chunk &c)
+{
+    m_acked_bytes += c.length;
+    m_retries.erase(c.offset);
+    m_acked_ranges[c.offset] = c.offset + c.length;
+
+    std::map<uint64_t, uint64_t>::iterator it = m_acked_ranges.begin();
+    while(it != m_acked_ranges.end() && it->first == m_contiguous)
+    {
+        m_contiguous = it->second;
+        m_acked_ranges.erase(it++);
+    }
+}
+
+void firmware_upload::on_complete(const chunk &c, const notification_record &record)
+{
+    std::map<void *, chunk> abandoned;
+    bool finish = false;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        if(m_in_flight.erase(record.notification_id) == 0 || m_state != UPLOAD_RUNNING)
+            return;
+
+        if(m_succeeded(record))
+        {
+            ack_locked(c);
+
+            // additive increase: one more write per window of successes
+            m_window += 1.0 / m_window;
+            if(m_window > max_window)
+                m_window = max_window;
+            if(m_chunk_bytes < max_chunk_bytes)
+                m_chunk_bytes = std::min(max_chunk_bytes, m_chunk_bytes + min_chunk_bytes);
+
+            if(m_contiguous == m_file.size())
+            {
+                if(!m_finish)
+                {
+                    m_state = UPLOAD_DONE;
+                    return;
+                }
+                m_phase = PHASE_FINISH;
+                finish = true;
+            }
+        }
+        else if(++m_retries[c.offset] > max_retries)
+        {
+            fail_locked("write failed after retries");
+            abandoned.swap(m_in_flight);
+        }
+        else
+        {
+            // multiplicative decrease, and retry with smaller writes
+            m_window = std::max(1.0, m_window / 2);
+            m_chunk_bytes = std::max(min_chunk_bytes, m_chunk_bytes / 2);
+            m_retry.push_back(c);
+        }
+    }
+
+    if(!abandoned.empty())
+        cancel_all(abandoned);
+    else if(finish)
+        send_operation(PHASE_FINISH);
+    else
+        pump();
+}
+
+firmware_upload::upload_state firmware_upload::get_state() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_state;
+}
+
+std::string firmware_upload::get_error() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_error;
+}
+
+uint64_t firmware_upload::get_size() const
+{
+    return m_file.size();
+}
+
+uint64_t firmware_upload::get_acked_bytes() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_acked_bytes;
+}
+
+uint64_t firmware_upload::get_resume_offset() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_contiguous;
+}
+
+unsigned int firmware_upload::get_window() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return (unsigned int)m_window;
+}
+
+double firmware_upload::get_throughput() const
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_started).count();
+    return seconds > 0 ? (m_acked_bytes - m_started_bytes) / seconds : 0;
+}
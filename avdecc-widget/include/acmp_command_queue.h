@@ -0,0 +1,119 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * acmp_command_queue.h
+ *
+ * Pipelined queue of ACMP connect, disconnect and GET_RX_STATE commands,
+ * plus the AEM GET_STREAM_INFO read used to poll listeners. Up to
+ * max_in_flight commands are outstanding at once; responses are collected
+ * on the callback thread and handed to the GUI thread in batches.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+#include "connection_index.h"
+#include "pending_command_table.h"
+
+enum acmp_command_type
+{
+    ACMP_CONNECT_RX,
+    ACMP_DISCONNECT_RX,
+    ACMP_GET_RX_STATE,
+    AEM_GET_STREAM_INFO
+};
+
+const char * acmp_command_name(acmp_command_type type);
+
+struct acmp_command
+{
+    acmp_command_type type;
+    stream_endpoint talker;
+    stream_endpoint listener;
+};
+
+struct listener_state
+{
+    bool connected;
+    stream_endpoint talker;
+    uint16_t connection_count;
+    uint32_t stream_info_flags;
+    uint64_t stream_format;
+    uint64_t stream_id;
+};
+
+struct acmp_result
+{
+    acmp_command command;
+    int32_t notification_type;
+    uint32_t status;
+    listener_state state;
+};
+
+class acmp_command_queue
+{
+public:
+    typedef std::function<void *()> id_allocator;
+    typedef std::function<int(const acmp_command &command, void *notification_id)> sender;
+    /*
+     * Runs on the callback thread when a command completes. Fills in the
+     * result and returns false if it need not be passed to the GUI.
+     */
+    typedef std::function<bool(acmp_result &result)> reader;
+
+    acmp_command_queue(pending_command_table &pending, size_t max_in_flight);
+    virtual ~acmp_command_queue();
+
+    void set_sender(const id_allocator &next_id, const sender &send);
+    void set_reader(const reader &read);
+
+    void enqueue(const acmp_command &command);
+    void pump();
+    size_t take_results(std::vector<acmp_result> &results);
+
+    size_t get_queued_count() const;
+    size_t get_in_flight_count() const;
+
+private:
+    void on_complete(const acmp_command &command, const notification_record &record);
+
+    pending_command_table &m_pending;
+    size_t m_max_in_flight;
+    id_allocator m_next_id;
+    sender m_send;
+    reader m_read;
+
+    std::deque<acmp_command> m_queue;
+    std::unordered_set<stream_endpoint, stream_endpoint_hash> m_queued_rx_state;
+    std::unordered_set<stream_endpoint, stream_endpoint_hash> m_queued_stream_info;
+    std::atomic<size_t> m_in_flight;
+
+    std::mutex m_result_lock;
+    std::vector<acmp_result> m_results;
+};
@@ -0,0 +1,79 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * audio_mapping_set.h
+ *
+ * Sparse set of stream port audio mappings, packed into one sorted 64-bit
+ * key per mapping so a stream channel's mappings are adjacent and two sets
+ * can be diffed in a single pass.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct audio_mapping
+{
+    uint16_t stream_index;
+    uint16_t stream_channel;
+    uint16_t cluster_offset;
+    uint16_t cluster_channel;
+};
+
+class audio_mapping_set
+{
+public:
+    // 8 bytes each after the AEM and ADD/REMOVE_AUDIO_MAPPINGS headers in a 524 byte AECPDU
+    static const size_t max_mappings_per_pdu = 63;
+
+    audio_mapping_set();
+    virtual ~audio_mapping_set();
+
+    static uint64_t pack(const audio_mapping &map);
+    static audio_mapping unpack(uint64_t key);
+
+    bool add(const audio_mapping &map);
+    bool remove(const audio_mapping &map);
+    size_t remove_stream_channel(uint16_t stream_index, uint16_t stream_channel);
+    size_t get_stream_channel(uint16_t stream_index, uint16_t stream_channel, std::vector<audio_mapping> &maps) const;
+    void clear();
+
+    size_t size() const;
+    audio_mapping at(size_t index) const;
+
+    /*
+     * Mappings to remove from and add to 'from' so that it equals 'to'.
+     * Mappings present in both are left alone.
+     */
+    static void diff(const audio_mapping_set &from, const audio_mapping_set &to,
+                     std::vector<audio_mapping> &removed, std::vector<audio_mapping> &added);
+
+    bool operator==(const audio_mapping_set &other) const { return m_maps == other.m_maps; }
+    bool operator!=(const audio_mapping_set &other) const { return m_maps != other.m_maps; }
+
+private:
+    std::vector<uint64_t> m_maps;
+};
@@ -28,10 +28,34 @@
  */
 
 #include "end_station_details.h"
+#include "end_station_list.h"
+#include "avdecc_interface.h"
+#include "connection_matrix.h"
+#include "acmp_command_queue.h"
+#include "listener_state_poller.h"
+#include "entity_config_cache.h"
+#include "config_transaction.h"
+#include "command_future.h"
+#include "counter_monitor_panel.h"
+#include "counter_history.h"
+#include "inventory_export.h"
+#include "stream_format.h"
+#include "firmware_upload.h"
+#include "rollout_panel.h"
+#include "log_panel.h"
+#include "trace_log.h"
+#include "console_log.h"
+#include "notification_coalescer.h"
 
 //avdecc-lib necessary headers
 #include <assert.h>
+#include <atomic>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <iomanip>
 #include <string>
@@ -72,26 +96,6 @@
 #include "util.h"
 
 
-class AtomicOut : public std::ostream
-{
-public:
-	AtomicOut() : std::ostream(0), buffer()
-	{
-		this->init(buffer.rdbuf());
-	}
-
-	~AtomicOut()
-	{
-		// Use printf as cout seems to still be interleaved
-		printf("%s", buffer.str().c_str());
-	}
-
-private:
-	std::ostringstream buffer;
-};
-
-#define atomic_cout AtomicOut()
-
 class AVDECC_Controller : public wxFrame
 {
 public:
@@ -100,9 +104,30 @@ public:
     
     // event handlers
     void OnQuit(wxCommandEvent& event);
+    void OnTraceToggle(wxCommandEvent& event);
+    void OnTraceWrite(wxCommandEvent& event);
+    void OnInventoryExport(wxCommandEvent& event);
+    void OnFirmwareUpload(wxCommandEvent& event);
     
     void OnEndStationDClick(wxListEvent& event);
-    void OnIncrementTimer(wxTimerEvent& event);
+    void ShowEndStationDetails(uint64_t entity_id);
+    void OnFilterText(wxCommandEvent& event);
+    void OnRegistrationTimer(wxTimerEvent& event);
+    void OnNotificationTimer(wxTimerEvent& event);
+    void OnStackReady(wxThreadEvent& event);
+    void OnFirstIdle(wxIdleEvent& event);
+    void ProcessNotifications(const std::vector<notification_record> &records);
+    void ApplyConfigurationChange(const notification_record &record);
+    void ReportApply(uint64_t entity_id, const config_snapshot &applied, const transaction_report &report);
+    void RefreshCounterTargets();
+    void ProcessCounterResults();
+    void RefreshConnectionMatrix();
+    void UpdateConnectionStreams();
+    void ToggleConnection(const stream_endpoint &talker, const stream_endpoint &listener, bool connected);
+    void ProcessAcmpResults();
+    void ProcessFirmwareUpload();
+    void StartRollout();
+    void ProcessRollout();
     
     void CreateEndStationListFormat();
     void CreateEndStationList();
@@ -113,31 +138,92 @@ public:
                                                       avdecc_lib::entity_descriptor **entity, avdecc_lib::configuration_descriptor **configuration);
     
     int get_current_end_station(avdecc_lib::end_station **end_station) const;
+
+    int get_entity_configuration(uint64_t entity_id, avdecc_lib::end_station **end_station,
+                                 avdecc_lib::configuration_descriptor **configuration);
+    wxString get_stream_name(avdecc_lib::configuration_descriptor *configuration,
+                             const uint8_t *object_name, uint16_t localized_description);
 private:
     //main window objects
-    wxTextCtrl *notif_text;
-    wxTextCtrl *log_text;
-    wxListCtrl * details_list;
+    wxTextCtrl * filter_text;
+    end_station_list * details_list;
     wxTimer * m_timer;
+    wxTimer * m_notification_timer;
+    std::vector<notification_record> m_notification_batch;
+    connection_matrix_panel * connection_page;
+    connection_index m_connections;
+    acmp_command_queue * m_acmp_queue;
+    std::vector<acmp_result> m_acmp_results;
+    listener_state_poller m_listener_poller;
+    std::unordered_map<stream_endpoint, listener_state, stream_endpoint_hash> m_listener_info;
+    entity_config_cache m_config_cache;
+    entity_model_registry m_models;
+    counter_monitor_panel * monitor_page;
+    counter_monitor m_counter_monitor;
+    command_executor m_commands;
+    std::shared_ptr<std::atomic<bool>> m_alive; // completions arriving after the frame is gone are dropped
+    counter_history m_counter_history;
+    inventory_writer m_inventory_writer;
+    std::shared_ptr<firmware_upload> m_firmware_upload;
+    uint64_t m_firmware_entity_id;
+    std::string m_firmware_path;
+    rollout_panel * rollout_page;
+    firmware_rollout m_firmware_rollout;
+    std::string m_rollout_image;
+    log_panel * log_page;
+    std::mutex m_counter_lock;
+    std::vector<counter_sample> m_counter_samples;
+    std::vector<counter_target> m_counter_failures;
 
     end_station_details * details;
-    end_station_configuration * config;
-    stream_configuration * stream_config;
     
     //avdecc-lib objects, variables
-    avdecc_lib::controller *controller_obj;
-    avdecc_lib::system *sys;
-    avdecc_lib::net_interface *netif;
+    std::vector<avdecc_interface *> m_interfaces;
+    std::thread m_stack_thread;
+    std::mutex m_stack_lock;
+    std::vector<avdecc_interface *> m_opened_interfaces; // opened by m_stack_thread, not yet adopted
     int32_t log_level = avdecc_lib::LOGGING_LEVEL_ERROR;
-    intptr_t notification_id;
+    std::atomic<intptr_t> notification_id;
     unsigned int m_end_station_count;
+    size_t m_discovered_count; // end stations avdecc-lib holds over all interfaces, as of the last check
+    uint64_t m_entity_generation;
+    uint32_t current_interface_index;
     long current_end_station_index;
-    uint32_t init_sample_rate;
+
+    void open_interfaces(const std::vector<uint32_t> &interface_nums);
+    bool read_entity_record(uint32_t interface_index, uint64_t entity_id, entity_record &record);
+    void read_entity_configuration(avdecc_lib::configuration_descriptor *configuration, entity_record &record);
+    void publish_known_entities();
+    void refresh_notified_entities();
+    avdecc_lib::controller * current_controller() const;
+    avdecc_lib::system * current_system() const;
     uint32_t get_next_notification_id();
+    static void call_while_alive(const std::shared_ptr<std::atomic<bool>> &alive, const std::function<void()> &call);
     
-    int cmd_set_sampling_rate(uint32_t new_sampling_rate);
-    int cmd_set_stream_format(wxString desc_name, uint16_t desc_index, unsigned int stream_format_index);
-    unsigned int channel_count_and_sample_rate_to_stream_index(unsigned int channel_count, uint32_t sampling_rate);
+    std::shared_ptr<const entity_model> read_entity_model(uint64_t entity_model_id, avdecc_lib::configuration_descriptor *configuration);
+    std::shared_ptr<config_transaction> build_apply_transaction(uint64_t entity_id, const config_snapshot &initial,
+                                                                const config_snapshot &applied);
+    static int send_audio_mappings(avdecc_lib::stream_port_input_descriptor *stream_port_input_desc_ref,
+                                   avdecc_lib::stream_port_output_descriptor *stream_port_output_desc_ref,
+                                   const std::vector<audio_mapping> &maps, bool add, void *cmd_notification_id);
+    int send_acmp_command(const acmp_command &command, void *cmd_notification_id);
+    int register_unsolicited(uint64_t entity_id);
+    std::shared_ptr<firmware_upload> start_firmware_upload(uint64_t entity_id, const std::string &path,
+                                                           uint64_t resume_offset, std::string &error);
+    void read_firmware_version(uint64_t entity_id);
+    uint64_t load_firmware_resume(uint64_t entity_id, const std::string &path);
+    void save_firmware_resume(uint64_t entity_id, const std::string &path, uint64_t size, uint64_t offset);
+    int send_counter_read(const counter_target &target);
+    void read_counters(const counter_target &target, const notification_record &record);
+    wxString format_counter_target(const counter_target &target) const;
+    wxString format_counter_sample(const counter_target &target, const counter_sample &sample) const;
+    wxString format_counter_trend(const counter_target &target) const;
+    wxString format_listener_info(const stream_endpoint &listener) const;
+    wxString format_log_cell(const log_record &record, long column) const;
+    command_future read_entity_config(const entity_record &record, std::shared_ptr<config_builder> &builder);
+    command_future read_audio_mappings(avdecc_lib::configuration_descriptor *configuration, bool input,
+                                       uint16_t map_index, audio_mapping_set *mappings);
+    bool read_listener_state(acmp_result &result);
     
     // any class wishing to process wxWidgets events must use this macro
     wxDECLARE_EVENT_TABLE();
@@ -167,7 +253,14 @@ enum
     HtmlLbox_SetSelFgCol,
     
     HtmlLbox_Clear,
-    EndStationTimer,
+    RegistrationTimer,
+    NotificationTimer,
+    EndStationFilter,
+    TraceToggle,
+    TraceWrite,
+    InventoryExport,
+    FirmwareUpload,
+    StackReady,
     
     
     // it is important for the id corresponding to the "About" command to have
@@ -0,0 +1,81 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * avdecc_interface.h
+ *
+ * One avdecc-lib stack (net_interface, controller and system) bound to a
+ * single network interface. The widget opens one per selected NIC; each
+ * system runs its own avdecc-lib worker thread.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <wx/string.h>
+
+namespace avdecc_lib
+{
+    class net_interface;
+    class controller;
+    class system;
+    class end_station;
+}
+
+typedef void (*avdecc_notification_callback)(void *, int32_t, uint64_t, uint16_t, uint16_t, uint16_t, uint32_t, void *);
+typedef void (*avdecc_log_callback)(void *, int32_t, const char *, int32_t);
+
+class avdecc_interface
+{
+public:
+    avdecc_interface(uint32_t interface_num);
+    virtual ~avdecc_interface();
+
+    int open(avdecc_notification_callback notification_cb, avdecc_log_callback log_cb, int32_t log_level);
+    void close();
+
+    bool is_open() const;
+    uint32_t get_interface_num() const;
+    const wxString & get_name() const;
+
+    avdecc_lib::controller * get_controller() const;
+    avdecc_lib::system * get_system() const;
+    bool find_end_station(uint64_t entity_id, avdecc_lib::end_station **end_station, uint32_t *end_station_index) const;
+
+    /*
+     * Parses a comma separated list of 1-based interface numbers as accepted
+     * by net_interface::select_interface_by_num(), or "all".
+     */
+    static std::vector<uint32_t> parse_interface_list(const char *list);
+
+private:
+    avdecc_interface(const avdecc_interface &);
+    avdecc_interface & operator=(const avdecc_interface &);
+
+    uint32_t m_interface_num;
+    wxString m_name;
+    avdecc_lib::net_interface *m_netif;
+    avdecc_lib::controller *m_controller;
+    avdecc_lib::system *m_sys;
+};
@@ -0,0 +1,105 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * command_future.h
+ *
+ * Asynchronous AEM commands. command_executor sends a command under a fresh
+ * notification ID and returns a command_future that handle_notification
+ * completes through the pending command table. Futures chain with then(),
+ * so a multi-step workflow reads top to bottom and no thread is held while
+ * a response is outstanding; a failed step skips the rest of the chain and
+ * its record is passed to the end.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "pending_command_table.h"
+
+class command_future
+{
+public:
+    typedef std::function<void(bool succeeded, const notification_record &record)> callback;
+    typedef std::function<command_future(const notification_record &record)> continuation;
+
+    command_future();
+
+    static command_future ready(bool succeeded, const notification_record &record);
+
+    /**
+     * Completes when every future has; fails with the first failed record.
+     */
+    static command_future when_all(const std::vector<command_future> &futures);
+
+    bool is_ready() const;
+
+    /**
+     * Runs next with the response once this command has succeeded and
+     * completes with whatever next returns.
+     */
+    command_future then(const continuation &next) const;
+
+    /**
+     * Runs done once the result is known, from whichever thread completes
+     * the future, or straight away if it already has.
+     */
+    void on_complete(const callback &done) const;
+
+private:
+    friend class command_executor;
+
+    struct state
+    {
+        std::mutex lock;
+        bool done;
+        bool succeeded;
+        notification_record record;
+        std::vector<callback> callbacks;
+    };
+
+    void resolve(bool succeeded, const notification_record &record) const;
+
+    std::shared_ptr<state> m_state;
+};
+
+class command_executor
+{
+public:
+    typedef std::function<void *()> id_allocator;
+    typedef std::function<int(void *notification_id)> sender;
+    typedef std::function<bool(const notification_record &record)> result_check;
+
+    command_executor(pending_command_table &pending, const id_allocator &next_id, const result_check &succeeded);
+    virtual ~command_executor();
+
+    command_future send(const sender &send);
+
+private:
+    pending_command_table &m_pending;
+    id_allocator m_next_id;
+    result_check m_succeeded;
+};
@@ -0,0 +1,112 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * config_snapshot.h
+ *
+ * Immutable, reference-counted view of one end station's configuration.
+ * The entity fields, each stream list and each mapping set are held
+ * separately, so the cache, the controller and the configuration dialog
+ * can all hold the same snapshot without copying it. A config_builder
+ * makes the next version: it clones only the parts that are edited and
+ * shares the rest with the snapshot it started from. Static descriptor data
+ * is not copied into the snapshot at all; it points at the entity_model
+ * shared by every entity of the same model.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include "end_station_configuration.h"
+#include "stream_configuration.h"
+#include "audio_mapping_set.h"
+#include "entity_model.h"
+
+class config_snapshot
+{
+public:
+    typedef std::vector<stream_configuration_details> stream_list;
+
+    config_snapshot();
+
+    bool is_valid() const { return m_entity != NULL; }
+
+    const end_station_configuration & entity() const { return *m_entity; }
+    const stream_list & streams(bool input) const { return input ? *m_inputs : *m_outputs; }
+    const audio_mapping_set & mappings(bool input) const { return input ? *m_input_mappings : *m_output_mappings; }
+    const entity_model * model() const { return m_model.get(); }
+
+    unsigned int get_stream_input_count() const { return (unsigned int)m_inputs->size(); }
+    unsigned int get_stream_output_count() const { return (unsigned int)m_outputs->size(); }
+
+    bool shares_entity(const config_snapshot &other) const { return m_entity == other.m_entity; }
+    bool shares_streams(bool input, const config_snapshot &other) const;
+    bool shares_mappings(bool input, const config_snapshot &other) const;
+
+private:
+    friend class config_builder;
+
+    std::shared_ptr<const end_station_configuration> m_entity;
+    std::shared_ptr<const stream_list> m_inputs;
+    std::shared_ptr<const stream_list> m_outputs;
+    std::shared_ptr<const audio_mapping_set> m_input_mappings;
+    std::shared_ptr<const audio_mapping_set> m_output_mappings;
+    std::shared_ptr<const entity_model> m_model;
+};
+
+class config_builder
+{
+public:
+    explicit config_builder(const end_station_configuration &entity);
+    explicit config_builder(const config_snapshot &base);
+    config_builder(config_builder &&other);
+    config_builder & operator=(config_builder &&other);
+    virtual ~config_builder();
+
+    void set_model(const std::shared_ptr<const entity_model> &model);
+    void set_sample_rate(uint32_t sample_rate);
+    void set_entity_name(const wxString &name);
+    void add_stream(bool input, const stream_configuration_details &details);
+    bool set_stream_name(bool input, size_t stream_index, const wxString &name);
+    bool set_stream_channel_count(bool input, size_t stream_index, unsigned int channel_count);
+    void set_mappings(bool input, const audio_mapping_set &mappings);
+    audio_mapping_set & edit_mappings(bool input);
+
+    config_snapshot build();
+
+private:
+    config_builder(const config_builder &);
+    config_builder & operator=(const config_builder &);
+
+    end_station_configuration & edit_entity();
+    config_snapshot::stream_list & edit_streams(bool input);
+    const config_snapshot::stream_list & current_streams(bool input) const;
+
+    config_snapshot m_base;
+    std::unique_ptr<end_station_configuration> m_entity;
+    std::unique_ptr<config_snapshot::stream_list> m_inputs;
+    std::unique_ptr<config_snapshot::stream_list> m_outputs;
+    std::unique_ptr<audio_mapping_set> m_input_mappings;
+    std::unique_ptr<audio_mapping_set> m_output_mappings;
+};
@@ -0,0 +1,137 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * config_transaction.h
+ *
+ * Applies a set of configuration changes to one end station as a unit.
+ * Each step knows how to send its change and how to send it back. Steps
+ * run in phases: all steps of a phase are in flight together, and the
+ * next phase starts when the last response of the previous one arrives.
+ * If any step fails, every step that succeeded is reverted, again in
+ * parallel within a phase and in the reverse phase order, and the caller
+ * gets a single report. Reads that a rollback depends on run before the
+ * first phase; if one fails nothing is sent and the report says so. Steps are sent through a command_executor, so a
+ * transaction shares the notification IDs, send-failure handling and
+ * success rule of every other asynchronous command.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "command_future.h"
+
+enum transaction_outcome
+{
+    TRANSACTION_COMMITTED,
+    TRANSACTION_ROLLED_BACK,
+    TRANSACTION_ROLLBACK_FAILED,
+    TRANSACTION_READ_FAILED // a read the rollback needs failed; no step was sent
+};
+
+struct transaction_report
+{
+    transaction_outcome outcome;
+    size_t step_count;
+    size_t reverted_count;
+    std::string failed_step;
+    uint32_t failed_status;
+    std::vector<std::string> rollback_failures;
+    uint64_t elapsed_ms;
+};
+
+class config_transaction : public std::enable_shared_from_this<config_transaction>
+{
+public:
+    typedef command_executor::sender sender;
+    typedef std::function<void(const notification_record &record)> reader;
+    typedef std::function<void(const transaction_report &report)> completion;
+
+    config_transaction(command_executor &commands);
+    virtual ~config_transaction();
+
+    void add_step(unsigned int phase, const std::string &name, const sender &apply, const sender &revert);
+
+    /**
+     * Sends a read before any step, and passes its response to read so a
+     * rollback can use the value the device holds right before the change.
+     */
+    void add_read(const std::string &name, const sender &send, const reader &read);
+    size_t get_step_count() const;
+
+    void run(const completion &on_done);
+
+private:
+    enum step_state
+    {
+        STEP_PENDING,
+        STEP_SENT,
+        STEP_APPLIED,
+        STEP_FAILED,
+        STEP_REVERTING,
+        STEP_REVERTED,
+        STEP_REVERT_FAILED
+    };
+
+    struct step
+    {
+        unsigned int phase;
+        std::string name;
+        sender apply;
+        sender revert;
+        step_state state;
+    };
+
+    struct read_step
+    {
+        std::string name;
+        sender send;
+        reader read;
+    };
+
+    void on_read(size_t index, bool ok, const notification_record &record);
+    void start_phase();
+    void send_steps(const std::vector<size_t> &indices, bool reverting);
+    void on_complete(size_t index, bool reverting, bool ok, const notification_record &record);
+    void finish();
+
+    command_executor &m_commands;
+    completion m_on_done;
+
+    std::mutex m_lock;
+    std::vector<read_step> m_reads;
+    std::vector<step> m_steps;
+    std::vector<unsigned int> m_phases;
+    size_t m_phase;
+    size_t m_outstanding;
+    bool m_rolling_back;
+    bool m_read_failed;
+    std::string m_failed_step;
+    uint32_t m_failed_status;
+    uint64_t m_started_ms;
+};
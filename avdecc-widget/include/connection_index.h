@@ -0,0 +1,86 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * connection_index.h
+ *
+ * Sparse bidirectional index of ACMP stream connections. A listener stream
+ * has at most one talker; a talker stream may feed any number of listeners.
+ * Lookups in either direction are O(1) and only existing connections take
+ * memory.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+struct stream_endpoint
+{
+    uint64_t entity_id;
+    uint16_t stream_index;
+
+    bool operator==(const stream_endpoint &other) const
+    {
+        return entity_id == other.entity_id && stream_index == other.stream_index;
+    }
+    bool operator!=(const stream_endpoint &other) const
+    {
+        return !(*this == other);
+    }
+};
+
+struct stream_endpoint_hash
+{
+    size_t operator()(const stream_endpoint &endpoint) const
+    {
+        uint64_t h = (endpoint.entity_id ^ ((uint64_t)endpoint.stream_index << 48)) * 0x9e3779b97f4a7c15ULL;
+        return (size_t)(h ^ (h >> 32));
+    }
+};
+
+class connection_index
+{
+public:
+    connection_index();
+    virtual ~connection_index();
+
+    /*
+     * Records that listener is connected to talker, replacing any previous
+     * talker. Returns true if the index changed.
+     */
+    bool connect(const stream_endpoint &talker, const stream_endpoint &listener);
+    bool disconnect(const stream_endpoint &listener);
+    void remove_entity(uint64_t entity_id);
+    void clear();
+
+    bool get_talker(const stream_endpoint &listener, stream_endpoint &talker) const;
+    bool is_connected(const stream_endpoint &talker, const stream_endpoint &listener) const;
+    const std::vector<stream_endpoint> * get_listeners(const stream_endpoint &talker) const;
+    size_t size() const;
+
+private:
+    std::unordered_map<stream_endpoint, stream_endpoint, stream_endpoint_hash> m_talker_of;
+    std::unordered_map<stream_endpoint, std::vector<stream_endpoint>, stream_endpoint_hash> m_listeners_of;
+};
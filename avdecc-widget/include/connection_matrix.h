@@ -0,0 +1,116 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * connection_matrix.h
+ *
+ * Talker/listener connection matrix page. Rows are listener (stream input)
+ * streams and columns are talker (stream output) streams; the grid is backed
+ * by a virtual table that answers only the cells wx draws, straight from the
+ * connection_index. Listener row labels carry the latest polled stream info.
+ */
+
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "wx/panel.h"
+#include "wx/grid.h"
+#include "wx/button.h"
+#include "wx/stattext.h"
+#include "string_pool.h"
+#include "connection_index.h"
+
+// labelled "entity: stream" when drawn; the pool holds only the two names, which the entity table interns anyway
+struct matrix_stream
+{
+    stream_endpoint endpoint;
+    string_pool::handle entity_name;
+    string_pool::handle stream_name;
+};
+
+class connection_matrix_table : public wxGridTableBase
+{
+public:
+    typedef std::function<wxString(const stream_endpoint &listener)> listener_formatter;
+
+    connection_matrix_table(const connection_index *index);
+    virtual ~connection_matrix_table();
+
+    void set_listener_formatter(const listener_formatter &format_listener);
+    void set_streams(const std::vector<matrix_stream> &talkers, const std::vector<matrix_stream> &listeners);
+    const matrix_stream * get_talker(int col) const;
+    const matrix_stream * get_listener(int row) const;
+    int find_listener_row(const stream_endpoint &listener) const;
+    int find_talker_col(const stream_endpoint &talker) const;
+    const std::vector<matrix_stream> & get_listeners() const;
+
+    virtual int GetNumberRows();
+    virtual int GetNumberCols();
+    virtual bool IsEmptyCell(int row, int col);
+    virtual wxString GetValue(int row, int col);
+    virtual void SetValue(int row, int col, const wxString &value);
+    virtual wxString GetRowLabelValue(int row);
+    virtual wxString GetColLabelValue(int col);
+
+private:
+    static wxString get_label(const matrix_stream &stream);
+    void notify_resize(int old_rows, int old_cols);
+
+    const connection_index *m_index;
+    listener_formatter m_format_listener;
+    std::vector<matrix_stream> m_talkers;
+    std::vector<matrix_stream> m_listeners;
+    std::unordered_map<stream_endpoint, int, stream_endpoint_hash> m_talker_cols;
+    std::unordered_map<stream_endpoint, int, stream_endpoint_hash> m_listener_rows;
+};
+
+class connection_matrix_panel : public wxPanel
+{
+public:
+    typedef std::function<void()> refresh_handler;
+    typedef std::function<void(const stream_endpoint &talker, const stream_endpoint &listener, bool connected)> toggle_handler;
+
+    connection_matrix_panel(wxWindow *parent, const connection_index *index);
+    virtual ~connection_matrix_panel();
+
+    void set_handlers(const refresh_handler &on_refresh, const toggle_handler &on_toggle);
+    void set_listener_formatter(const connection_matrix_table::listener_formatter &format_listener);
+    void set_streams(const std::vector<matrix_stream> &talkers, const std::vector<matrix_stream> &listeners);
+    void refresh_listener(const stream_endpoint &listener);
+    void refresh_all();
+    void set_status(const wxString &status);
+
+    connection_matrix_table * get_table() const;
+
+    void OnRefreshButton(wxCommandEvent& event);
+    void OnCellDClick(wxGridEvent& event);
+
+private:
+    wxGrid *m_grid;
+    wxStaticText *m_status;
+    connection_matrix_table *m_table;
+    refresh_handler m_on_refresh;
+    toggle_handler m_on_toggle;
+};
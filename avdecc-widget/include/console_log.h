@@ -0,0 +1,56 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * console_log.h
+ *
+ * Console logger used on the command and callback paths. Each line is
+ * formatted into a thread-local buffer and handed to a single writer thread
+ * through a bounded lock-free ring, so logging never touches the heap.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __GNUC__
+#define CONSOLE_LOG_PRINTF_FORMAT(fmt_index, args_index) __attribute__((format(printf, fmt_index, args_index)))
+#else
+#define CONSOLE_LOG_PRINTF_FORMAT(fmt_index, args_index)
+#endif
+
+class console_log
+{
+public:
+    enum
+    {
+        max_line_length = 512,
+        ring_slots = 1024
+    };
+
+    static void start();
+    static void stop();
+
+    static void line(const char *fmt, ...) CONSOLE_LOG_PRINTF_FORMAT(1, 2);
+    static void write_line(const char *text, size_t length);
+};
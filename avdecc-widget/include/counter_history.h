@@ -0,0 +1,126 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * counter_history.h
+ *
+ * Bounded history of counter values. Each series keeps three tiers
+ * (1 s for 5 minutes, 10 s for an hour, 1 min for a day); a tier stores
+ * the last value seen in each of its buckets, and only when the value
+ * changed, so idle counters cost nothing. Points are packed into small
+ * blocks as zigzag varint delta-of-deltas of the value, with the bucket
+ * gap only stored when it changes, so a steadily increasing counter polled
+ * at a steady interval costs one or two bytes per point. Points that age out of a tier are cut
+ * from its oldest block as they go, keeping the one still in effect at
+ * the start of the window.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+#include "counter_monitor.h"
+
+class counter_history
+{
+public:
+    typedef uint32_t series_id;
+
+    struct point
+    {
+        uint64_t time_ms;
+        uint64_t value;
+    };
+
+    static const size_t tier_count = 3;
+
+    counter_history();
+    virtual ~counter_history();
+
+    series_id get_series(const counter_target &target, uint8_t counter);
+    bool find_series(const counter_target &target, uint8_t counter, series_id &id) const;
+
+    void append(series_id id, uint64_t time_ms, uint64_t value);
+    void append(const counter_sample &sample, uint64_t time_ms);
+
+    /*
+     * Points of the finest tier still covering from_ms, including the value
+     * in effect at from_ms. At most max_points are returned.
+     */
+    size_t query(series_id id, uint64_t from_ms, uint64_t to_ms, size_t max_points, std::vector<point> &points) const;
+
+    void remove_entity(uint64_t entity_id);
+    size_t get_series_count() const;
+    size_t get_memory_bytes() const;
+
+private:
+    // bytes start with the first value as a varint, followed by one token per later point
+    struct block
+    {
+        uint64_t first_bucket;
+        std::vector<uint8_t> bytes;
+    };
+
+    struct tier
+    {
+        std::vector<block> blocks;
+        uint64_t last_bucket;
+        uint64_t last_value;
+        int64_t last_delta;
+        uint64_t last_gap;
+
+        // last value of the current bucket, committed when the bucket ends
+        uint64_t pending_bucket;
+        uint64_t pending_value;
+        bool has_pending;
+        bool has_point;
+    };
+
+    struct series
+    {
+        counter_target target;
+        uint8_t counter;
+        bool active;
+        tier tiers[tier_count];
+    };
+
+    struct series_key_hash
+    {
+        size_t operator()(const std::pair<counter_target, uint8_t> &key) const
+        {
+            return counter_target_hash()(key.first) * 31 + key.second;
+        }
+    };
+
+    static void commit(tier &t, size_t tier_index, uint64_t bucket, uint64_t value);
+    static void trim(tier &t, uint64_t cutoff_bucket);
+    static void decode(const block &b, std::vector<point> &points, uint64_t resolution_ms,
+                       uint64_t from_bucket, uint64_t to_bucket, point &before, bool &has_before);
+
+    std::deque<series> m_series; // grows without doubling its footprint
+    std::vector<series_id> m_free;
+    std::unordered_map<std::pair<counter_target, uint8_t>, series_id, series_key_hash> m_index;
+};
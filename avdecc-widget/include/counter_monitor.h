@@ -0,0 +1,128 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * counter_monitor.h
+ *
+ * Schedules GET_COUNTERS reads for AVB interface, stream input and clock
+ * domain descriptors. Each target has its own poll interval, halved when
+ * its counters change and doubled while they stay idle; a token bucket
+ * caps the total command rate across all targets.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+struct counter_target
+{
+    uint64_t entity_id;
+    uint16_t desc_type;
+    uint16_t desc_index;
+
+    bool operator==(const counter_target &other) const
+    {
+        return entity_id == other.entity_id && desc_type == other.desc_type && desc_index == other.desc_index;
+    }
+};
+
+struct counter_target_hash
+{
+    size_t operator()(const counter_target &target) const
+    {
+        uint64_t h = (target.entity_id ^ ((uint64_t)target.desc_type << 48) ^ ((uint64_t)target.desc_index << 32)) *
+                     0x9e3779b97f4a7c15ULL;
+        return (size_t)(h ^ (h >> 32));
+    }
+};
+
+struct counter_sample
+{
+    static const size_t max_counters = 32;
+
+    counter_target target;
+    uint32_t valid; // bit n set when values[n] is valid
+    uint32_t values[max_counters];
+};
+
+class counter_monitor
+{
+public:
+    static const uint32_t min_interval_ms = 1000;
+    static const uint32_t max_interval_ms = 30000;
+    static const size_t npos = (size_t)-1;
+
+    typedef std::function<int(const counter_target &target)> sender;
+
+    counter_monitor(double commands_per_second);
+    virtual ~counter_monitor();
+
+    void set_budget(double commands_per_second);
+    double get_budget() const;
+
+    /*
+     * Replaces the target list. Targets already known keep their interval
+     * and last sample; new ones are spread over the minimum interval.
+     */
+    void set_targets(const std::vector<counter_target> &targets, uint64_t now_ms);
+    size_t tick(uint64_t now_ms, const sender &send);
+
+    // both return the target's index, or npos if it is no longer monitored
+    size_t report(const counter_sample &sample, uint64_t now_ms, bool &changed);
+    size_t report_failure(const counter_target &target, uint64_t now_ms);
+
+    size_t get_target_count() const;
+    const counter_target & get_target(size_t index) const;
+    uint32_t get_interval_ms(size_t index) const;
+    const counter_sample * get_last_sample(size_t index) const;
+    size_t find_target(const counter_target &target) const;
+
+private:
+    struct target_state
+    {
+        counter_target target;
+        uint32_t interval_ms;
+        uint64_t next_poll_ms;
+        bool in_flight;
+        bool has_sample;
+        counter_sample last;
+    };
+
+    typedef std::pair<uint64_t, size_t> due_entry;
+
+    void schedule(size_t index, uint64_t now_ms);
+    void refill(uint64_t now_ms);
+
+    std::vector<target_state> m_targets;
+    std::unordered_map<counter_target, size_t, counter_target_hash> m_index;
+    std::priority_queue<due_entry, std::vector<due_entry>, std::greater<due_entry> > m_due;
+
+    double m_rate;
+    double m_tokens;
+    uint64_t m_last_refill_ms;
+};
@@ -0,0 +1,95 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * counter_monitor_panel.h
+ *
+ * Monitor page: one virtual list row per counter target with its current
+ * poll interval, latest counter values and a sparkline of recent history.
+ * Only rows whose counters changed are redrawn.
+ */
+
+#pragma once
+
+#include <functional>
+#include "wx/panel.h"
+#include "wx/listctrl.h"
+#include "wx/checkbox.h"
+#include "wx/spinctrl.h"
+#include "wx/stattext.h"
+#include "counter_monitor.h"
+
+class counter_list : public wxListCtrl
+{
+public:
+    typedef std::function<wxString(const counter_target &target)> target_formatter;
+    typedef std::function<wxString(const counter_target &target, const counter_sample &sample)> sample_formatter;
+    typedef std::function<wxString(const counter_target &target)> trend_formatter;
+
+    counter_list(wxWindow *parent, const counter_monitor *monitor);
+    virtual ~counter_list();
+
+    void set_formatters(const target_formatter &format_target, const sample_formatter &format_sample,
+                        const trend_formatter &format_trend);
+
+protected:
+    virtual wxString OnGetItemText(long item, long column) const;
+
+private:
+    const counter_monitor *m_monitor;
+    target_formatter m_format_target;
+    sample_formatter m_format_sample;
+    trend_formatter m_format_trend;
+};
+
+class counter_monitor_panel : public wxPanel
+{
+public:
+    typedef std::function<void(bool enabled)> enable_handler;
+    typedef std::function<void(int commands_per_second)> budget_handler;
+
+    counter_monitor_panel(wxWindow *parent, const counter_monitor *monitor, int commands_per_second);
+    virtual ~counter_monitor_panel();
+
+    void set_handlers(const enable_handler &on_enable, const budget_handler &on_budget);
+    void set_formatters(const counter_list::target_formatter &format_target,
+                        const counter_list::sample_formatter &format_sample,
+                        const counter_list::trend_formatter &format_trend);
+    bool is_enabled() const;
+
+    void refresh_targets();
+    void refresh_target(size_t index);
+    void set_status(const wxString &status);
+
+    void OnEnable(wxCommandEvent& event);
+    void OnBudget(wxSpinEvent& event);
+
+private:
+    const counter_monitor *m_monitor;
+    wxCheckBox *m_enable;
+    wxSpinCtrl *m_budget;
+    wxStaticText *m_status;
+    counter_list *m_list;
+    enable_handler m_on_enable;
+    budget_handler m_on_budget;
+};
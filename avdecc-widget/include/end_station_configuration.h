@@ -26,30 +26,36 @@
  *
  */
 
+#pragma once
+
 #include <cstdint>
 #include <iostream>
 #include <wx/string.h>
+#include "string_pool.h"
 
 class end_station_configuration
 {
 public:
-    end_station_configuration(wxString entity_name, wxString id_entity, wxString name_default,
-                              wxString mac_add, wxString firmware_ver, uint32_t initial_sample_rate);
+    end_station_configuration(const wxString &entity_name, uint64_t id_entity, const wxString &name_default,
+                              uint64_t mac_add, const wxString &firmware_ver, uint32_t initial_sample_rate);
     virtual ~end_station_configuration();
     
-    wxString get_entity_name();
-    wxString get_entity_id();
-    wxString get_default_name();
-    wxString get_mac();
-    wxString get_fw_ver();
-    uint32_t get_sample_rate();
+    const wxString & get_entity_name() const;
+    wxString get_entity_id() const;
+    uint64_t get_entity_id_value() const;
+    const wxString & get_default_name() const;
+    wxString get_mac() const;
+    uint64_t get_mac_value() const;
+    const wxString & get_fw_ver() const;
+    uint32_t get_sample_rate() const;
     int set_sample_rate(uint32_t sampling_rate);
+    void set_entity_name(const wxString &entity_name);
 
 private:
-    wxString name;
-    wxString entity_id;
-    wxString default_name;
-    wxString mac;
-    wxString fw_ver;
+    string_pool::handle name;
+    uint64_t entity_id;
+    string_pool::handle default_name;
+    uint64_t mac;
+    string_pool::handle fw_ver;
     uint32_t sample_rate;
-};
\ No newline at end of file
+};
@@ -58,22 +58,51 @@
 #include "wx/numdlg.h"
 #include "wx/htmllbox.h"
 #include "wx/grid.h"
-#include "end_station_configuration.h"
-#include "stream_configuration.h"
+#include "wx/checkbox.h"
+#include <functional>
+#include <memory>
+#include "config_snapshot.h"
+#include "trace_log.h"
+#include "console_log.h"
 
 
+/*
+ * In live mode grid and sampling-rate edits are sent while the dialog is
+ * open. Edits restart a short timer, and when it fires everything changed
+ * since the last send goes out as one asynchronous apply, so a burst of
+ * clicks on a stream sends only its final value. One live apply is in
+ * flight at a time; edits made meanwhile are sent when it completes.
+ * Apply goes out through the same sender, after any live apply still in
+ * flight, and diffs against what the device last committed.
+ */
 class end_station_details : public wxFrame
 {
 public:
-    end_station_details(wxWindow *parent, end_station_configuration *config, stream_configuration *stream_config);
+    typedef std::function<void(bool committed)> live_done;
+    typedef std::function<void(const config_snapshot &from, const config_snapshot &to, const live_done &done)> live_sender;
+
+    static const int live_apply_delay_ms = 250;
+
+    end_station_details(wxWindow *parent, const config_snapshot &config);
     virtual ~end_station_details();
 
-    void CreateEndStationDetailsPanel(wxString Entity_Name, wxString Default_Name,
-                                      uint32_t Init_Sampling_Rate, wxString Entity_ID,
-                                      wxString Mac, wxString fw_ver);
+    void SetLiveApply(const live_sender &send);
+
+    /**
+     * Sends the result of OnOK once no live apply is in flight, then
+     * destroys the dialog.
+     */
+    void ApplyAndDestroy();
+
+    void CreateEndStationDetailsPanel(const wxString &Entity_Name, const wxString &Default_Name,
+                                      uint32_t Init_Sampling_Rate, const wxString &Entity_ID,
+                                      const wxString &Mac, const wxString &fw_ver);
 
     void CreateAndSizeGrid(unsigned int stream_input_count, unsigned int stream_output_count);
     void OnGridCellChange(wxGridEvent& event);
+    void OnSamplingRateChange(wxCommandEvent& event);
+    void OnLiveToggle(wxCommandEvent& event);
+    void OnLiveTimer(wxTimerEvent& event);
     void SetChannelChoice(unsigned int stream_input_count, unsigned int stream_output_count);
     void SetInputChannelCount(unsigned int stream_index, unsigned int channel_count,
                               unsigned int stream_input_count);
@@ -82,10 +111,18 @@ public:
 
     void CreateInputStreamGridHeader();
     void CreateOutputStreamGridHeader();
-    void SetInputChannelName(unsigned int stream_index, wxString name);
-    void SetOutputChannelName(unsigned int stream_index, wxString name);
+    void SetInputChannelName(unsigned int stream_index, const wxString &name);
+    void SetOutputChannelName(unsigned int stream_index, const wxString &name);
+    void SetChannelMappings(wxGrid *grid, unsigned int stream_count, const audio_mapping_set &mappings);
+    void GetChannelMappings(wxGrid *grid, unsigned int stream_count, const audio_mapping_set &initial,
+                            audio_mapping_set &mappings);
 
     void OnOK();
+
+    /**
+     * Closes the dialog. Changes already sent by live mode are reverted to
+     * the snapshot the dialog opened with before it is destroyed.
+     */
     void OnCancel();
     int ShowModal();
     
@@ -93,18 +130,18 @@ public:
     unsigned int m_stream_input_count;
     unsigned int m_stream_output_count;
     
-    stream_configuration * m_stream_config;
-    end_station_configuration * m_end_station_config;
+    config_snapshot m_result;
 
 private:
+    config_snapshot ReadGrid();
+    void ScheduleLiveApply();
+    void SendLiveApply();
+    void SendFinalApply();
+
     wxDialog *EndStation_Details_Dialog;
     
     uint64_t channel_count;
-    wxString m_mac;
-    wxString m_default_name;
-    wxString m_entity_id;
-    wxString m_fw_ver;
-    wxString m_entity_name;
+    config_snapshot m_initial;
 
     wxTextCtrl *name;
     wxTextCtrl *default_name;
@@ -115,6 +152,16 @@ private:
     
     wxButton * apply_button;
     wxButton * cancel_button;
+    wxCheckBox * live_checkbox;
+
+    wxTimer m_live_timer;
+    live_sender m_live_send;
+    config_snapshot m_live_base;
+    bool m_live_in_flight;
+    bool m_live_dirty;
+    bool m_live_sent; // a live apply has gone out, so Cancel has something to revert
+    bool m_closing; // Apply or Cancel was pressed; the final send follows the live one in flight
+    std::shared_ptr<bool> m_alive; // live completions arriving after the dialog closed are dropped
 
     wxGrid * input_stream_grid;
     wxGrid * output_stream_grid;
@@ -128,6 +175,4 @@ private:
     wxBoxSizer * input_stream_header_sizer;
     wxStaticBoxSizer *Output_Stream_Sizer;
     wxBoxSizer * output_stream_header_sizer;
-    
-    wxDECLARE_EVENT_TABLE();
 };
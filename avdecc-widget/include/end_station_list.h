@@ -0,0 +1,107 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * end_station_list.h
+ *
+ * Virtual report list of discovered end stations. Rows are formatted only
+ * when wx asks for a visible cell, and the filter box narrows the rows
+ * through an incremental entity_search_index. Clicking a column header
+ * sorts on typed keys kept with each record; new and changed records are
+ * moved into place without re-sorting the whole list. While the filter and
+ * sort stay the same and no entity is added, a changed record is moved
+ * within the shown rows and only the rows it passed over are repainted.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <wx/listctrl.h>
+#include "string_pool.h"
+#include "entity_search_index.h"
+#include "entity_table.h"
+
+class end_station_list : public wxListCtrl
+{
+public:
+    end_station_list(wxWindow *parent, wxWindowID id, const wxPoint &pos, const wxSize &size);
+    virtual ~end_station_list();
+
+    void update_entity(const entity_record &record);
+    void set_filter(const wxString &filter);
+    void refresh_rows();
+
+    size_t get_entity_count() const;
+    const entity_record & get_entity(size_t slot) const;
+    const entity_record * get_entity_by_row(long row) const;
+    const entity_record * get_entity_by_id(uint64_t entity_id) const;
+
+    void sort_by_column(int column, bool ascending);
+    void OnColumnClick(wxListEvent& event);
+
+    static std::string natural_sort_key(const wxString &text);
+
+    /**
+     * The text of one cell of a record's row; needs no window.
+     */
+    static wxString format_cell(const entity_record &record, long column);
+
+protected:
+    virtual wxString OnGetItemText(long item, long column) const;
+
+private:
+    struct slot_order
+    {
+        const end_station_list *list;
+        bool operator()(uint32_t a, uint32_t b) const { return list->slot_less(a, b); }
+    };
+
+    bool slot_less(uint32_t a, uint32_t b) const;
+    void remove_from_order(uint32_t slot);
+    void insert_into_order(uint32_t slot);
+    long remove_from_rows(uint32_t slot);
+    long insert_into_rows(uint32_t slot);
+    void mark_rows_dirty(long first, long last);
+    void update_column_headers();
+
+    std::vector<entity_record> m_entities;
+    std::unordered_map<uint64_t, uint32_t> m_slots;
+    entity_search_index m_search_index;
+    std::string m_filter;
+    std::vector<uint32_t> m_rows;
+    bool m_rows_stale; // the rows must be rebuilt from m_order and the filter
+    long m_dirty_first; // rows patched since the last refresh_rows, -1 if none
+    long m_dirty_last;
+
+    int m_sort_column;
+    bool m_sort_ascending;
+    std::vector<uint32_t> m_order;
+    std::vector<uint32_t> m_matches;
+    std::vector<char> m_match_flags;
+    std::vector<wxString> m_column_titles;
+
+    wxDECLARE_EVENT_TABLE();
+};
@@ -0,0 +1,86 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * entity_config_cache.h
+ *
+ * Configuration read from each end station, kept up to date from AEM
+ * responses and unsolicited notifications instead of re-reading descriptors.
+ * Each patch publishes a new snapshot sharing the unchanged parts, so a
+ * snapshot handed out earlier stays as it was. Also tracks when each
+ * entity's unsolicited notification registration is due for renewal; a
+ * cached configuration is only current while that registration holds.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <wx/string.h>
+#include "config_snapshot.h"
+
+class entity_config_cache
+{
+public:
+    // entities drop registrations from controllers they have not heard from for a while
+    static const uint32_t registration_renew_ms = 50000;
+    static const uint32_t registration_retry_ms = 5000;
+
+    entity_config_cache();
+    virtual ~entity_config_cache();
+
+    void track(uint64_t entity_id, uint64_t now_ms);
+    void remove(uint64_t entity_id);
+    void clear();
+
+    void take_due_registrations(uint64_t now_ms, std::vector<uint64_t> &entity_ids);
+    void registration_succeeded(uint64_t entity_id, uint64_t now_ms);
+    void registration_unsupported(uint64_t entity_id);
+    void registration_failed(uint64_t entity_id);
+    bool is_registered(uint64_t entity_id) const;
+
+    const config_snapshot * find(uint64_t entity_id) const;
+    void store(uint64_t entity_id, const config_snapshot &snapshot);
+
+    bool set_sample_rate(uint64_t entity_id, uint32_t sample_rate);
+    bool set_entity_name(uint64_t entity_id, const wxString &name);
+    bool set_stream_name(uint64_t entity_id, bool input, uint16_t stream_index, const wxString &name);
+    bool set_stream_channel_count(uint64_t entity_id, bool input, uint16_t stream_index, unsigned int channel_count);
+    bool set_audio_mappings(uint64_t entity_id, bool input, const audio_mapping_set &mappings);
+
+private:
+    struct entry
+    {
+        config_snapshot snapshot;
+        uint64_t next_registration_ms; // 0 when registration is not supported
+        bool registered;
+    };
+
+    entity_config_cache(const entity_config_cache &);
+    entity_config_cache & operator=(const entity_config_cache &);
+
+    entry * find_cached(uint64_t entity_id);
+
+    std::unordered_map<uint64_t, entry> m_entries;
+};
@@ -0,0 +1,100 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * entity_model.h
+ *
+ * Static descriptor data shared by every entity of the same entity_model_id:
+ * the strings table, descriptor counts and each stream's default name and
+ * supported formats. A model is built once from the first entity seen and is
+ * immutable afterwards; configuration snapshots keep only the per-entity
+ * state (names set by users, sampling rate, current formats) and point at
+ * the shared model.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "string_pool.h"
+
+struct stream_model
+{
+    string_pool::handle default_name; // localized description, shown when the entity sets no object name
+    std::vector<uint64_t> formats;
+
+    bool supports(uint64_t format_value) const;
+};
+
+class entity_model
+{
+public:
+    static const size_t strings_count = 7; // strings in one STRINGS descriptor
+
+    explicit entity_model(uint64_t model_id);
+    virtual ~entity_model();
+
+    uint64_t get_model_id() const { return m_model_id; }
+    const wxString & get_string(size_t index) const;
+    const std::vector<stream_model> & streams(bool input) const { return input ? m_inputs : m_outputs; }
+    const stream_model * find_stream(bool input, size_t stream_index) const;
+
+    void set_string(size_t index, const wxString &str);
+    void add_stream(bool input, const stream_model &stream);
+
+private:
+    uint64_t m_model_id;
+    string_pool::handle m_strings[strings_count];
+    std::vector<stream_model> m_inputs;
+    std::vector<stream_model> m_outputs;
+};
+
+class entity_model_registry
+{
+public:
+    entity_model_registry();
+    virtual ~entity_model_registry();
+
+    std::shared_ptr<const entity_model> find(uint64_t model_id) const;
+
+    /**
+     * Registers a model built from an entity. If another entity of the same
+     * model got there first, the model already registered is returned and
+     * the new one is dropped.
+     */
+    std::shared_ptr<const entity_model> insert(const std::shared_ptr<const entity_model> &model);
+
+    size_t size() const;
+    uint64_t get_shared_count() const;
+
+private:
+    entity_model_registry(const entity_model_registry &);
+    entity_model_registry & operator=(const entity_model_registry &);
+
+    mutable std::mutex m_lock;
+    std::unordered_map<uint64_t, std::shared_ptr<const entity_model>> m_models;
+    mutable uint64_t m_shared_count;
+};
@@ -0,0 +1,83 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * entity_search_index.h
+ *
+ * Incremental substring index over the searchable text of each discovered
+ * entity (name, entity ID hex, MAC hex, firmware version). Every slot keeps
+ * its lower-cased text and contributes to trigram posting lists that are
+ * patched when the entity arrives or changes, so a query never rescans the
+ * entities' descriptors.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class entity_search_index
+{
+public:
+    entity_search_index();
+    virtual ~entity_search_index();
+
+    void update(uint32_t slot, const std::vector<std::string> &fields);
+    void remove(uint32_t slot);
+    void clear();
+
+    /*
+     * Writes the slots whose text contains query (case-insensitive) to
+     * matches in ascending slot order. An empty query matches every slot.
+     */
+    void query(const std::string &query, std::vector<uint32_t> &matches);
+
+    /*
+     * Whether one slot's text contains query (case-insensitive), without
+     * walking the other slots.
+     */
+    bool matches(uint32_t slot, const std::string &query) const;
+
+    size_t size() const;
+
+private:
+    static uint32_t trigram_at(const std::string &text, size_t pos);
+    static std::string to_lower(const std::string &text);
+
+    void add_postings(uint32_t slot, const std::string &text);
+    void remove_postings(uint32_t slot, const std::string &text);
+    void verify(const std::string &query, const std::vector<uint32_t> &candidates, std::vector<uint32_t> &matches) const;
+
+    std::vector<std::string> m_text;
+    std::vector<bool> m_present;
+    std::unordered_map<uint32_t, std::vector<uint32_t> > m_postings;
+    size_t m_count;
+
+    // result of the previous query, reused when the next query extends it
+    uint64_t m_version;
+    uint64_t m_last_version;
+    std::string m_last_query;
+    std::vector<uint32_t> m_last_matches;
+};
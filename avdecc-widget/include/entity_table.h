@@ -0,0 +1,163 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * entity_table.h
+ *
+ * The widget's own table of discovered entities, published as immutable
+ * versions. Callback threads re-read an entity from avdecc-lib when it
+ * connects, disconnects or changes, build the next version and swap it in
+ * with an atomic store; the GUI thread takes the current version with an
+ * atomic load and never locks or waits for the network threads.
+ *
+ * avdecc-lib has no public lock around its descriptor storage, so a record
+ * is only read once a notification says the entity changed, after
+ * avdecc-lib has stored the response. The notification timer re-reads each
+ * changed entity once per coalesce window, and only from the interface that
+ * reported it. Everything the GUI shows or exports about an entity is copied
+ * into the record there; the GUI only hands descriptor pointers to
+ * avdecc-lib to send commands.
+ *
+ * Records are kept in fixed-size chunks and a new version copies only the
+ * chunk that changed, sharing the rest with the previous one. Each chunk
+ * remembers the generation it last changed in, so a reader can skip the
+ * chunks it has already seen.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "string_pool.h"
+
+struct entity_stream
+{
+    bool input;
+    uint16_t stream_index;
+    string_pool::handle name;
+    string_pool::handle format;
+
+    bool operator==(const entity_stream &other) const;
+};
+
+struct entity_record
+{
+    uint64_t entity_id;
+    uint64_t mac;
+    uint64_t entity_model_id;
+    string_pool::handle name;
+    string_pool::handle fw_ver;
+    string_pool::handle interface_name;
+    char connection_status;
+    uint32_t interface_index;
+    uint32_t end_station_index;
+
+    // from the current configuration; enumerated stays false until its descriptor has been read
+    bool enumerated;
+    uint32_t sample_rate;
+    uint16_t avb_interface_count;
+    uint16_t clock_domain_count;
+    std::vector<entity_stream> streams; // inputs, then outputs, each by descriptor index
+
+    // sort keys, filled in by end_station_list
+    std::string name_key;
+    std::string fw_ver_key;
+
+    bool same_state(const entity_record &other) const;
+    const entity_stream * find_stream(bool input, uint16_t stream_index) const;
+};
+
+class entity_table
+{
+public:
+    static const size_t chunk_size = 64;
+
+    struct chunk
+    {
+        uint64_t generation;
+        std::vector<entity_record> records;
+    };
+
+    class version
+    {
+    public:
+        version();
+
+        uint64_t get_generation() const { return m_generation; }
+        size_t size() const { return m_size; }
+        size_t get_chunk_count() const { return m_chunks.size(); }
+        const chunk & get_chunk(size_t index) const { return *m_chunks[index]; }
+        const entity_record & at(size_t slot) const { return m_chunks[slot / chunk_size]->records[slot % chunk_size]; }
+
+    private:
+        friend class entity_table;
+
+        uint64_t m_generation;
+        size_t m_size;
+        std::vector<std::shared_ptr<const chunk>> m_chunks;
+    };
+
+    /**
+     * Reads an entity's current state from one interface's controller.
+     * Returns false if that interface does not know the entity.
+     */
+    typedef std::function<bool(uint32_t interface_index, uint64_t entity_id, entity_record &record)> reader;
+
+    entity_table();
+    virtual ~entity_table();
+
+    void set_reader(const reader &read);
+
+    /**
+     * The latest published version. Lock-free; the version stays valid for
+     * as long as the caller holds it.
+     */
+    std::shared_ptr<const version> current() const;
+
+    /**
+     * Re-reads the entities from one interface and publishes a new version
+     * if any of them changed. An entity reachable through several NICs stays
+     * listed against the interface it was first read from, and reads from
+     * the others are dropped. Writers are serialised among themselves only.
+     */
+    void refresh(uint32_t interface_index, uint64_t entity_id);
+    void refresh(uint32_t interface_index, const std::vector<uint64_t> &entity_ids);
+
+    void clear();
+
+private:
+    entity_table(const entity_table &);
+    entity_table & operator=(const entity_table &);
+
+    bool apply(version &next, const entity_record &record);
+
+    std::mutex m_writer_lock;
+    reader m_read;
+    std::unordered_map<uint64_t, size_t> m_slots;
+    std::shared_ptr<const version> m_current; // only touched through std::atomic_load/atomic_store
+};
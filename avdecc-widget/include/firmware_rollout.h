@@ -0,0 +1,144 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * firmware_rollout.h
+ *
+ * Rolls a firmware image out to a set of end stations in waves. Within a
+ * wave up to `parallelism` uploads run at once, so the fleet shares the
+ * network instead of waiting on each device in turn. After an upload the
+ * device is expected to drop off and be re-discovered; its entity
+ * descriptor is then read from the device again and the firmware version
+ * in it compared with the expected one. A wave must finish before the next
+ * starts, and the rollout halts once more than `max_failures` devices have
+ * failed. A device that could not be started waits longer before each new
+ * attempt.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "firmware_upload.h"
+
+enum rollout_stage
+{
+    ROLLOUT_PENDING,
+    ROLLOUT_UPLOADING,
+    ROLLOUT_REBOOTING,
+    ROLLOUT_VERIFYING,
+    ROLLOUT_DONE,
+    ROLLOUT_FAILED,
+    ROLLOUT_SKIPPED
+};
+
+struct rollout_options
+{
+    unsigned int parallelism;
+    unsigned int first_wave_size;
+    unsigned int wave_size;
+    unsigned int max_failures;
+    unsigned int max_attempts;
+    uint32_t reboot_timeout_ms;
+    uint32_t verify_timeout_ms;
+    uint32_t verify_retry_ms;
+    uint32_t retry_delay_ms; // doubled after each failed attempt
+
+    rollout_options();
+};
+
+struct rollout_device
+{
+    uint64_t entity_id;
+    unsigned int wave;
+    rollout_stage stage;
+    uint64_t stage_ms;
+    unsigned int attempts;
+    uint64_t retry_ms; // a pending device is not started again before this
+    bool went_offline;
+    bool verify_pending;
+    uint64_t verify_sent_ms;
+    uint64_t resume_offset;
+    std::string version;
+    std::string error;
+    std::shared_ptr<firmware_upload> upload;
+};
+
+class firmware_rollout
+{
+public:
+    typedef std::function<std::shared_ptr<firmware_upload>(uint64_t entity_id, uint64_t resume_offset, std::string &error)> upload_starter;
+    // asks the device for its firmware version; the answer comes back through version_read()
+    typedef std::function<void(uint64_t entity_id)> version_reader;
+
+    firmware_rollout();
+    virtual ~firmware_rollout();
+
+    void start(const std::vector<uint64_t> &targets, const std::string &target_version,
+               const rollout_options &options, uint64_t now_ms);
+    void abort();
+
+    bool tick(uint64_t now_ms, const upload_starter &start_upload, const version_reader &read_version);
+    void entity_disconnected(uint64_t entity_id);
+    void entity_connected(uint64_t entity_id, uint64_t now_ms);
+    void version_read(uint64_t entity_id, bool ok, const std::string &version, uint64_t now_ms);
+
+    /*
+     * Devices whose row changed since the last call: a new stage, or an
+     * upload still moving its progress.
+     */
+    void take_changed(std::vector<size_t> &indices);
+
+    bool is_running() const;
+    size_t get_device_count() const;
+    const rollout_device & get_device(size_t index) const;
+    size_t get_stage_count(rollout_stage stage) const;
+    unsigned int get_current_wave() const;
+    unsigned int get_wave_count() const;
+    double get_throughput() const;
+    uint64_t get_elapsed_ms(uint64_t now_ms) const;
+
+    static const char * stage_name(rollout_stage stage);
+
+private:
+    void set_stage(rollout_device &device, rollout_stage stage, uint64_t now_ms);
+    void fail(rollout_device &device, const std::string &error, uint64_t now_ms);
+    bool wave_finished() const;
+    void retry_later(rollout_device &device, uint64_t now_ms);
+
+    std::vector<rollout_device> m_devices;
+    std::unordered_map<uint64_t, size_t> m_index;
+    std::vector<size_t> m_stage_counts;
+    std::vector<size_t> m_changed;
+    std::string m_target_version;
+    rollout_options m_options;
+    unsigned int m_wave;
+    unsigned int m_wave_count;
+    unsigned int m_active_uploads;
+    bool m_running;
+    uint64_t m_started_ms;
+};
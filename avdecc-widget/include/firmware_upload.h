@@ -0,0 +1,143 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * firmware_upload.h
+ *
+ * Streams a memory-mapped image to a memory object with AECP address access
+ * writes. A window of writes is kept in flight and the next one is sent
+ * straight from the completion of the previous, on the callback thread.
+ * The window grows by one write per window of successes and halves on a
+ * timeout or error; failed writes are retried with smaller chunks. The
+ * contiguous acknowledged offset survives a failure so a later attempt
+ * can resume from it.
+ *
+ * Optional begin and finish commands bracket the writes: begin opens the
+ * memory object for upload and finish asks the device to confirm it took
+ * the whole image. Both are sent without blocking, like the writes, and
+ * the upload is only done once finish has succeeded.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "mapped_file.h"
+#include "pending_command_table.h"
+
+class firmware_upload : public std::enable_shared_from_this<firmware_upload>
+{
+public:
+    typedef std::function<void *()> id_allocator;
+    typedef std::function<int(void *notification_id, uint64_t address, const uint8_t *data, size_t length)> writer;
+    typedef std::function<bool(const notification_record &record)> result_check;
+    typedef std::function<int(void *notification_id)> operation;
+
+    enum upload_state
+    {
+        UPLOAD_IDLE,
+        UPLOAD_RUNNING,
+        UPLOAD_DONE,
+        UPLOAD_FAILED,
+        UPLOAD_CANCELLED
+    };
+
+    // one TLV of data in a 524 byte AECPDU after the address access headers
+    static const size_t max_chunk_bytes = 502;
+    static const size_t min_chunk_bytes = 64;
+    static const unsigned int initial_window = 4;
+    static const unsigned int max_window = 32;
+    static const unsigned int max_retries = 5;
+
+    firmware_upload(pending_command_table &pending, const id_allocator &next_id, const writer &write,
+                    const result_check &succeeded);
+    virtual ~firmware_upload();
+
+    int open(const std::string &path);
+    void set_operations(const operation &begin, const operation &finish);
+    bool start(uint64_t base_address, uint64_t resume_offset);
+    void cancel();
+
+    upload_state get_state() const;
+    std::string get_error() const;
+    uint64_t get_size() const;
+    uint64_t get_acked_bytes() const;
+    uint64_t get_resume_offset() const;
+    unsigned int get_window() const;
+    double get_throughput() const;
+
+private:
+    struct chunk
+    {
+        uint64_t offset;
+        size_t length;
+    };
+
+    enum upload_phase
+    {
+        PHASE_BEGIN,
+        PHASE_WRITE,
+        PHASE_FINISH
+    };
+
+    void send_operation(upload_phase phase);
+    void on_operation(upload_phase phase, const notification_record &record);
+    void fail_locked(const std::string &error);
+    void pump();
+    void on_complete(const chunk &c, const notification_record &record);
+    void ack_locked(const chunk &c);
+    void cancel_all(const std::map<void *, chunk> &in_flight);
+
+    pending_command_table &m_pending;
+    id_allocator m_next_id;
+    writer m_write;
+    result_check m_succeeded;
+    operation m_begin;
+    operation m_finish;
+    mapped_file m_file;
+
+    mutable std::mutex m_lock;
+    upload_state m_state;
+    upload_phase m_phase;
+    void *m_operation_id; // begin or finish command in flight, or NULL
+    std::string m_error;
+    uint64_t m_base_address;
+    uint64_t m_next_offset;
+    uint64_t m_contiguous;
+    uint64_t m_acked_bytes;
+    uint64_t m_started_bytes;
+    double m_window;
+    size_t m_chunk_bytes;
+    std::map<void *, chunk> m_in_flight;
+    std::map<uint64_t, uint64_t> m_acked_ranges;
+    std::deque<chunk> m_retry;
+    std::map<uint64_t, unsigned int> m_retries;
+    std::chrono::steady_clock::time_point m_started;
+};
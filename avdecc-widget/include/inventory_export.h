@@ -0,0 +1,102 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * inventory_export.h
+ *
+ * CSV/JSON export of the discovered end stations. The GUI thread only hands
+ * over the published entity table version; a background thread copies it
+ * into a compact snapshot (pooled string handles only) and streams that to
+ * disk through a buffered FILE, one record at a time.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "entity_table.h"
+#include "string_pool.h"
+
+enum inventory_format
+{
+    INVENTORY_CSV,
+    INVENTORY_JSON
+};
+
+struct inventory_stream
+{
+    bool input;
+    uint16_t stream_index;
+    string_pool::handle name;
+    string_pool::handle format;
+};
+
+struct inventory_entity
+{
+    uint64_t entity_id;
+    uint64_t mac;
+    string_pool::handle name;
+    string_pool::handle fw_ver;
+    uint32_t sample_rate;
+    uint32_t first_stream;
+    uint32_t stream_count;
+};
+
+struct inventory_snapshot
+{
+    std::vector<inventory_entity> entities;
+    std::vector<inventory_stream> streams;
+};
+
+class inventory_writer
+{
+public:
+    typedef std::function<void(bool ok, size_t entity_count, double seconds)> completion;
+
+    inventory_writer();
+    virtual ~inventory_writer();
+
+    /*
+     * Starts exporting entities to path on a background thread; done is
+     * called on that thread when the file is closed, with the time taken to
+     * snapshot and write. Returns false if an export is already running.
+     */
+    bool start(const std::shared_ptr<const entity_table::version> &entities, const std::string &path,
+               inventory_format format, const completion &done);
+    bool is_busy() const;
+
+    static void take_snapshot(const entity_table::version &entities, inventory_snapshot &snapshot);
+    static bool write(const inventory_snapshot &snapshot, FILE *file, inventory_format format);
+
+private:
+    void run(std::shared_ptr<const entity_table::version> entities, std::string path, inventory_format format, completion done);
+
+    std::thread m_thread;
+    std::atomic<bool> m_busy;
+};
@@ -0,0 +1,79 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * listener_state_poller.h
+ *
+ * Spreads GET_RX_STATE and GET_STREAM_INFO reads of every listener stream
+ * evenly over a refresh interval, one entity at a time, so the request rate
+ * stays constant however many listeners there are. Responses are compared
+ * with the last snapshot on the callback thread and only changes are passed
+ * on to the GUI.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "acmp_command_queue.h"
+
+class listener_state_poller
+{
+public:
+    typedef std::function<void(const acmp_command &command)> request_handler;
+
+    listener_state_poller(uint32_t refresh_interval_ms);
+    virtual ~listener_state_poller();
+
+    // set_listeners, tick and forget belong to the GUI thread
+    void set_listeners(const std::vector<stream_endpoint> &listeners);
+    void set_refresh_interval(uint32_t refresh_interval_ms);
+    void tick(uint64_t now_ms, const request_handler &request);
+
+    /*
+     * Stores the state read by command and returns true if it differs from
+     * the previous snapshot of that listener. Called on the callback thread.
+     */
+    bool update_snapshot(const acmp_command &command, const listener_state &state);
+    void invalidate(const stream_endpoint &listener);
+    void forget(uint64_t entity_id);
+
+private:
+    struct entity_group
+    {
+        uint64_t entity_id;
+        std::vector<uint16_t> stream_indexes;
+    };
+
+    std::vector<entity_group> m_groups;
+    uint32_t m_refresh_interval_ms;
+    uint64_t m_cycle_start_ms;
+    size_t m_next_group;
+
+    std::mutex m_snapshot_lock;
+    std::unordered_map<stream_endpoint, listener_state, stream_endpoint_hash> m_rx_snapshot;
+    std::unordered_map<stream_endpoint, listener_state, stream_endpoint_hash> m_info_snapshot;
+};
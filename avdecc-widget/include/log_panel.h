@@ -0,0 +1,105 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * log_panel.h
+ *
+ * Log page: a virtual list over the log_store, filtered by level, entity,
+ * command type and status. Only the rows wx asks to draw are formatted,
+ * and each refresh checks only the records added since the last one, so
+ * scrolling and typing stay fast with a million records held.
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "wx/panel.h"
+#include "wx/listctrl.h"
+#include "wx/choice.h"
+#include "wx/checkbox.h"
+#include "wx/stattext.h"
+#include "wx/textctrl.h"
+#include "log_store.h"
+
+class log_list : public wxListCtrl
+{
+public:
+    typedef std::function<wxString(const log_record &record, long column)> cell_formatter;
+
+    log_list(wxWindow *parent, const log_store *store, const log_view *view);
+    virtual ~log_list();
+
+    void set_formatter(const cell_formatter &format_cell);
+
+protected:
+    virtual wxString OnGetItemText(long item, long column) const;
+
+private:
+    const log_store *m_store;
+    const log_view *m_view;
+    cell_formatter m_format_cell;
+};
+
+class log_panel : public wxPanel
+{
+public:
+    typedef std::function<wxString(uint8_t level)> level_formatter;
+    typedef std::function<wxString(uint16_t cmd_type)> command_formatter;
+    typedef std::function<wxString(uint32_t cmd_status)> status_formatter;
+
+    log_panel(wxWindow *parent, const log_store *store, uint8_t level_count);
+    virtual ~log_panel();
+
+    void set_formatters(const log_list::cell_formatter &format_cell, const level_formatter &format_level,
+                        const command_formatter &format_command, const status_formatter &format_status);
+
+    /**
+     * Picks up records added to the store since the last call.
+     */
+    void refresh_records();
+
+private:
+    void OnFilter(wxCommandEvent& event);
+    void apply_filter();
+    void update_choices();
+    void update_count();
+
+    const log_store *m_store;
+    log_view m_view;
+    uint8_t m_level_count;
+    uint64_t m_counted_seq;
+    command_formatter m_format_command;
+    status_formatter m_format_status;
+
+    std::vector<uint16_t> m_cmd_types; // command choice entries after "Any command"
+    std::vector<uint32_t> m_statuses;  // status choice entries after "Any status"
+
+    wxChoice *m_level;
+    wxTextCtrl *m_entity;
+    wxChoice *m_command;
+    wxChoice *m_status;
+    wxCheckBox *m_follow;
+    wxStaticText *m_count;
+    log_list *m_list;
+};
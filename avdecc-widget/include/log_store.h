@@ -0,0 +1,172 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * log_store.h
+ *
+ * Bounded in-memory history of notifications and avdecc-lib log messages
+ * for the log viewer. Records are fixed-size and kept in a ring of up to a
+ * million entries; log message text goes into a separate byte ring and is
+ * dropped once newer text overwrites it. Records are addressed by a
+ * sequence number that keeps counting after the ring wraps.
+ *
+ * The store itself belongs to the GUI thread. Log messages from the
+ * callback threads are posted to an inbox and moved in by drain(); the
+ * inbox holds at most max_inbox messages, and the drops are logged as one
+ * message of the most severe level dropped.
+ * log_view keeps the sequence numbers matching a filter and extends them
+ * with each new batch instead of rescanning.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+#include "notification_coalescer.h"
+
+struct log_record
+{
+    uint64_t time_ms;
+    uint64_t entity_id;
+    uint64_t text_pos;
+    uint32_t cmd_status;
+    int32_t notification_type;
+    uint16_t cmd_type;
+    uint16_t desc_type;
+    uint16_t desc_index;
+    uint16_t text_length;
+    uint16_t repeat_count;
+    uint8_t kind;
+    uint8_t level;
+    bool command; // a response or timeout, so cmd_type and cmd_status mean something
+};
+
+class log_store
+{
+public:
+    enum record_kind
+    {
+        KIND_NOTIFICATION,
+        KIND_MESSAGE
+    };
+
+    static const size_t default_capacity = 1 << 20;
+    static const size_t default_text_capacity = 16 << 20;
+    static const size_t max_inbox = 1 << 16;
+
+    log_store(size_t capacity = default_capacity, size_t text_capacity = default_text_capacity);
+    virtual ~log_store();
+
+    /**
+     * Queues a log message; safe from any thread.
+     */
+    void post_message(uint8_t level, const char *text, uint64_t time_ms);
+
+    size_t drain();
+
+    /**
+     * command says whether the notification carries a command, which only
+     * the caller knows; only those feed the command and status filters.
+     */
+    void add_notification(const notification_record &record, bool command, uint8_t level, uint64_t time_ms);
+
+    uint64_t get_first_seq() const { return m_end_seq - m_records.size(); }
+    uint64_t get_end_seq() const { return m_end_seq; }
+    const log_record & get(uint64_t seq) const { return m_records[seq % m_capacity]; }
+
+    /**
+     * Copies a message's text; false once the text ring has overwritten it.
+     */
+    bool get_text(const log_record &record, std::string &text) const;
+
+    const std::set<uint16_t> & get_cmd_types() const { return m_cmd_types; }
+    const std::set<uint32_t> & get_statuses() const { return m_statuses; }
+
+private:
+    struct posted_message
+    {
+        uint8_t level;
+        uint64_t time_ms;
+        std::string text;
+    };
+
+    void append(const log_record &record);
+    void append_message(uint8_t level, uint64_t time_ms, const std::string &text);
+
+    size_t m_capacity;
+    std::vector<log_record> m_records;
+    uint64_t m_end_seq;
+
+    std::vector<char> m_text;
+    uint64_t m_text_end;
+
+    std::set<uint16_t> m_cmd_types;
+    std::set<uint32_t> m_statuses;
+
+    std::mutex m_inbox_lock;
+    std::vector<posted_message> m_inbox;
+    size_t m_inbox_dropped;
+    uint8_t m_inbox_dropped_level;
+};
+
+struct log_filter
+{
+    static const int any = -1;
+
+    uint8_t max_level;
+    bool any_entity;
+    uint64_t entity_id;
+    int cmd_type;       // any, or the command type to keep
+    int64_t cmd_status; // any, or the status to keep
+
+    log_filter();
+    bool matches(const log_record &record) const;
+};
+
+class log_view
+{
+public:
+    log_view();
+    virtual ~log_view();
+
+    void set_filter(const log_store &store, const log_filter &filter);
+    const log_filter & get_filter() const { return m_filter; }
+
+    /**
+     * Forgets records the store has dropped and checks only the records
+     * added since the last call. Returns true if the view changed.
+     */
+    bool update(const log_store &store);
+
+    size_t size() const { return m_matches.size(); }
+    uint64_t at(size_t row) const { return m_matches[row]; }
+
+private:
+    log_filter m_filter;
+    std::deque<uint64_t> m_matches;
+    uint64_t m_scanned_seq;
+};
@@ -22,46 +22,39 @@
  */
 
 /**
- * stream_configuration.cpp
+ * mapped_file.h
  *
+ * Read-only memory mapping of a whole file.
  */
 
-#include <iostream>
-#include "stream_configuration.h"
+#pragma once
 
+#include <cstdint>
+#include <string>
 
-stream_configuration::stream_configuration(unsigned int stream_input_count, unsigned int stream_output_count)
+class mapped_file
 {
-    m_stream_input_count = stream_input_count;
-    m_stream_output_count = stream_output_count;
-}
-stream_configuration::~stream_configuration() {}
-
-unsigned int stream_configuration::get_stream_input_count()
-{
-    return m_stream_input_count;
-}
-
-unsigned int stream_configuration::get_stream_output_count()
-{
-    return m_stream_output_count;
-}
-
-int stream_configuration::get_stream_input_details_by_index(unsigned int index, struct stream_configuration_details &stream_details)
-{
-    if (index >= m_stream_input_count)
-        return -1;
-    
-    stream_details = input_stream_config.at(index);
-    return 0;
-}
-
-int stream_configuration::get_stream_output_details_by_index(unsigned int index, struct stream_configuration_details &stream_details)
-{
-    if (index >= m_stream_output_count)
-        return -1;
-    
-    stream_details = output_stream_config.at(index);
-    return 0;
-}
-
+public:
+    mapped_file();
+    virtual ~mapped_file();
+
+    int open(const std::string &path);
+    void close();
+
+    bool is_open() const { return m_data != NULL; }
+    const uint8_t * data() const { return m_data; }
+    uint64_t size() const { return m_size; }
+
+private:
+    mapped_file(const mapped_file &);
+    mapped_file & operator=(const mapped_file &);
+
+    const uint8_t *m_data;
+    uint64_t m_size;
+#ifdef _WIN32
+    void *m_file;
+    void *m_mapping;
+#else
+    int m_fd;
+#endif
+};
@@ -23,52 +23,152 @@
 
 
 
-extern "C" void notification_callback(void *user_obj, int32_t notification_type, uint64_t entity_id, uint16_t cmd_type,
-                                      uint16_t desc_type, uint16_t desc_index, uint32_t cmd_status,
-                                      void *notification_id)
+/*
+ * Notifications are coalesced on the callback thread and drained by the
+ * GUI thread, so bursts of identical notifications are handled once.
+ */
+static const uint32_t notification_coalesce_window_ms = 50;
+notification_coalescer coalesced_notifications(notification_coalesce_window_ms);
+
+/*
+ * Commands sent without blocking are completed straight from the callback
+ * thread; the notification is still coalesced for logging.
+ */
+pending_command_table pending_commands;
+
+/*
+ * The widget's entity table. The notification timer re-reads an entity
+ * once per coalesce window when it connected, disconnected or answered a
+ * command that changes what the table holds: descriptors read during
+ * enumeration, names, the sampling rate and stream formats.
+ */
+entity_table published_entities;
+
+static bool changes_entity_record(int32_t notification_type, uint16_t cmd_type, uint32_t cmd_status)
+{
+    if(notification_type == avdecc_lib::END_STATION_CONNECTED || notification_type == avdecc_lib::END_STATION_DISCONNECTED)
+        return true;
+    if((notification_type != avdecc_lib::RESPONSE_RECEIVED && notification_type != avdecc_lib::UNSOLICITED_RESPONSE_RECEIVED) ||
+       cmd_status != avdecc_lib::AEM_STATUS_SUCCESS)
+        return false;
+    return cmd_type == avdecc_lib::AEM_CMD_READ_DESCRIPTOR || cmd_type == avdecc_lib::AEM_CMD_SET_NAME ||
+           cmd_type == avdecc_lib::AEM_CMD_SET_SAMPLING_RATE || cmd_type == avdecc_lib::AEM_CMD_SET_STREAM_FORMAT;
+}
+
+/*
+ * History shown on the log page. Log messages arrive on the callback
+ * threads and wait in the store's inbox for the GUI thread.
+ */
+log_store event_log;
+
+/*
+ * avdecc-lib calls back with a NULL user object, so each opened interface
+ * gets its own callback slot, which tags its notifications with the
+ * interface number before they are coalesced.
+ */
+static const size_t max_callback_slots = 8;
+static uint32_t callback_interface_nums[max_callback_slots];
+
+static void handle_notification(uint32_t interface_num, int32_t notification_type, uint64_t entity_id, uint16_t cmd_type,
+                                uint16_t desc_type, uint16_t desc_index, uint32_t cmd_status, void *notification_id)
 {
-    if(notification_type == avdecc_lib::COMMAND_TIMEOUT || notification_type == avdecc_lib::RESPONSE_RECEIVED)
+    trace_log::set_thread_name("avdecc-lib callback");
+    TRACE_SPAN_ARG("callback", "notification_callback", (uint64_t)(intptr_t)notification_id);
+
+    notification_record record = notification_record();
+    record.notification_type = notification_type;
+    record.entity_id = entity_id;
+    record.cmd_type = cmd_type;
+    record.desc_type = desc_type;
+    record.desc_index = desc_index;
+    record.cmd_status = cmd_status;
+    record.notification_id = notification_id;
+    record.interface_num = interface_num;
+    record.repeat_count = 1;
+    record.first_ms = notification_coalescer::now_ms();
+    record.last_ms = record.first_ms;
+
+    if(notification_id && (notification_type == avdecc_lib::RESPONSE_RECEIVED ||
+                           notification_type == avdecc_lib::COMMAND_TIMEOUT))
+    {
+        pending_commands.complete(record);
+    }
+
+    coalesced_notifications.post(record);
+}
+
+template<size_t slot>
+void slot_notification_callback(void *user_obj, int32_t notification_type, uint64_t entity_id, uint16_t cmd_type,
+                                uint16_t desc_type, uint16_t desc_index, uint32_t cmd_status, void *notification_id)
+{
+    (void)user_obj;
+    handle_notification(callback_interface_nums[slot], notification_type, entity_id, cmd_type,
+                        desc_type, desc_index, cmd_status, notification_id);
+}
+
+static const avdecc_notification_callback notification_callbacks[max_callback_slots] =
+{
+    slot_notification_callback<0>, slot_notification_callback<1>, slot_notification_callback<2>, slot_notification_callback<3>,
+    slot_notification_callback<4>, slot_notification_callback<5>, slot_notification_callback<6>, slot_notification_callback<7>
+};
+
+void log_notification(const notification_record &record)
+{
+    char repeat[16] = "";
+    if(record.repeat_count > 1)
+    {
+        snprintf(repeat, sizeof(repeat), " x%u", record.repeat_count);
+    }
+
+    if(record.notification_type == avdecc_lib::COMMAND_TIMEOUT || record.notification_type == avdecc_lib::RESPONSE_RECEIVED ||
+       record.notification_type == avdecc_lib::UNSOLICITED_RESPONSE_RECEIVED)
     {
         const char *cmd_name;
         const char *desc_name;
         const char *cmd_status_name;
         
-        if(cmd_type < avdecc_lib::CMD_LOOKUP)
+        if(record.cmd_type < avdecc_lib::CMD_LOOKUP)
         {
-            cmd_name = avdecc_lib::utility::aem_cmd_value_to_name(cmd_type);
-            desc_name = avdecc_lib::utility::aem_desc_value_to_name(desc_type);
-            cmd_status_name = avdecc_lib::utility::aem_cmd_status_value_to_name(cmd_status);
+            cmd_name = avdecc_lib::utility::aem_cmd_value_to_name(record.cmd_type);
+            desc_name = avdecc_lib::utility::aem_desc_value_to_name(record.desc_type);
+            cmd_status_name = avdecc_lib::utility::aem_cmd_status_value_to_name(record.cmd_status);
         }
         else
         {
-            cmd_name = avdecc_lib::utility::acmp_cmd_value_to_name(cmd_type - avdecc_lib::CMD_LOOKUP);
+            cmd_name = avdecc_lib::utility::acmp_cmd_value_to_name(record.cmd_type - avdecc_lib::CMD_LOOKUP);
             desc_name = "NULL";
-            cmd_status_name = avdecc_lib::utility::acmp_cmd_status_value_to_name(cmd_status);
+            cmd_status_name = avdecc_lib::utility::acmp_cmd_status_value_to_name(record.cmd_status);
         }
         
-        printf("\n[NOTIFICATION] (%s, 0x%"  PRIx64 ", %s, %s, %d, %s, %p)\n",
-               avdecc_lib::utility::notification_value_to_name(notification_type),
-               entity_id,
+        console_log::line("\n[NOTIFICATION] (%s, 0x%"  PRIx64 ", %s, %s, %d, %s, %p)%s",
+               avdecc_lib::utility::notification_value_to_name(record.notification_type),
+               record.entity_id,
                cmd_name,
                desc_name,
-               desc_index,
+               record.desc_index,
                cmd_status_name,
-               notification_id);
+               record.notification_id,
+               repeat);
     }
     else
     {
-        printf("\n[NOTIFICATION] (%s, 0x%"  PRIx64 ", %d, %d, %d, %d, %p)\n",
-               avdecc_lib::utility::notification_value_to_name(notification_type),
-               entity_id,
-               cmd_type,
-               desc_type,
-               desc_index,
-               cmd_status,
-               notification_id);
+        console_log::line("\n[NOTIFICATION] (%s, 0x%"  PRIx64 ", %d, %d, %d, %d, %p)%s",
+               avdecc_lib::utility::notification_value_to_name(record.notification_type),
+               record.entity_id,
+               record.cmd_type,
+               record.desc_type,
+               record.desc_index,
+               record.cmd_status,
+               record.notification_id,
+               repeat);
     }
 }
 
 extern "C" void log_callback(void *user_obj, int32_t log_level, const char *log_msg, int32_t time_stamp_ms)
 {
-    printf("\n[LOG] %s (%s)\n", avdecc_lib::utility::logging_level_value_to_name(log_level), log_msg);
+    trace_log::set_thread_name("avdecc-lib callback");
+    TRACE_SPAN("callback", "log_callback");
+
+    console_log::line("\n[LOG] %s (%s)", avdecc_lib::utility::logging_level_value_to_name(log_level), log_msg);
+    event_log.post_message((uint8_t)log_level, log_msg, notification_coalescer::now_ms());
 }
@@ -0,0 +1,116 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * notification_coalescer.h
+ *
+ * Merges bursts of identical avdecc-lib notifications. The callback thread
+ * posts every notification; duplicates arriving within the window of the
+ * first one collapse into a single record that keeps the latest state and a
+ * repeat count. The GUI thread drains records whose window has closed.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+struct notification_record
+{
+    int32_t notification_type;
+    uint64_t entity_id;
+    uint16_t cmd_type;
+    uint16_t desc_type;
+    uint16_t desc_index;
+    uint32_t cmd_status;
+    void *notification_id;
+    uint32_t interface_num; // the NIC the notification came in on, 0 if made up locally
+    uint32_t repeat_count;
+    uint64_t first_ms;
+    uint64_t last_ms;
+};
+
+/*
+ * notification_type and cmd_status of a record made up for a command that
+ * could not be sent. Neither is a value avdecc-lib reports, so such a record
+ * never reads as a response or as success. Every record made up for a
+ * failed send carries both.
+ */
+static const int32_t send_failed_notification = -1;
+static const uint32_t send_failed_status = 0xffffffff;
+
+class notification_coalescer
+{
+public:
+    notification_coalescer(uint32_t window_ms);
+    virtual ~notification_coalescer();
+
+    void post(int32_t notification_type, uint64_t entity_id, uint16_t cmd_type,
+              uint16_t desc_type, uint16_t desc_index, uint32_t cmd_status,
+              void *notification_id);
+    void post(const notification_record &record);
+
+    size_t flush(std::vector<notification_record> &records);
+    size_t flush_all(std::vector<notification_record> &records);
+
+    uint64_t get_posted_count();
+    uint64_t get_delivered_count();
+
+    static uint64_t now_ms();
+
+private:
+    struct record_key
+    {
+        int32_t notification_type;
+        uint64_t entity_id;
+        uint16_t cmd_type;
+        uint16_t desc_type;
+        uint16_t desc_index;
+        void *notification_id;
+        uint32_t interface_num;
+
+        bool operator==(const record_key &other) const
+        {
+            return notification_type == other.notification_type && entity_id == other.entity_id &&
+                   cmd_type == other.cmd_type && desc_type == other.desc_type &&
+                   desc_index == other.desc_index && notification_id == other.notification_id &&
+                   interface_num == other.interface_num;
+        }
+    };
+
+    struct record_key_hash
+    {
+        size_t operator()(const record_key &key) const;
+    };
+
+    size_t flush_before(uint64_t deadline_ms, std::vector<notification_record> &records);
+
+    std::mutex m_lock;
+    std::unordered_map<record_key, size_t, record_key_hash> m_index;
+    std::vector<notification_record> m_pending;
+    uint32_t m_window_ms;
+    uint64_t m_posted_count;
+    uint64_t m_delivered_count;
+};
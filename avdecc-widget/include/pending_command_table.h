@@ -0,0 +1,55 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * pending_command_table.h
+ *
+ * Commands sent without blocking register a completion here under their
+ * notification ID. handle_notification completes them from the avdecc-lib
+ * callback thread when the response or timeout arrives.
+ */
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include "notification_coalescer.h"
+
+class pending_command_table
+{
+public:
+    typedef std::function<void(const notification_record &record)> completion;
+
+    pending_command_table();
+    virtual ~pending_command_table();
+
+    void add(void *notification_id, const completion &on_complete);
+    bool complete(const notification_record &record);
+    bool cancel(void *notification_id);
+    size_t size();
+
+private:
+    std::mutex m_lock;
+    std::unordered_map<void *, completion> m_pending;
+};
@@ -0,0 +1,130 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * rollout_panel.h
+ *
+ * Rollout page: one virtual list row per target end station with its wave,
+ * stage, upload progress and the firmware version read back after the
+ * update, plus the rollout setup dialog that picks targets by entity model
+ * and current firmware version.
+ */
+
+#pragma once
+
+#include <functional>
+#include <vector>
+#include "wx/panel.h"
+#include "wx/dialog.h"
+#include "wx/listctrl.h"
+#include "wx/button.h"
+#include "wx/choice.h"
+#include "wx/filepicker.h"
+#include "wx/spinctrl.h"
+#include "wx/stattext.h"
+#include "wx/textctrl.h"
+#include "firmware_rollout.h"
+
+struct rollout_candidate
+{
+    uint64_t entity_id;
+    uint64_t entity_model_id;
+    wxString name;
+    wxString firmware_version;
+};
+
+class rollout_dialog : public wxDialog
+{
+public:
+    rollout_dialog(wxWindow *parent, const std::vector<rollout_candidate> &candidates);
+    virtual ~rollout_dialog();
+
+    void get_targets(std::vector<uint64_t> &targets) const;
+    wxString get_image_path() const;
+    wxString get_target_version() const;
+    void get_options(rollout_options &options) const;
+
+    void OnModel(wxCommandEvent& event);
+    void OnVersion(wxCommandEvent& event);
+
+private:
+    void update_versions();
+    void update_selection();
+
+    const std::vector<rollout_candidate> &m_candidates;
+    std::vector<uint64_t> m_models;
+    wxChoice *m_model;
+    wxChoice *m_version;
+    wxStaticText *m_selection;
+    wxFilePickerCtrl *m_image;
+    wxTextCtrl *m_target_version;
+    wxSpinCtrl *m_parallelism;
+    wxSpinCtrl *m_first_wave;
+    wxSpinCtrl *m_wave_size;
+    wxSpinCtrl *m_max_failures;
+};
+
+class rollout_list : public wxListCtrl
+{
+public:
+    typedef std::function<wxString(uint64_t entity_id)> name_formatter;
+
+    rollout_list(wxWindow *parent, const firmware_rollout *rollout);
+    virtual ~rollout_list();
+
+    void set_formatter(const name_formatter &format_name);
+
+protected:
+    virtual wxString OnGetItemText(long item, long column) const;
+
+private:
+    const firmware_rollout *m_rollout;
+    name_formatter m_format_name;
+};
+
+class rollout_panel : public wxPanel
+{
+public:
+    typedef std::function<void()> action_handler;
+
+    rollout_panel(wxWindow *parent, const firmware_rollout *rollout);
+    virtual ~rollout_panel();
+
+    void set_handlers(const action_handler &on_start, const action_handler &on_abort);
+    void set_formatter(const rollout_list::name_formatter &format_name);
+    void refresh_devices();
+    void refresh_device(size_t index);
+    void set_status(const wxString &status);
+
+    void OnStart(wxCommandEvent& event);
+    void OnAbort(wxCommandEvent& event);
+
+private:
+    const firmware_rollout *m_rollout;
+    wxButton *m_start;
+    wxButton *m_abort;
+    wxStaticText *m_status;
+    rollout_list *m_list;
+    action_handler m_on_start;
+    action_handler m_on_abort;
+};
@@ -0,0 +1,75 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * string_pool.h
+ *
+ * Process-wide interned string storage. Each distinct string is stored once
+ * and referred to by a small integer handle; handle 0 is the empty string.
+ * Pooled strings never move or die, so get() needs no lock. Storage grows
+ * in chunks through a two-level directory that covers every 32-bit handle,
+ * so the pool never runs out before memory does.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <wx/string.h>
+
+class string_pool
+{
+public:
+    typedef uint32_t handle;
+
+    static handle intern(const char *utf8);
+    static handle intern(const wxString &str);
+
+    static const wxString & get(handle h)
+    {
+        return m_directories[h >> directory_shift][(h >> chunk_bits) & (directory_size - 1)][h & (chunk_size - 1)];
+    }
+
+    static size_t size();
+
+private:
+    enum
+    {
+        chunk_bits = 10,
+        chunk_size = 1 << chunk_bits,
+        directory_bits = 10,
+        directory_size = 1 << directory_bits,
+        directory_shift = chunk_bits + directory_bits,
+        max_directories = 1 << (32 - directory_shift)
+    };
+
+    static wxString ** first_directory();
+    static handle intern_locked(const std::string &key, const wxString &str);
+
+    static std::mutex m_lock;
+    static std::unordered_map<std::string, handle> m_index;
+    static wxString **m_directories[max_directories];
+    static handle m_next;
+};
@@ -0,0 +1,104 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * trace_log.h
+ *
+ * Optional Chrome/Perfetto trace-event recorder. Spans are appended to
+ * bounded per-thread buffers and written as trace-event JSON on exit or on
+ * demand; writing or disabling empties the buffers. When tracing is off a
+ * span costs one relaxed atomic load.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class trace_log
+{
+public:
+    static bool enabled()
+    {
+        return m_enabled.load(std::memory_order_relaxed);
+    }
+
+    static void enable(const std::string &output_path);
+    static void disable();
+    static std::string output_path();
+
+    static uint64_t now_us();
+    static void set_thread_name(const char *name);
+    static void record_complete(const char *category, const char *name,
+                                uint64_t start_us, uint64_t duration_us, uint64_t arg);
+    static void record_instant(const char *category, const char *name, uint64_t arg);
+
+    static int write();
+    static int write(const std::string &path);
+
+private:
+    static std::atomic<bool> m_enabled;
+};
+
+class trace_span
+{
+public:
+    trace_span(const char *category, const char *name, uint64_t arg = 0)
+    : m_category(category), m_name(name), m_arg(arg), m_start_us(0), m_active(trace_log::enabled())
+    {
+        if(m_active)
+            m_start_us = trace_log::now_us();
+    }
+
+    ~trace_span()
+    {
+        end();
+    }
+
+    void set_arg(uint64_t arg) { m_arg = arg; }
+
+    void end()
+    {
+        if(m_active)
+        {
+            trace_log::record_complete(m_category, m_name, m_start_us, trace_log::now_us() - m_start_us, m_arg);
+            m_active = false;
+        }
+    }
+
+private:
+    trace_span(const trace_span &);
+    trace_span & operator=(const trace_span &);
+
+    const char *m_category;
+    const char *m_name;
+    uint64_t m_arg;
+    uint64_t m_start_us;
+    bool m_active;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SPAN(category, name) trace_span TRACE_CONCAT(trace_span_, __LINE__)(category, name)
+#define TRACE_SPAN_ARG(category, name, arg) trace_span TRACE_CONCAT(trace_span_, __LINE__)(category, name, arg)
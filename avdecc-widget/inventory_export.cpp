@@ -0,0 +1,226 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * inventory_export.cpp
+ *
+ */
+
+#include <chrono>
+#include <cstring>
+#include <inttypes.h>
+#include "inventory_export.h"
+
+static const size_t export_buffer_size = 256 * 1024;
+
+static void write_csv_field(FILE *file, const wxString &text)
+{
+    wxScopedCharBuffer utf8 = text.utf8_str();
+    const char *s = utf8.data();
+    if(!strpbrk(s, ",\"\r\n"))
+    {
+        fputs(s, file);
+        return;
+    }
+
+    fputc('"', file);
+    for(; *s; s++)
+    {
+        if(*s == '"')
+            fputc('"', file);
+        fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+static void write_json_string(FILE *file, const wxString &text)
+{
+    wxScopedCharBuffer utf8 = text.utf8_str();
+    fputc('"', file);
+    for(const unsigned char *s = (const unsigned char *)utf8.data(); *s; s++)
+    {
+        if(*s == '"' || *s == '\\')
+            fprintf(file, "\\%c", *s);
+        else if(*s < 0x20)
+            fprintf(file, "\\u%04x", *s);
+        else
+            fputc(*s, file);
+    }
+    fputc('"', file);
+}
+
+static bool write_csv(const inventory_snapshot &snapshot, FILE *file)
+{
+    fputs("entity_id,name,mac,firmware_version,sample_rate,direction,stream_index,stream_name,stream_format\n", file);
+
+    for(size_t i = 0; i < snapshot.entities.size(); i++)
+    {
+        const inventory_entity &entity = snapshot.entities[i];
+        size_t rows = entity.stream_count ? entity.stream_count : 1;
+
+        for(size_t j = 0; j < rows; j++)
+        {
+            fprintf(file, "0x%016" PRIx64 ",", entity.entity_id);
+            write_csv_field(file, string_pool::get(entity.name));
+            fprintf(file, ",%012" PRIx64 ",", entity.mac);
+            write_csv_field(file, string_pool::get(entity.fw_ver));
+            fprintf(file, ",%u,", entity.sample_rate);
+
+            if(entity.stream_count)
+            {
+                const inventory_stream &stream = snapshot.streams[entity.first_stream + j];
+                fprintf(file, "%s,%u,", stream.input ? "input" : "output", stream.stream_index);
+                write_csv_field(file, string_pool::get(stream.name));
+                fputc(',', file);
+                write_csv_field(file, string_pool::get(stream.format));
+            }
+            else
+            {
+                fputs(",,,", file);
+            }
+            fputc('\n', file);
+        }
+    }
+    return !ferror(file);
+}
+
+static bool write_json(const inventory_snapshot &snapshot, FILE *file)
+{
+    fputs("[\n", file);
+
+    for(size_t i = 0; i < snapshot.entities.size(); i++)
+    {
+        const inventory_entity &entity = snapshot.entities[i];
+
+        fprintf(file, "  {\"entity_id\": \"0x%016" PRIx64 "\", \"name\": ", entity.entity_id);
+        write_json_string(file, string_pool::get(entity.name));
+        fprintf(file, ", \"mac\": \"%012" PRIx64 "\", \"firmware_version\": ", entity.mac);
+        write_json_string(file, string_pool::get(entity.fw_ver));
+        fprintf(file, ", \"sample_rate\": %u, \"streams\": [", entity.sample_rate);
+
+        for(size_t j = 0; j < entity.stream_count; j++)
+        {
+            const inventory_stream &stream = snapshot.streams[entity.first_stream + j];
+            fprintf(file, "%s{\"direction\": \"%s\", \"index\": %u, \"name\": ", j ? ", " : "",
+                    stream.input ? "input" : "output", stream.stream_index);
+            write_json_string(file, string_pool::get(stream.name));
+            fputs(", \"format\": ", file);
+            write_json_string(file, string_pool::get(stream.format));
+            fputc('}', file);
+        }
+        fprintf(file, "]}%s\n", i + 1 < snapshot.entities.size() ? "," : "");
+    }
+
+    fputs("]\n", file);
+    return !ferror(file);
+}
+
+inventory_writer::inventory_writer() : m_busy(false) {}
+
+inventory_writer::~inventory_writer()
+{
+    if(m_thread.joinable())
+        m_thread.join();
+}
+
+bool inventory_writer::start(const std::shared_ptr<const entity_table::version> &entities, const std::string &path,
+                             inventory_format format, const completion &done)
+{
+    if(m_busy.exchange(true))
+        return false;
+
+    if(m_thread.joinable())
+        m_thread.join();
+
+    m_thread = std::thread(&inventory_writer::run, this, entities, path, format, done);
+    return true;
+}
+
+bool inventory_writer::is_busy() const
+{
+    return m_busy.load();
+}
+
+/*
+ * Published versions are immutable, so this needs no lock however long it
+ * takes.
+ */
+void inventory_writer::take_snapshot(const entity_table::version &entities, inventory_snapshot &snapshot)
+{
+    snapshot.entities.reserve(entities.size());
+
+    for(size_t slot = 0; slot < entities.size(); slot++)
+    {
+        const entity_record &record = entities.at(slot);
+
+        inventory_entity entity;
+        entity.entity_id = record.entity_id;
+        entity.mac = record.mac;
+        entity.name = record.name;
+        entity.fw_ver = record.fw_ver;
+        entity.sample_rate = record.sample_rate;
+        entity.first_stream = (uint32_t)snapshot.streams.size();
+        entity.stream_count = (uint32_t)record.streams.size();
+
+        for(size_t i = 0; i < record.streams.size(); i++)
+        {
+            inventory_stream stream;
+            stream.input = record.streams[i].input;
+            stream.stream_index = record.streams[i].stream_index;
+            stream.name = record.streams[i].name;
+            stream.format = record.streams[i].format;
+            snapshot.streams.push_back(stream);
+        }
+
+        snapshot.entities.push_back(entity);
+    }
+}
+
+bool inventory_writer::write(const inventory_snapshot &snapshot, FILE *file, inventory_format format)
+{
+    return format == INVENTORY_JSON ? write_json(snapshot, file) : write_csv(snapshot, file);
+}
+
+void inventory_writer::run(std::shared_ptr<const entity_table::version> entities, std::string path, inventory_format format,
+                           completion done)
+{
+    std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+    bool ok = false;
+
+    inventory_snapshot snapshot;
+    take_snapshot(*entities, snapshot);
+    entities.reset();
+
+    FILE *file = fopen(path.c_str(), "wb");
+    if(file)
+    {
+        setvbuf(file, NULL, _IOFBF, export_buffer_size);
+        ok = write(snapshot, file, format);
+        ok = (fclose(file) == 0) && ok;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    m_busy.store(false);
+    if(done)
+        done(ok, snapshot.entities.size(), seconds);
+}
@@ -0,0 +1,183 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * listener_state_poller.cpp
+ *
+ */
+
+#include <map>
+#include "listener_state_poller.h"
+
+listener_state_poller::listener_state_poller(uint32_t refresh_interval_ms)
+{
+    m_refresh_interval_ms = refresh_interval_ms ? refresh_interval_ms : 1;
+    m_cycle_start_ms = 0;
+    m_next_group = 0;
+}
+
+listener_state_poller::~listener_state_poller() {}
+
+/*
+ * The cycle in progress carries on over the new list, so entities found
+ * during discovery do not keep restarting it from the first group.
+ */
+void listener_state_poller::set_listeners(const std::vector<stream_endpoint> &listeners)
+{
+    std::map<uint64_t, size_t> group_of;
+    m_groups.clear();
+
+    for(size_t i = 0; i < listeners.size(); i++)
+    {
+        std::map<uint64_t, size_t>::iterator it = group_of.find(listeners[i].entity_id);
+        if(it == group_of.end())
+        {
+            entity_group group;
+            group.entity_id = listeners[i].entity_id;
+            it = group_of.insert(std::make_pair(group.entity_id, m_groups.size())).first;
+            m_groups.push_back(group);
+        }
+        m_groups[it->second].stream_indexes.push_back(listeners[i].stream_index);
+    }
+
+    if(m_next_group > m_groups.size())
+        m_next_group = m_groups.size();
+}
+
+void listener_state_poller::set_refresh_interval(uint32_t refresh_interval_ms)
+{
+    m_refresh_interval_ms = refresh_interval_ms ? refresh_interval_ms : 1;
+}
+
+void listener_state_poller::tick(uint64_t now_ms, const request_handler &request)
+{
+    if(m_groups.empty())
+        return;
+
+    if(m_cycle_start_ms == 0)
+    {
+        m_cycle_start_ms = now_ms;
+        m_next_group = 0;
+    }
+
+    uint64_t elapsed = now_ms - m_cycle_start_ms;
+    size_t due = m_groups.size();
+    if(elapsed < m_refresh_interval_ms)
+    {
+        due = (size_t)((elapsed * m_groups.size()) / m_refresh_interval_ms) + 1;
+        if(due > m_groups.size())
+            due = m_groups.size();
+    }
+
+    // all reads for one entity go out back to back
+    for(; m_next_group < due; m_next_group++)
+    {
+        const entity_group &group = m_groups[m_next_group];
+        for(size_t i = 0; i < group.stream_indexes.size(); i++)
+        {
+            acmp_command command = acmp_command();
+            command.listener.entity_id = group.entity_id;
+            command.listener.stream_index = group.stream_indexes[i];
+
+            command.type = ACMP_GET_RX_STATE;
+            request(command);
+            command.type = AEM_GET_STREAM_INFO;
+            request(command);
+        }
+    }
+
+    if(elapsed >= m_refresh_interval_ms)
+    {
+        m_cycle_start_ms = now_ms;
+        m_next_group = 0;
+    }
+}
+
+bool listener_state_poller::update_snapshot(const acmp_command &command, const listener_state &state)
+{
+    std::lock_guard<std::mutex> guard(m_snapshot_lock);
+
+    if(command.type == ACMP_GET_RX_STATE)
+    {
+        std::unordered_map<stream_endpoint, listener_state, stream_endpoint_hash>::iterator it = m_rx_snapshot.find(command.listener);
+        if(it != m_rx_snapshot.end() && it->second.connected == state.connected &&
+           it->second.talker == state.talker && it->second.connection_count == state.connection_count)
+        {
+            return false;
+        }
+        m_rx_snapshot[command.listener] = state;
+        return true;
+    }
+
+    if(command.type == AEM_GET_STREAM_INFO)
+    {
+        std::unordered_map<stream_endpoint, listener_state, stream_endpoint_hash>::iterator it = m_info_snapshot.find(command.listener);
+        if(it != m_info_snapshot.end() && it->second.stream_info_flags == state.stream_info_flags &&
+           it->second.stream_format == state.stream_format && it->second.stream_id == state.stream_id)
+        {
+            return false;
+        }
+        m_info_snapshot[command.listener] = state;
+        return true;
+    }
+
+    return true;
+}
+
+void listener_state_poller::invalidate(const stream_endpoint &listener)
+{
+    std::lock_guard<std::mutex> guard(m_snapshot_lock);
+    m_rx_snapshot.erase(listener);
+    m_info_snapshot.erase(listener);
+}
+
+void listener_state_poller::forget(uint64_t entity_id)
+{
+    for(size_t i = 0; i < m_groups.size(); i++)
+    {
+        if(m_groups[i].entity_id == entity_id)
+        {
+            m_groups.erase(m_groups.begin() + i);
+            if(i < m_next_group)
+                m_next_group--;
+            break;
+        }
+    }
+
+    std::lock_guard<std::mutex> guard(m_snapshot_lock);
+
+    for(std::unordered_map<stream_endpoint, listener_state, stream_endpoint_hash>::iterator it = m_rx_snapshot.begin(); it != m_rx_snapshot.end();)
+    {
+        if(it->first.entity_id == entity_id)
+            it = m_rx_snapshot.erase(it);
+        else
+            ++it;
+    }
+    for(std::unordered_map<stream_endpoint, listener_state, stream_endpoint_hash>::iterator it = m_info_snapshot.begin(); it != m_info_snapshot.end();)
+    {
+        if(it->first.entity_id == entity_id)
+            it = m_info_snapshot.erase(it);
+        else
+            ++it;
+    }
+}
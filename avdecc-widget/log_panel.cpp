@@ -0,0 +1,220 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * log_panel.cpp
+ *
+ */
+
+#include <stdlib.h>
+#include <algorithm>
+#include <set>
+#include "wx/sizer.h"
+#include "log_panel.h"
+
+log_list::log_list(wxWindow *parent, const log_store *store, const log_view *view)
+: wxListCtrl(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VIRTUAL)
+{
+    m_store = store;
+    m_view = view;
+
+    InsertColumn(0, wxT("Time"), wxLIST_FORMAT_RIGHT, 80);
+    InsertColumn(1, wxT("Level"), wxLIST_FORMAT_LEFT, 70);
+    InsertColumn(2, wxT("Entity ID"), wxLIST_FORMAT_LEFT, 150);
+    InsertColumn(3, wxT("Notification"), wxLIST_FORMAT_LEFT, 170);
+    InsertColumn(4, wxT("Command"), wxLIST_FORMAT_LEFT, 170);
+    InsertColumn(5, wxT("Descriptor"), wxLIST_FORMAT_LEFT, 140);
+    InsertColumn(6, wxT("Status"), wxLIST_FORMAT_LEFT, 110);
+    InsertColumn(7, wxT("Message"), wxLIST_FORMAT_LEFT, 300);
+}
+
+log_list::~log_list() {}
+
+void log_list::set_formatter(const cell_formatter &format_cell)
+{
+    m_format_cell = format_cell;
+}
+
+wxString log_list::OnGetItemText(long item, long column) const
+{
+    if(item < 0 || (size_t)item >= m_view->size() || !m_format_cell)
+        return wxEmptyString;
+
+    return m_format_cell(m_store->get(m_view->at(item)), column);
+}
+
+log_panel::log_panel(wxWindow *parent, const log_store *store, uint8_t level_count)
+: wxPanel(parent, wxID_ANY)
+{
+    m_store = store;
+    m_level_count = level_count;
+    m_counted_seq = 0;
+
+    m_level = new wxChoice(this, wxID_ANY);
+    m_entity = new wxTextCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(150, -1));
+    m_entity->SetHint(wxT("Entity ID"));
+    m_command = new wxChoice(this, wxID_ANY);
+    m_command->Append(wxT("Any command"));
+    m_command->SetSelection(0);
+    m_status = new wxChoice(this, wxID_ANY);
+    m_status->Append(wxT("Any status"));
+    m_status->SetSelection(0);
+    m_follow = new wxCheckBox(this, wxID_ANY, wxT("Follow"));
+    m_follow->SetValue(true);
+    m_count = new wxStaticText(this, wxID_ANY, wxEmptyString);
+    m_list = new log_list(this, store, &m_view);
+
+    wxBoxSizer *header_sizer = new wxBoxSizer(wxHORIZONTAL);
+    header_sizer->Add(m_level, 0, wxALIGN_CENTER_VERTICAL);
+    header_sizer->Add(m_entity, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 5);
+    header_sizer->Add(m_command, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 5);
+    header_sizer->Add(m_status, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 5);
+    header_sizer->Add(m_follow, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 10);
+    header_sizer->Add(m_count, 1, wxALIGN_CENTER_VERTICAL | wxLEFT, 10);
+
+    wxBoxSizer *sizer = new wxBoxSizer(wxVERTICAL);
+    sizer->Add(header_sizer, 0, wxGROW);
+    sizer->Add(m_list, 1, wxGROW);
+    SetSizer(sizer);
+
+    m_level->Bind(wxEVT_CHOICE, &log_panel::OnFilter, this);
+    m_entity->Bind(wxEVT_TEXT, &log_panel::OnFilter, this);
+    m_command->Bind(wxEVT_CHOICE, &log_panel::OnFilter, this);
+    m_status->Bind(wxEVT_CHOICE, &log_panel::OnFilter, this);
+}
+
+log_panel::~log_panel() {}
+
+void log_panel::set_formatters(const log_list::cell_formatter &format_cell, const level_formatter &format_level,
+                               const command_formatter &format_command, const status_formatter &format_status)
+{
+    m_list->set_formatter(format_cell);
+    m_format_command = format_command;
+    m_format_status = format_status;
+
+    // entry n keeps records up to level n, the most verbose being everything
+    m_level->Clear();
+    for(uint8_t level = 0; level < m_level_count; level++)
+    {
+        m_level->Append(wxString::Format(wxT("Up to %s"), format_level(level)));
+    }
+    m_level->SetSelection(m_level_count - 1);
+    apply_filter();
+}
+
+void log_panel::refresh_records()
+{
+    update_choices();
+
+    uint64_t first = m_view.size() ? m_view.at(0) : 0;
+    if(m_store->get_end_seq() != m_counted_seq)
+    {
+        update_count();
+    }
+    if(!m_view.update(*m_store))
+        return;
+
+    m_list->SetItemCount(m_view.size());
+    if(m_follow->IsChecked() && m_view.size())
+    {
+        m_list->EnsureVisible(m_view.size() - 1);
+    }
+    // rows only shift when old records were dropped; otherwise only new rows need drawing
+    if(!m_view.size() || m_view.at(0) != first)
+    {
+        m_list->Refresh();
+    }
+}
+
+void log_panel::OnFilter(wxCommandEvent& WXUNUSED(event))
+{
+    apply_filter();
+}
+
+void log_panel::apply_filter()
+{
+    log_filter filter;
+    if(m_level->GetSelection() != wxNOT_FOUND)
+        filter.max_level = (uint8_t)m_level->GetSelection();
+
+    wxString entity = m_entity->GetValue().Trim().Trim(false);
+    if(!entity.IsEmpty())
+    {
+        filter.any_entity = false;
+        filter.entity_id = strtoull(entity.mb_str(), NULL, 16);
+    }
+
+    if(m_command->GetSelection() > 0)
+        filter.cmd_type = m_cmd_types[m_command->GetSelection() - 1];
+    if(m_status->GetSelection() > 0)
+        filter.cmd_status = m_statuses[m_status->GetSelection() - 1];
+
+    m_view.set_filter(*m_store, filter);
+    m_list->SetItemCount(m_view.size());
+    m_list->Refresh();
+    if(m_follow->IsChecked() && m_view.size())
+    {
+        m_list->EnsureVisible(m_view.size() - 1);
+    }
+    update_count();
+}
+
+void log_panel::update_count()
+{
+    m_counted_seq = m_store->get_end_seq();
+    m_count->SetLabel(wxString::Format(wxT("%u of %u records"), (unsigned int)m_view.size(),
+                                       (unsigned int)(m_store->get_end_seq() - m_store->get_first_seq())));
+}
+
+/*
+ * The command and status choices list the values seen so far. Entries are
+ * only ever appended, so the current selection stays where it is.
+ */
+void log_panel::update_choices()
+{
+    const std::set<uint16_t> &cmd_types = m_store->get_cmd_types();
+    if(cmd_types.size() != m_cmd_types.size() && m_format_command)
+    {
+        for(std::set<uint16_t>::const_iterator it = cmd_types.begin(); it != cmd_types.end(); ++it)
+        {
+            if(std::find(m_cmd_types.begin(), m_cmd_types.end(), *it) == m_cmd_types.end())
+            {
+                m_cmd_types.push_back(*it);
+                m_command->Append(m_format_command(*it));
+            }
+        }
+    }
+
+    const std::set<uint32_t> &statuses = m_store->get_statuses();
+    if(statuses.size() != m_statuses.size() && m_format_status)
+    {
+        for(std::set<uint32_t>::const_iterator it = statuses.begin(); it != statuses.end(); ++it)
+        {
+            if(std::find(m_statuses.begin(), m_statuses.end(), *it) == m_statuses.end())
+            {
+                m_statuses.push_back(*it);
+                m_status->Append(m_format_status(*it));
+            }
+        }
+    }
+}
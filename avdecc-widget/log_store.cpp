@@ -0,0 +1,202 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * log_store.cpp
+ *
+ */
+
+#include <algorithm>
+#include <stdio.h>
+#include <string.h>
+#include "log_store.h"
+
+log_store::log_store(size_t capacity, size_t text_capacity)
+: m_capacity(capacity), m_end_seq(0), m_text(text_capacity), m_text_end(0), m_inbox_dropped(0), m_inbox_dropped_level(UINT8_MAX)
+{
+}
+
+log_store::~log_store() {}
+
+void log_store::post_message(uint8_t level, const char *text, uint64_t time_ms)
+{
+    std::lock_guard<std::mutex> guard(m_inbox_lock);
+    if(m_inbox.size() >= max_inbox)
+    {
+        m_inbox_dropped++;
+        m_inbox_dropped_level = std::min(m_inbox_dropped_level, level);
+        return;
+    }
+
+    posted_message message;
+    message.level = level;
+    message.time_ms = time_ms;
+    message.text = text;
+    m_inbox.push_back(message);
+}
+
+size_t log_store::drain()
+{
+    std::vector<posted_message> messages;
+    size_t dropped;
+    uint8_t dropped_level;
+    {
+        std::lock_guard<std::mutex> guard(m_inbox_lock);
+        messages.swap(m_inbox);
+        dropped = m_inbox_dropped;
+        dropped_level = m_inbox_dropped_level;
+        m_inbox_dropped = 0;
+        m_inbox_dropped_level = UINT8_MAX;
+    }
+
+    for(size_t i = 0; i < messages.size(); i++)
+    {
+        append_message(messages[i].level, messages[i].time_ms, messages[i].text);
+    }
+    if(dropped)
+    {
+        char text[64];
+        snprintf(text, sizeof(text), "%u log messages dropped", (unsigned int)dropped);
+        append_message(dropped_level, messages.empty() ? 0 : messages.back().time_ms, text);
+    }
+    return messages.size();
+}
+
+void log_store::append_message(uint8_t level, uint64_t time_ms, const std::string &text)
+{
+    size_t length = std::min(text.size(), std::min((size_t)UINT16_MAX, m_text.size()));
+
+    log_record record = log_record();
+    record.kind = KIND_MESSAGE;
+    record.level = level;
+    record.time_ms = time_ms;
+    record.text_pos = m_text_end;
+    record.text_length = (uint16_t)length;
+
+    // the text ring wraps byte by byte; older text is simply overwritten
+    for(size_t n = 0; n < length; n++)
+    {
+        m_text[(m_text_end + n) % m_text.size()] = text[n];
+    }
+    m_text_end += length;
+    append(record);
+}
+
+void log_store::add_notification(const notification_record &record, bool command, uint8_t level, uint64_t time_ms)
+{
+    log_record entry = log_record();
+    entry.kind = KIND_NOTIFICATION;
+    entry.level = level;
+    entry.time_ms = time_ms;
+    entry.entity_id = record.entity_id;
+    entry.notification_type = record.notification_type;
+    entry.cmd_type = record.cmd_type;
+    entry.desc_type = record.desc_type;
+    entry.desc_index = record.desc_index;
+    entry.cmd_status = record.cmd_status;
+    entry.repeat_count = (uint16_t)std::min(record.repeat_count, (uint32_t)UINT16_MAX);
+    entry.command = command;
+    append(entry);
+
+    if(command)
+    {
+        m_cmd_types.insert(record.cmd_type);
+        m_statuses.insert(record.cmd_status);
+    }
+}
+
+void log_store::append(const log_record &record)
+{
+    if(m_records.size() < m_capacity)
+        m_records.push_back(record);
+    else
+        m_records[m_end_seq % m_capacity] = record;
+    m_end_seq++;
+}
+
+bool log_store::get_text(const log_record &record, std::string &text) const
+{
+    text.clear();
+    if(record.kind != KIND_MESSAGE || m_text_end - record.text_pos > m_text.size())
+        return false;
+
+    text.reserve(record.text_length);
+    for(size_t n = 0; n < record.text_length; n++)
+    {
+        text += m_text[(record.text_pos + n) % m_text.size()];
+    }
+    return true;
+}
+
+log_filter::log_filter()
+: max_level(UINT8_MAX), any_entity(true), entity_id(0), cmd_type(any), cmd_status(any)
+{
+}
+
+bool log_filter::matches(const log_record &record) const
+{
+    if(record.level > max_level)
+        return false;
+    if(!any_entity && (record.kind != log_store::KIND_NOTIFICATION || record.entity_id != entity_id))
+        return false;
+    if(cmd_type != any && (!record.command || record.cmd_type != cmd_type))
+        return false;
+    if(cmd_status != any && (!record.command || record.cmd_status != cmd_status))
+        return false;
+    return true;
+}
+
+log_view::log_view() : m_scanned_seq(0) {}
+
+log_view::~log_view() {}
+
+void log_view::set_filter(const log_store &store, const log_filter &filter)
+{
+    m_filter = filter;
+    m_matches.clear();
+    m_scanned_seq = store.get_first_seq();
+    update(store);
+}
+
+bool log_view::update(const log_store &store)
+{
+    bool changed = false;
+
+    uint64_t first = store.get_first_seq();
+    while(!m_matches.empty() && m_matches.front() < first)
+    {
+        m_matches.pop_front();
+        changed = true;
+    }
+
+    for(uint64_t seq = std::max(m_scanned_seq, first); seq < store.get_end_seq(); seq++)
+    {
+        if(m_filter.matches(store.get(seq)))
+        {
+            m_matches.push_back(seq);
+            changed = true;
+        }
+    }
+    m_scanned_seq = store.get_end_seq();
+    return changed;
+}
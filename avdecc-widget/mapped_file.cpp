@@ -0,0 +1,141 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * mapped_file.cpp
+ *
+ */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "mapped_file.h"
+
+#ifdef _WIN32
+
+mapped_file::mapped_file() : m_data(NULL), m_size(0), m_file(INVALID_HANDLE_VALUE), m_mapping(NULL) {}
+
+int mapped_file::open(const std::string &path)
+{
+    close();
+
+    m_file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                         FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(m_file == INVALID_HANDLE_VALUE)
+        return -1;
+
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+    {
+        close();
+        return -1;
+    }
+
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!m_mapping)
+    {
+        close();
+        return -1;
+    }
+
+    m_data = (const uint8_t *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!m_data)
+    {
+        close();
+        return -1;
+    }
+    m_size = (uint64_t)size.QuadPart;
+    return 0;
+}
+
+void mapped_file::close()
+{
+    if(m_data)
+        UnmapViewOfFile(m_data);
+    if(m_mapping)
+        CloseHandle(m_mapping);
+    if(m_file != INVALID_HANDLE_VALUE)
+        CloseHandle(m_file);
+
+    m_data = NULL;
+    m_size = 0;
+    m_mapping = NULL;
+    m_file = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+mapped_file::mapped_file() : m_data(NULL), m_size(0), m_fd(-1) {}
+
+int mapped_file::open(const std::string &path)
+{
+    close();
+
+    m_fd = ::open(path.c_str(), O_RDONLY);
+    if(m_fd < 0)
+        return -1;
+
+    struct stat st;
+    if(fstat(m_fd, &st) != 0 || st.st_size == 0)
+    {
+        close();
+        return -1;
+    }
+
+    void *data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+    if(data == MAP_FAILED)
+    {
+        close();
+        return -1;
+    }
+
+    // the image is read front to back exactly once
+    madvise(data, (size_t)st.st_size, MADV_SEQUENTIAL);
+    m_data = (const uint8_t *)data;
+    m_size = (uint64_t)st.st_size;
+    return 0;
+}
+
+void mapped_file::close()
+{
+    if(m_data)
+        munmap((void *)m_data, (size_t)m_size);
+    if(m_fd >= 0)
+        ::close(m_fd);
+
+    m_data = NULL;
+    m_size = 0;
+    m_fd = -1;
+}
+
+#endif
+
+mapped_file::~mapped_file()
+{
+    close();
+}
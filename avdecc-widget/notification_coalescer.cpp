@@ -0,0 +1,157 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * notification_coalescer.cpp
+ *
+ */
+
+#include <chrono>
+#include <limits>
+#include "notification_coalescer.h"
+
+notification_coalescer::notification_coalescer(uint32_t window_ms)
+{
+    m_window_ms = window_ms;
+    m_posted_count = 0;
+    m_delivered_count = 0;
+}
+
+notification_coalescer::~notification_coalescer() {}
+
+uint64_t notification_coalescer::now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+size_t notification_coalescer::record_key_hash::operator()(const record_key &key) const
+{
+    uint64_t h = key.entity_id * 0x9e3779b97f4a7c15ULL;
+    h ^= ((uint64_t)(uint32_t)key.notification_type << 48) ^ ((uint64_t)key.cmd_type << 32) ^
+         ((uint64_t)key.desc_type << 16) ^ key.desc_index;
+    h ^= (uint64_t)(uintptr_t)key.notification_id * 0xff51afd7ed558ccdULL;
+    h ^= (uint64_t)key.interface_num << 56;
+    h ^= h >> 29;
+    return (size_t)h;
+}
+
+void notification_coalescer::post(int32_t notification_type, uint64_t entity_id, uint16_t cmd_type,
+                                  uint16_t desc_type, uint16_t desc_index, uint32_t cmd_status,
+                                  void *notification_id)
+{
+    notification_record record;
+    record.notification_type = notification_type;
+    record.entity_id = entity_id;
+    record.cmd_type = cmd_type;
+    record.desc_type = desc_type;
+    record.desc_index = desc_index;
+    record.cmd_status = cmd_status;
+    record.notification_id = notification_id;
+    record.interface_num = 0;
+    record.repeat_count = 1;
+    record.first_ms = now_ms();
+    record.last_ms = record.first_ms;
+    post(record);
+}
+
+void notification_coalescer::post(const notification_record &record)
+{
+    record_key key = {record.notification_type, record.entity_id, record.cmd_type,
+                      record.desc_type, record.desc_index, record.notification_id, record.interface_num};
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_posted_count += record.repeat_count;
+
+    std::unordered_map<record_key, size_t, record_key_hash>::iterator it = m_index.find(key);
+    if(it == m_index.end())
+    {
+        m_index.insert(std::make_pair(key, m_pending.size()));
+        m_pending.push_back(record);
+    }
+    else
+    {
+        notification_record &pending = m_pending[it->second];
+        pending.cmd_status = record.cmd_status;
+        pending.last_ms = record.last_ms;
+        pending.repeat_count += record.repeat_count;
+    }
+}
+
+size_t notification_coalescer::flush(std::vector<notification_record> &records)
+{
+    uint64_t now = now_ms();
+    return flush_before(now > m_window_ms ? now - m_window_ms : 0, records);
+}
+
+size_t notification_coalescer::flush_all(std::vector<notification_record> &records)
+{
+    return flush_before(std::numeric_limits<uint64_t>::max(), records);
+}
+
+size_t notification_coalescer::flush_before(uint64_t deadline_ms, std::vector<notification_record> &records)
+{
+    size_t delivered = 0;
+
+    std::lock_guard<std::mutex> guard(m_lock);
+    if(m_pending.empty())
+        return 0;
+
+    // Records are appended when first seen, so first_ms never decreases along
+    // m_pending and the expired records are always a prefix.
+    size_t keep_from = 0;
+    while(keep_from < m_pending.size() && m_pending[keep_from].first_ms <= deadline_ms)
+    {
+        records.push_back(m_pending[keep_from]);
+        keep_from++;
+        delivered++;
+    }
+
+    if(delivered)
+    {
+        m_pending.erase(m_pending.begin(), m_pending.begin() + keep_from);
+        m_index.clear();
+        for(size_t i = 0; i < m_pending.size(); i++)
+        {
+            const notification_record &r = m_pending[i];
+            record_key key = {r.notification_type, r.entity_id, r.cmd_type,
+                              r.desc_type, r.desc_index, r.notification_id, r.interface_num};
+            m_index.insert(std::make_pair(key, i));
+        }
+        m_delivered_count += delivered;
+    }
+
+    return delivered;
+}
+
+uint64_t notification_coalescer::get_posted_count()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_posted_count;
+}
+
+uint64_t notification_coalescer::get_delivered_count()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_delivered_count;
+}
@@ -0,0 +1,70 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * pending_command_table.cpp
+ *
+ */
+
+#include "pending_command_table.h"
+
+pending_command_table::pending_command_table() {}
+
+pending_command_table::~pending_command_table() {}
+
+void pending_command_table::add(void *notification_id, const completion &on_complete)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    m_pending[notification_id] = on_complete;
+}
+
+bool pending_command_table::complete(const notification_record &record)
+{
+    completion on_complete;
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        std::unordered_map<void *, completion>::iterator it = m_pending.find(record.notification_id);
+        if(it == m_pending.end())
+            return false;
+
+        on_complete.swap(it->second);
+        m_pending.erase(it);
+    }
+
+    // run outside the lock so a completion can issue the next command
+    if(on_complete)
+        on_complete(record);
+    return true;
+}
+
+bool pending_command_table::cancel(void *notification_id)
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_pending.erase(notification_id) != 0;
+}
+
+size_t pending_command_table::size()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_pending.size();
+}
@@ -0,0 +1,287 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * rollout_panel.cpp
+ *
+ */
+
+#include <algorithm>
+#include "wx/sizer.h"
+#include "rollout_panel.h"
+
+rollout_dialog::rollout_dialog(wxWindow *parent, const std::vector<rollout_candidate> &candidates)
+: wxDialog(parent, wxID_ANY, wxT("Firmware Rollout")), m_candidates(candidates)
+{
+    for(size_t i = 0; i < m_candidates.size(); i++)
+    {
+        if(std::find(m_models.begin(), m_models.end(), m_candidates[i].entity_model_id) == m_models.end())
+            m_models.push_back(m_candidates[i].entity_model_id);
+    }
+    std::sort(m_models.begin(), m_models.end());
+
+    rollout_options defaults;
+    m_model = new wxChoice(this, wxID_ANY);
+    for(size_t i = 0; i < m_models.size(); i++)
+    {
+        m_model->Append(wxString::Format("0x%llx", (unsigned long long)m_models[i]));
+    }
+    m_version = new wxChoice(this, wxID_ANY);
+    m_selection = new wxStaticText(this, wxID_ANY, wxEmptyString);
+    m_image = new wxFilePickerCtrl(this, wxID_ANY, wxEmptyString, wxT("Firmware image"),
+                                   wxT("Firmware images (*.bin)|*.bin|All files (*.*)|*.*"),
+                                   wxDefaultPosition, wxSize(300, -1), wxFLP_OPEN | wxFLP_FILE_MUST_EXIST | wxFLP_USE_TEXTCTRL);
+    m_target_version = new wxTextCtrl(this, wxID_ANY);
+    m_parallelism = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(80, -1),
+                                   wxSP_ARROW_KEYS, 1, 256, defaults.parallelism);
+    m_first_wave = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(80, -1),
+                                  wxSP_ARROW_KEYS, 0, 10000, defaults.first_wave_size);
+    m_wave_size = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(80, -1),
+                                 wxSP_ARROW_KEYS, 0, 10000, defaults.wave_size);
+    m_max_failures = new wxSpinCtrl(this, wxID_ANY, wxEmptyString, wxDefaultPosition, wxSize(80, -1),
+                                    wxSP_ARROW_KEYS, 0, 10000, defaults.max_failures);
+
+    wxFlexGridSizer *grid = new wxFlexGridSizer(2, 5, 10);
+    grid->Add(new wxStaticText(this, wxID_ANY, wxT("Entity model:")), 0, wxALIGN_CENTER_VERTICAL);
+    grid->Add(m_model, 0, wxGROW);
+    grid->Add(new wxStaticText(this, wxID_ANY, wxT("Current firmware:")), 0, wxALIGN_CENTER_VERTICAL);
+    grid->Add(m_version, 0, wxGROW);
+    grid->AddSpacer(0);
+    grid->Add(m_selection, 0, wxGROW);
+    grid->Add(new wxStaticText(this, wxID_ANY, wxT("Image:")), 0, wxALIGN_CENTER_VERTICAL);
+    grid->Add(m_image, 0, wxGROW);
+    grid->Add(new wxStaticText(this, wxID_ANY, wxT("New firmware version:")), 0, wxALIGN_CENTER_VERTICAL);
+    grid->Add(m_target_version, 0, wxGROW);
+    grid->Add(new wxStaticText(this, wxID_ANY, wxT("Parallel uploads:")), 0, wxALIGN_CENTER_VERTICAL);
+    grid->Add(m_parallelism);
+    grid->Add(new wxStaticText(this, wxID_ANY, wxT("First wave size:")), 0, wxALIGN_CENTER_VERTICAL);
+    grid->Add(m_first_wave);
+    grid->Add(new wxStaticText(this, wxID_ANY, wxT("Wave size (0 = all):")), 0, wxALIGN_CENTER_VERTICAL);
+    grid->Add(m_wave_size);
+    grid->Add(new wxStaticText(this, wxID_ANY, wxT("Failures before halting:")), 0, wxALIGN_CENTER_VERTICAL);
+    grid->Add(m_max_failures);
+    grid->AddGrowableCol(1);
+
+    wxBoxSizer *sizer = new wxBoxSizer(wxVERTICAL);
+    sizer->Add(grid, 1, wxGROW | wxALL, 10);
+    sizer->Add(CreateButtonSizer(wxOK | wxCANCEL), 0, wxGROW | wxALL, 10);
+    SetSizerAndFit(sizer);
+
+    m_model->Bind(wxEVT_CHOICE, &rollout_dialog::OnModel, this);
+    m_version->Bind(wxEVT_CHOICE, &rollout_dialog::OnVersion, this);
+
+    if(!m_models.empty())
+        m_model->SetSelection(0);
+    update_versions();
+}
+
+rollout_dialog::~rollout_dialog() {}
+
+void rollout_dialog::update_versions()
+{
+    m_version->Clear();
+    m_version->Append(wxT("Any version"));
+
+    int model = m_model->GetSelection();
+    if(model != wxNOT_FOUND)
+    {
+        for(size_t i = 0; i < m_candidates.size(); i++)
+        {
+            if(m_candidates[i].entity_model_id == m_models[model] &&
+               m_version->FindString(m_candidates[i].firmware_version, true) == wxNOT_FOUND)
+                m_version->Append(m_candidates[i].firmware_version);
+        }
+    }
+    m_version->SetSelection(0);
+    update_selection();
+}
+
+void rollout_dialog::update_selection()
+{
+    std::vector<uint64_t> targets;
+    get_targets(targets);
+    m_selection->SetLabel(wxString::Format(wxT("%u end stations selected"), (unsigned int)targets.size()));
+}
+
+void rollout_dialog::get_targets(std::vector<uint64_t> &targets) const
+{
+    targets.clear();
+    int model = m_model->GetSelection();
+    if(model == wxNOT_FOUND)
+        return;
+
+    wxString version = m_version->GetSelection() > 0 ? m_version->GetStringSelection() : wxString();
+    for(size_t i = 0; i < m_candidates.size(); i++)
+    {
+        if(m_candidates[i].entity_model_id == m_models[model] &&
+           (version.IsEmpty() || m_candidates[i].firmware_version == version))
+            targets.push_back(m_candidates[i].entity_id);
+    }
+}
+
+wxString rollout_dialog::get_image_path() const
+{
+    return m_image->GetPath();
+}
+
+wxString rollout_dialog::get_target_version() const
+{
+    return m_target_version->GetValue().Trim().Trim(false);
+}
+
+void rollout_dialog::get_options(rollout_options &options) const
+{
+    options.parallelism = m_parallelism->GetValue();
+    options.first_wave_size = m_first_wave->GetValue();
+    options.wave_size = m_wave_size->GetValue();
+    options.max_failures = m_max_failures->GetValue();
+}
+
+void rollout_dialog::OnModel(wxCommandEvent& WXUNUSED(event))
+{
+    update_versions();
+}
+
+void rollout_dialog::OnVersion(wxCommandEvent& WXUNUSED(event))
+{
+    update_selection();
+}
+
+rollout_list::rollout_list(wxWindow *parent, const firmware_rollout *rollout)
+: wxListCtrl(parent, wxID_ANY, wxDefaultPosition, wxDefaultSize, wxLC_REPORT | wxLC_VIRTUAL | wxLC_HRULES)
+{
+    m_rollout = rollout;
+
+    InsertColumn(0, wxT("Entity ID"), wxLIST_FORMAT_LEFT, 150);
+    InsertColumn(1, wxT("Name"), wxLIST_FORMAT_LEFT, 120);
+    InsertColumn(2, wxT("Wave"), wxLIST_FORMAT_RIGHT, 50);
+    InsertColumn(3, wxT("Stage"), wxLIST_FORMAT_LEFT, 80);
+    InsertColumn(4, wxT("Progress"), wxLIST_FORMAT_RIGHT, 120);
+    InsertColumn(5, wxT("Firmware Version"), wxLIST_FORMAT_LEFT, 120);
+    InsertColumn(6, wxT("Error"), wxLIST_FORMAT_LEFT, 250);
+}
+
+rollout_list::~rollout_list() {}
+
+void rollout_list::set_formatter(const name_formatter &format_name)
+{
+    m_format_name = format_name;
+}
+
+wxString rollout_list::OnGetItemText(long item, long column) const
+{
+    if(item < 0 || (size_t)item >= m_rollout->get_device_count())
+        return wxEmptyString;
+
+    const rollout_device &device = m_rollout->get_device(item);
+    switch(column)
+    {
+        case 0:
+            return wxString::Format("0x%llx", (unsigned long long)device.entity_id);
+        case 1:
+            return m_format_name ? m_format_name(device.entity_id) : wxString();
+        case 2:
+            return wxString::Format("%u", device.wave + 1);
+        case 3:
+            return firmware_rollout::stage_name(device.stage);
+        case 4:
+            if(device.upload && device.upload->get_size())
+                return wxString::Format("%.0f%% %.2f MB/s",
+                                        100.0 * device.upload->get_acked_bytes() / device.upload->get_size(),
+                                        device.upload->get_throughput() / (1024 * 1024));
+            return wxEmptyString;
+        case 5:
+            return wxString::FromUTF8(device.version.c_str());
+        case 6:
+            return wxString::FromUTF8(device.error.c_str());
+    }
+    return wxEmptyString;
+}
+
+rollout_panel::rollout_panel(wxWindow *parent, const firmware_rollout *rollout)
+: wxPanel(parent, wxID_ANY)
+{
+    m_rollout = rollout;
+    m_start = new wxButton(this, wxID_ANY, wxT("Start Rollout..."));
+    m_abort = new wxButton(this, wxID_ANY, wxT("Abort"));
+    m_abort->Disable();
+    m_status = new wxStaticText(this, wxID_ANY, wxEmptyString);
+    m_list = new rollout_list(this, rollout);
+
+    wxBoxSizer *header_sizer = new wxBoxSizer(wxHORIZONTAL);
+    header_sizer->Add(m_start, 0, wxALIGN_CENTER_VERTICAL);
+    header_sizer->Add(m_abort, 0, wxALIGN_CENTER_VERTICAL | wxLEFT, 5);
+    header_sizer->Add(m_status, 1, wxALIGN_CENTER_VERTICAL | wxLEFT, 10);
+
+    wxBoxSizer *sizer = new wxBoxSizer(wxVERTICAL);
+    sizer->Add(header_sizer, 0, wxGROW);
+    sizer->Add(m_list, 1, wxGROW);
+    SetSizer(sizer);
+
+    m_start->Bind(wxEVT_BUTTON, &rollout_panel::OnStart, this);
+    m_abort->Bind(wxEVT_BUTTON, &rollout_panel::OnAbort, this);
+}
+
+rollout_panel::~rollout_panel() {}
+
+void rollout_panel::set_handlers(const action_handler &on_start, const action_handler &on_abort)
+{
+    m_on_start = on_start;
+    m_on_abort = on_abort;
+}
+
+void rollout_panel::set_formatter(const rollout_list::name_formatter &format_name)
+{
+    m_list->set_formatter(format_name);
+}
+
+void rollout_panel::refresh_devices()
+{
+    m_start->Enable(!m_rollout->is_running());
+    m_abort->Enable(m_rollout->is_running());
+    m_list->SetItemCount(m_rollout->get_device_count());
+    m_list->Refresh();
+}
+
+void rollout_panel::refresh_device(size_t index)
+{
+    if(index < m_rollout->get_device_count())
+        m_list->RefreshItem(index);
+}
+
+void rollout_panel::set_status(const wxString &status)
+{
+    m_status->SetLabel(status);
+}
+
+void rollout_panel::OnStart(wxCommandEvent& WXUNUSED(event))
+{
+    if(m_on_start)
+        m_on_start();
+}
+
+void rollout_panel::OnAbort(wxCommandEvent& WXUNUSED(event))
+{
+    if(m_on_abort)
+        m_on_abort();
+}
@@ -0,0 +1,93 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * stream_format.cpp
+ *
+ */
+
+#include "stream_format.h"
+
+unsigned int stream_format_channel_count(uint64_t format_value)
+{
+    uint64_t value = format_value << 44;
+    value = value >> 52;
+
+    if(value == 1) //channel count 1
+    {
+        return 1;
+    }
+    else if(value == 2) //channel count 2
+    {
+        return 2;
+    }
+    return 8; //channel count 8
+}
+
+unsigned int stream_format_index(unsigned int channel_count, uint32_t sampling_rate)
+{
+    switch(channel_count)
+    {
+        case 1:
+            if(sampling_rate == 48000)
+            {
+                return 0;
+            }
+            else
+            {
+                return 4;
+            }
+            break;
+        case 2:
+            if(sampling_rate == 48000)
+            {
+                return 1;
+            }
+            else
+            {
+                return 5;
+            }
+            break;
+        case 4:
+            if(sampling_rate == 48000)
+            {
+                return 2;
+            }
+            else
+            {
+                return 6;
+            }
+            break;
+        case 8:
+            if(sampling_rate == 48000)
+            {
+                return 3;
+            }
+            else
+            {
+                return 7;
+            }
+            break;
+    }
+    return -1; //not found
+}
@@ -0,0 +1,105 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * string_pool.cpp
+ *
+ */
+
+#include <string.h>
+#include "string_pool.h"
+#include "console_log.h"
+
+std::mutex string_pool::m_lock;
+std::unordered_map<std::string, string_pool::handle> string_pool::m_index;
+wxString **string_pool::m_directories[string_pool::max_directories] = { first_directory() };
+string_pool::handle string_pool::m_next = 1; // handle 0 is the empty string
+
+wxString ** string_pool::first_directory()
+{
+    wxString **directory = new wxString *[directory_size]();
+    directory[0] = new wxString[chunk_size];
+    return directory;
+}
+
+string_pool::handle string_pool::intern(const char *utf8)
+{
+    if(!utf8 || utf8[0] == '\0')
+        return 0;
+
+    std::string key(utf8);
+    std::lock_guard<std::mutex> guard(m_lock);
+    std::unordered_map<std::string, handle>::const_iterator it = m_index.find(key);
+    if(it != m_index.end())
+        return it->second;
+
+    return intern_locked(key, wxString::FromUTF8(utf8));
+}
+
+string_pool::handle string_pool::intern(const wxString &str)
+{
+    if(str.empty())
+        return 0;
+
+    std::string key((const char *)str.utf8_str());
+    std::lock_guard<std::mutex> guard(m_lock);
+    std::unordered_map<std::string, handle>::const_iterator it = m_index.find(key);
+    if(it != m_index.end())
+        return it->second;
+
+    return intern_locked(key, str);
+}
+
+string_pool::handle string_pool::intern_locked(const std::string &key, const wxString &str)
+{
+    handle h = m_next;
+    if(h == 0)
+    {
+        // every 32-bit handle is in use; only reachable after billions of distinct names
+        console_log::line("string_pool: handles exhausted, \"%s\" is shown empty", key.c_str());
+        return 0;
+    }
+
+    wxString **directory = m_directories[h >> directory_shift];
+    if(!directory)
+    {
+        directory = new wxString *[directory_size]();
+        m_directories[h >> directory_shift] = directory;
+    }
+    wxString *&chunk = directory[(h >> chunk_bits) & (directory_size - 1)];
+    if(!chunk)
+    {
+        chunk = new wxString[chunk_size];
+    }
+
+    chunk[h & (chunk_size - 1)] = str;
+    m_index.insert(std::make_pair(key, h));
+    m_next++;
+    return h;
+}
+
+size_t string_pool::size()
+{
+    std::lock_guard<std::mutex> guard(m_lock);
+    return m_index.size();
+}
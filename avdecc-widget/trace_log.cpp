@@ -0,0 +1,264 @@
+/*
+ * Licensed under the MIT License (MIT)
+ *
+ * Copyright (c) 2015 AudioScience Inc.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * trace_log.cpp
+ *
+ */
+
+#include <chrono>
+#include <mutex>
+#include <stdio.h>
+#include <inttypes.h>
+#include "trace_log.h"
+
+namespace
+{
+    struct trace_record
+    {
+        const char *category;
+        const char *name;
+        uint64_t ts_us;
+        uint64_t dur_us;
+        uint64_t arg;
+        char phase;
+    };
+
+    /*
+     * Each thread owns a fixed ring it appends to without locking. The
+     * writer consumes everything below the published end and moves begin up
+     * past it, which frees the slots again; a thread whose ring is full
+     * drops records and counts them instead of growing. Buffers live until
+     * process exit so a thread that has finished can still be written out.
+     */
+    const size_t records_per_thread = 1 << 15;
+
+    struct thread_buffer
+    {
+        uint32_t tid;
+        std::atomic<const char *> name;
+        trace_record *records;
+        std::atomic<uint64_t> begin;
+        std::atomic<uint64_t> end;
+        std::atomic<uint64_t> dropped;
+        thread_buffer *next;
+    };
+
+    std::mutex registry_lock;
+    std::mutex write_lock;
+    thread_buffer *registry_head = NULL;
+    uint32_t next_tid = 1;
+    std::string trace_output_path;
+    const std::chrono::steady_clock::time_point trace_epoch = std::chrono::steady_clock::now();
+
+    thread_local thread_buffer *local_buffer = NULL;
+
+    thread_buffer * get_local_buffer()
+    {
+        if(!local_buffer)
+        {
+            thread_buffer *buffer = new thread_buffer;
+            buffer->name.store(NULL, std::memory_order_relaxed);
+            buffer->records = new trace_record[records_per_thread];
+            buffer->begin.store(0, std::memory_order_relaxed);
+            buffer->end.store(0, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+
+            std::lock_guard<std::mutex> guard(registry_lock);
+            buffer->tid = next_tid++;
+            buffer->next = registry_head;
+            registry_head = buffer;
+            local_buffer = buffer;
+        }
+        return local_buffer;
+    }
+
+    void append(const trace_record &record)
+    {
+        thread_buffer *buffer = get_local_buffer();
+        uint64_t n = buffer->end.load(std::memory_order_relaxed);
+
+        if(n - buffer->begin.load(std::memory_order_acquire) >= records_per_thread)
+        {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        buffer->records[n % records_per_thread] = record;
+        buffer->end.store(n + 1, std::memory_order_release);
+    }
+
+    thread_buffer * get_buffers()
+    {
+        std::lock_guard<std::mutex> guard(registry_lock);
+        return registry_head;
+    }
+
+    /*
+     * Called with write_lock held; the writer is the only thread that
+     * moves begin.
+     */
+    void clear_buffers()
+    {
+        for(thread_buffer *buffer = get_buffers(); buffer; buffer = buffer->next)
+        {
+            buffer->begin.store(buffer->end.load(std::memory_order_acquire), std::memory_order_release);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void write_json_string(FILE *fp, const char *s)
+    {
+        fputc('"', fp);
+        for(; s && *s; s++)
+        {
+            if(*s == '"' || *s == '\\')
+                fputc('\\', fp);
+            if((unsigned char)*s >= 0x20)
+                fputc(*s, fp);
+        }
+        fputc('"', fp);
+    }
+}
+
+std::atomic<bool> trace_log::m_enabled(false);
+
+void trace_log::enable(const std::string &output_path)
+{
+    {
+        std::lock_guard<std::mutex> guard(write_lock);
+        trace_output_path = output_path;
+    }
+    m_enabled.store(true, std::memory_order_relaxed);
+}
+
+void trace_log::disable()
+{
+    m_enabled.store(false, std::memory_order_relaxed);
+
+    std::lock_guard<std::mutex> guard(write_lock);
+    clear_buffers();
+}
+
+std::string trace_log::output_path()
+{
+    std::lock_guard<std::mutex> guard(write_lock);
+    return trace_output_path;
+}
+
+uint64_t trace_log::now_us()
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - trace_epoch).count();
+}
+
+void trace_log::set_thread_name(const char *name)
+{
+    if(enabled())
+        get_local_buffer()->name.store(name, std::memory_order_relaxed);
+}
+
+void trace_log::record_complete(const char *category, const char *name,
+                                uint64_t start_us, uint64_t duration_us, uint64_t arg)
+{
+    trace_record record = {category, name, start_us, duration_us, arg, 'X'};
+    append(record);
+}
+
+void trace_log::record_instant(const char *category, const char *name, uint64_t arg)
+{
+    if(!enabled())
+        return;
+
+    trace_record record = {category, name, now_us(), 0, arg, 'i'};
+    append(record);
+}
+
+int trace_log::write()
+{
+    std::string path;
+    {
+        std::lock_guard<std::mutex> guard(write_lock);
+        path = trace_output_path;
+    }
+    if(path.empty())
+        return -1;
+
+    return write(path);
+}
+
+int trace_log::write(const std::string &path)
+{
+    std::lock_guard<std::mutex> guard(write_lock);
+
+    FILE *fp = fopen(path.c_str(), "w");
+    if(!fp)
+        return -1;
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(fp, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"avdecc-widget\"}}");
+
+    for(thread_buffer *buffer = get_buffers(); buffer; buffer = buffer->next)
+    {
+        const char *thread_name = buffer->name.load(std::memory_order_relaxed);
+        if(thread_name)
+        {
+            fprintf(fp, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", buffer->tid);
+            write_json_string(fp, thread_name);
+            fprintf(fp, "}}");
+        }
+
+        uint64_t begin = buffer->begin.load(std::memory_order_relaxed);
+        uint64_t end = buffer->end.load(std::memory_order_acquire);
+        for(uint64_t i = begin; i < end; i++)
+        {
+            const trace_record &r = buffer->records[i % records_per_thread];
+            fprintf(fp, ",\n{\"name\":");
+            write_json_string(fp, r.name);
+            fprintf(fp, ",\"cat\":");
+            write_json_string(fp, r.category);
+            if(r.phase == 'X')
+            {
+                fprintf(fp, ",\"ph\":\"X\",\"ts\":%" PRIu64 ",\"dur\":%" PRIu64, r.ts_us, r.dur_us);
+            }
+            else
+            {
+                fprintf(fp, ",\"ph\":\"i\",\"s\":\"t\",\"ts\":%" PRIu64, r.ts_us);
+            }
+            fprintf(fp, ",\"pid\":1,\"tid\":%u,\"args\":{\"id\":\"0x%" PRIx64 "\"}}", buffer->tid, r.arg);
+        }
+
+        uint64_t dropped = buffer->dropped.exchange(0, std::memory_order_relaxed);
+        if(dropped)
+        {
+            fprintf(fp, ",\n{\"name\":\"records dropped\",\"cat\":\"trace\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%" PRIu64
+                        ",\"pid\":1,\"tid\":%u,\"args\":{\"count\":%" PRIu64 "}}", trace_log::now_us(), buffer->tid, dropped);
+        }
+
+        // written records are released so the buffer starts over
+        buffer->begin.store(end, std::memory_order_release);
+    }
+
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    return 0;
+}